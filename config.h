@@ -0,0 +1,490 @@
+/* config.h.  Generated from config.h.in by configure.  */
+/* config.h.in.  Generated from configure.ac by autoheader.  */
+
+/* Define to the __printf__ attribute if present */
+#define ATTRIBUTE_PRINTF(x,y) __attribute__((__format__(__printf__, x, y)))
+
+/* Define to 1 if connect() uses struct sockaddr. */
+#define CONNECT_USES_STRUCT_SOCKADDR 1
+
+/* Define to a macro for accessing an fpos64_t variable */
+#define FPOS64_CAST(x) (x).__pos
+
+/* Define to 1 if you have the `accept' function. */
+#define HAVE_ACCEPT 1
+
+/* Define to 1 if you have the <aio.h> header file. */
+#define HAVE_AIO_H 1
+
+/* Define to 1 if you have the `aio_read' function. */
+#define HAVE_AIO_READ 1
+
+/* Define to 1 if you have the `AllocConsole' function. */
+/* #undef HAVE_ALLOCCONSOLE */
+
+/* Define to 1 if you have the <arm_acle.h> header file. */
+/* #undef HAVE_ARM_ACLE_H */
+
+/* Define to 1 if you have the <arpa/inet.h> header file. */
+#define HAVE_ARPA_INET_H 1
+
+/* Define to 1 if you have the `AttachConsole' function. */
+/* #undef HAVE_ATTACHCONSOLE */
+
+/* Define to 1 if you have the `backtrace' function. */
+#define HAVE_BACKTRACE 1
+
+/* Define to 1 if you have the `bind' function. */
+#define HAVE_BIND 1
+
+/* Define to 1 if you have the `CloseHandle' function. */
+/* #undef HAVE_CLOSEHANDLE */
+
+/* Define to 1 if you have the `connect' function. */
+#define HAVE_CONNECT 1
+
+/* Define to 1 if you have the <cpuid.h> header file. */
+#define HAVE_CPUID_H 1
+
+/* Define to 1 if you have the `CreateFileA' function. */
+/* #undef HAVE_CREATEFILEA */
+
+/* Define to 1 if you have the `CreateFileW' function. */
+/* #undef HAVE_CREATEFILEW */
+
+/* Define to 1 if you have the `dladdr' function. */
+#define HAVE_DLADDR 1
+
+/* Define to 1 if you have the <dlfcn.h> header file. */
+#define HAVE_DLFCN_H 1
+
+/* Define to 1 if you have the `dup' function. */
+#define HAVE_DUP 1
+
+/* Define to 1 if you have the `dup2' function. */
+#define HAVE_DUP2 1
+
+/* Define to 1 if you have the <endian.h> header file. */
+#define HAVE_ENDIAN_H 1
+
+/* Define to 1 if you have the `epoll_create1' function. */
+#define HAVE_EPOLL_CREATE1 1
+
+/* Define to 1 if you have the <execinfo.h> header file. */
+#define HAVE_EXECINFO_H 1
+
+/* Define to 1 if you have the `fgetc_unlocked' function. */
+#define HAVE_FGETC_UNLOCKED 1
+
+/* Define to 1 if you have the `fgetln' function. */
+/* #undef HAVE_FGETLN */
+
+/* Define to 1 if you have the `fgets_unlocked' function. */
+#define HAVE_FGETS_UNLOCKED 1
+
+/* Define to 1 if you have the `fopen64' function. */
+#define HAVE_FOPEN64 1
+
+/* Define to 1 if you have the `fork' function. */
+#define HAVE_FORK 1
+
+/* Define to 1 if the system has the type `fpos64_t'. */
+#define HAVE_FPOS64_T 1
+
+/* Define to 1 if you have the `fread_unlocked' function. */
+#define HAVE_FREAD_UNLOCKED 1
+
+/* Define to 1 if FILE has FreeBSD-style members */
+/* #undef HAVE_FREEBSD_FILE */
+
+/* Define to 1 if you have the `freopen64' function. */
+#define HAVE_FREOPEN64 1
+
+/* Define to 1 if you have the `fseeko' function. */
+#define HAVE_FSEEKO 1
+
+/* Define to 1 if you have the `fseeko64' function. */
+#define HAVE_FSEEKO64 1
+
+/* Define to 1 if you have the `fsetpos64' function. */
+#define HAVE_FSETPOS64 1
+
+/* Define to 1 if you have the `fstat' function. */
+#define HAVE_FSTAT 1
+
+/* Define to 1 if you have the `fstat64' function. */
+#define HAVE_FSTAT64 1
+
+/* Define to 1 if you have the `ftello' function. */
+#define HAVE_FTELLO 1
+
+/* Define to 1 if you have the `ftello64' function. */
+#define HAVE_FTELLO64 1
+
+/* Define to 1 if you have the `getchar_unlocked' function. */
+#define HAVE_GETCHAR_UNLOCKED 1
+
+/* Define to 1 if you have the `getc_unlocked' function. */
+#define HAVE_GETC_UNLOCKED 1
+
+/* Define to 1 if you have the `getdelim' function. */
+#define HAVE_GETDELIM 1
+
+/* Define to 1 if you have the `getline' function. */
+#define HAVE_GETLINE 1
+
+/* Define to 1 if you have the `getloadavg' function. */
+#define HAVE_GETLOADAVG 1
+
+/* Define to 1 if you have the <getopt.h> header file. */
+#define HAVE_GETOPT_H 1
+
+/* Define to 1 if you have the `getopt_long' function. */
+#define HAVE_GETOPT_LONG 1
+
+/* Define to 1 if you have the `getpagesize' function. */
+#define HAVE_GETPAGESIZE 1
+
+/* Define to 1 if you have the `gettimeofday' function. */
+#define HAVE_GETTIMEOFDAY 1
+
+/* Define to 1 if FILE has glibc-style members */
+#define HAVE_GLIBC_FILE 1
+
+/* Define to 1 if you have the <inttypes.h> header file. */
+#define HAVE_INTTYPES_H 1
+
+/* Define to 1 if you have the <io.h> header file. */
+/* #undef HAVE_IO_H */
+
+/* Define to 1 if you have the `kill' function. */
+#define HAVE_KILL 1
+
+/* Define to 1 if you have the <libc.h> header file. */
+/* #undef HAVE_LIBC_H */
+
+/* Define to 1 if you have the `lseek64' function. */
+#define HAVE_LSEEK64 1
+
+/* Define to 1 if you have the <mach/task.h> header file. */
+/* #undef HAVE_MACH_TASK_H */
+
+/* Define to 1 if you have the <malloc.h> header file. */
+#define HAVE_MALLOC_H 1
+
+/* Define to 1 if you have the `map_fd' function. */
+/* #undef HAVE_MAP_FD */
+
+/* Define to 1 if you have the `memalign' function. */
+#define HAVE_MEMALIGN 1
+
+/* Define to 1 if you have the `mmap' function. */
+#define HAVE_MMAP 1
+
+/* Define to 1 if you have the `mmap64' function. */
+#define HAVE_MMAP64 1
+
+/* Define to 1 if you have the <netinet/in.h> header file. */
+#define HAVE_NETINET_IN_H 1
+
+/* Define to 1 if you have the `open64' function. */
+#define HAVE_OPEN64 1
+
+/* Define to 1 if you have the `pidfd_open' function. */
+#define HAVE_PIDFD_OPEN 1
+
+/* Define to 1 if you have the `pipe' function. */
+#define HAVE_PIPE 1
+
+/* Define to 1 if you have the `posix_memalign' function. */
+#define HAVE_POSIX_MEMALIGN 1
+
+/* Define to 1 if you have pragma INIT */
+#define HAVE_PRAGMA_INIT 1
+
+/* Define to 1 if you have the `pread' function. */
+#define HAVE_PREAD 1
+
+/* Define to 1 if you have the `pread64' function. */
+#define HAVE_PREAD64 1
+
+/* Define to 1 if you have the <process.h> header file. */
+/* #undef HAVE_PROCESS_H */
+
+/* Define to 1 if you have the <pthread.h> header file. */
+#define HAVE_PTHREAD_H 1
+
+/* Define to 1 if you have the `ReadFile' function. */
+/* #undef HAVE_READFILE */
+
+/* Define to 1 if you have the `readv' function. */
+#define HAVE_READV 1
+
+/* Define to 1 if you have the `recv' function. */
+#define HAVE_RECV 1
+
+/* Define to 1 if you have the `recvfrom' function. */
+#define HAVE_RECVFROM 1
+
+/* Define to 1 if you have the `recvmsg' function. */
+#define HAVE_RECVMSG 1
+
+/* Define to 1 if you have the `regexec' function. */
+#define HAVE_REGEXEC 1
+
+/* Define to 1 if you have the <regex.h> header file. */
+#define HAVE_REGEX_H 1
+
+/* Define to 1 if you have the `regwexec' function. */
+/* #undef HAVE_REGWEXEC */
+
+/* Define to 1 if you have the `ReOpenFile' function. */
+/* #undef HAVE_REOPENFILE */
+
+/* Define to 1 if you have the `sched_getaffinity' function. */
+#define HAVE_SCHED_GETAFFINITY 1
+
+/* Define to 1 if you have the <sched.h> header file. */
+#define HAVE_SCHED_H 1
+
+/* Define to 1 if you have the `sched_setaffinity' function. */
+#define HAVE_SCHED_SETAFFINITY 1
+
+/* Define to 1 if you have the `SetConsoleMode' function. */
+/* #undef HAVE_SETCONSOLEMODE */
+
+/* Define to 1 if you have the `setenv' function. */
+#define HAVE_SETENV 1
+
+/* Define to 1 if you have the `setrlimit' function. */
+#define HAVE_SETRLIMIT 1
+
+/* Define to 1 if you have the `sigaction' function. */
+#define HAVE_SIGACTION 1
+
+/* Define to 1 if you have the `sigaltstack' function. */
+#define HAVE_SIGALTSTACK 1
+
+/* Define to 1 if the system has the type `sighandler_t'. */
+#define HAVE_SIGHANDLER_T 1
+
+/* Define to 1 if the system has the type `sig_t'. */
+/* #undef HAVE_SIG_T */
+
+/* Define to 1 if you have the <smmintrin.h> header file. */
+#define HAVE_SMMINTRIN_H 1
+
+/* Define to 1 if you have the `socket' function. */
+#define HAVE_SOCKET 1
+
+/* Define to 1 if the system has the type `socklen_t'. */
+#define HAVE_SOCKLEN_T 1
+
+/* Define to 1 if FILE has Solaris-style members */
+/* #undef HAVE_SOLARIS_FILE */
+
+/* Define to 1 if you have the <stdint.h> header file. */
+#define HAVE_STDINT_H 1
+
+/* Define to 1 if you have the <stdio.h> header file. */
+#define HAVE_STDIO_H 1
+
+/* Define to 1 if you have the <stdlib.h> header file. */
+#define HAVE_STDLIB_H 1
+
+/* Define to 1 if you have the <strings.h> header file. */
+#define HAVE_STRINGS_H 1
+
+/* Define to 1 if you have the <string.h> header file. */
+#define HAVE_STRING_H 1
+
+/* Define to 1 if you have the <sys/cdefs.h> header file. */
+#define HAVE_SYS_CDEFS_H 1
+
+/* Define to 1 if you have the <sys/epoll.h> header file. */
+#define HAVE_SYS_EPOLL_H 1
+
+/* Define to 1 if you have the <sys/mman.h> header file. */
+#define HAVE_SYS_MMAN_H 1
+
+/* Define to 1 if you have the <sys/pidfd.h> header file. */
+#define HAVE_SYS_PIDFD_H 1
+
+/* Define to 1 if you have the <sys/prctl.h> header file. */
+#define HAVE_SYS_PRCTL_H 1
+
+/* Define to 1 if you have the <sys/resource.h> header file. */
+#define HAVE_SYS_RESOURCE_H 1
+
+/* Define to 1 if you have the <sys/socket.h> header file. */
+#define HAVE_SYS_SOCKET_H 1
+
+/* Define to 1 if you have the <sys/stat.h> header file. */
+#define HAVE_SYS_STAT_H 1
+
+/* Define to 1 if you have the <sys/syscall.h> header file. */
+#define HAVE_SYS_SYSCALL_H 1
+
+/* Define to 1 if you have the <sys/timerfd.h> header file. */
+#define HAVE_SYS_TIMERFD_H 1
+
+/* Define to 1 if you have the <sys/time.h> header file. */
+#define HAVE_SYS_TIME_H 1
+
+/* Define to 1 if you have the <sys/types.h> header file. */
+#define HAVE_SYS_TYPES_H 1
+
+/* Define to 1 if you have the <sys/uio.h> header file. */
+#define HAVE_SYS_UIO_H 1
+
+/* Define to 1 if you have the <sys/wait.h> header file. */
+#define HAVE_SYS_WAIT_H 1
+
+/* Define to 1 if you have the `timerfd_create' function. */
+#define HAVE_TIMERFD_CREATE 1
+
+/* Define to 1 if you have the <ucontext.h> header file. */
+#define HAVE_UCONTEXT_H 1
+
+/* Define to 1 if you have the <unistd.h> header file. */
+#define HAVE_UNISTD_H 1
+
+/* Define to 1 if you have the `valloc' function. */
+#define HAVE_VALLOC 1
+
+/* Define to 1 if you have the `waitpid' function. */
+#define HAVE_WAITPID 1
+
+/* Define to 1 if you have the <windows.h> header file. */
+/* #undef HAVE_WINDOWS_H */
+
+/* Define to 1 if you have the <winsock2.h> header file. */
+/* #undef HAVE_WINSOCK2_H */
+
+/* Define to 1 if you have the <wmmintrin.h> header file. */
+#define HAVE_WMMINTRIN_H 1
+
+/* Define to 1 if you have the `WriteConsoleOutputA' function. */
+/* #undef HAVE_WRITECONSOLEOUTPUTA */
+
+/* Define to 1 if you have the `WriteConsoleOutputW' function. */
+/* #undef HAVE_WRITECONSOLEOUTPUTW */
+
+/* Define to 1 if you have the <zlib.h> header file. */
+#define HAVE_ZLIB_H 1
+
+/* Define to 1 if you have the `_IO_getc' function. */
+#define HAVE__IO_GETC 1
+
+/* Define to 1 if you have the `_pipe' function. */
+/* #undef HAVE__PIPE */
+
+/* Define to 1 if you have the `__fgets_chk' function. */
+#define HAVE___FGETS_CHK 1
+
+/* Define to 1 if you have the `__fgets_unlocked_chk' function. */
+#define HAVE___FGETS_UNLOCKED_CHK 1
+
+/* Define to 1 if you have the `__filbuf' function. */
+/* #undef HAVE___FILBUF */
+
+/* Define to 1 if you have the `__fopen64' function. */
+/* #undef HAVE___FOPEN64 */
+
+/* Define to 1 if you have the `__fread_chk' function. */
+#define HAVE___FREAD_CHK 1
+
+/* Define to 1 if you have the `__fread_unlocked_chk' function. */
+#define HAVE___FREAD_UNLOCKED_CHK 1
+
+/* Define to 1 if you have the `__freopen64' function. */
+/* #undef HAVE___FREOPEN64 */
+
+/* Define to 1 if you have the `__fseeko64' function. */
+#define HAVE___FSEEKO64 1
+
+/* Define to 1 if you have the `__fsetpos64' function. */
+/* #undef HAVE___FSETPOS64 */
+
+/* Define to 1 if you have the `__ftello64' function. */
+#define HAVE___FTELLO64 1
+
+/* Define to 1 if you have the `__fxstat' function. */
+#define HAVE___FXSTAT 1
+
+/* Define to 1 if you have the `__fxstat64' function. */
+#define HAVE___FXSTAT64 1
+
+/* Define to 1 if you have the `__getdelim' function. */
+#define HAVE___GETDELIM 1
+
+/* Define to 1 if you have the `__lseek64' function. */
+/* #undef HAVE___LSEEK64 */
+
+/* Define to 1 if you have the `__open64' function. */
+#define HAVE___OPEN64 1
+
+/* Define to 1 if you have the `__read_chk' function. */
+#define HAVE___READ_CHK 1
+
+/* Define to 1 if you have the `__recvfrom_chk' function. */
+#define HAVE___RECVFROM_CHK 1
+
+/* Define to 1 if you have the `__recv_chk' function. */
+#define HAVE___RECV_CHK 1
+
+/* Define to 1 if you have the `__srefill' function. */
+/* #undef HAVE___SREFILL */
+
+/* Define to 1 if you have the `__srget' function. */
+/* #undef HAVE___SRGET */
+
+/* Define to 1 if you have the `__uflow' function. */
+#define HAVE___UFLOW 1
+
+/* Define to the sub-directory where libtool stores uninstalled libraries. */
+#define LT_OBJDIR ".libs/"
+
+/* Define to the address where bug reports for this package should be sent. */
+#define PACKAGE_BUGREPORT ""
+
+/* Define to the full name of this package. */
+#define PACKAGE_NAME "zzuf"
+
+/* Define to the full name and version of this package. */
+#define PACKAGE_STRING "zzuf 0.15"
+
+/* Define to the one symbol short name of this package. */
+#define PACKAGE_TARNAME "zzuf"
+
+/* Define to the home page for this package. */
+#define PACKAGE_URL ""
+
+/* Define to the version of this package. */
+#define PACKAGE_VERSION "0.15"
+
+/* Define to 1 if read() uses ssize_t. */
+#define READ_USES_SSIZE_T 1
+
+/* Define to the recv() return type */
+#define RECV_T ssize_t
+
+/* Define to the libzzuf full name */
+#define SONAME "libzzuf.so"
+
+/* Define to 1 if all of the C90 standard headers exist (not just the ones
+   required in a freestanding environment). This macro is provided for
+   backward compatibility; new code need not use it. */
+#define STDC_HEADERS 1
+
+/* Define the Windows version to Vista */
+/* #undef _WIN32_WINNT */
+
+/* Define to a way to access function names */
+/* #undef __func__ */
+
+/* Define to `__inline__' or `__inline' if that's what the C compiler
+   calls it, or to nothing if 'inline' is not supported under any name.  */
+#ifndef __cplusplus
+/* #undef inline */
+#endif
@@ -21,11 +21,14 @@
 /* #undef HAVE_AIO_H */
 /* #undef HAVE_AIO_READ */
 #define HAVE_ALLOCCONSOLE 1
+/* #undef HAVE_ARM_ACLE_H */
 /* #undef HAVE_ARPA_INET_H */
 #define HAVE_ATTACHCONSOLE 1
+/* #undef HAVE_BACKTRACE */
 #define HAVE_BIND 1
 #define HAVE_CLOSEHANDLE 1
 #define HAVE_CONNECT 1
+/* #undef HAVE_CPUID_H */
 #define HAVE_CREATEFILEA 1
 #define HAVE_CREATEFILEW 1
 #define HAVE_CREATEFILEMAPPINGA 1
@@ -36,6 +39,8 @@
 #define HAVE_DUP 1
 #define HAVE_DUP2 1
 /* #undef HAVE_ENDIAN_H */
+/* #undef HAVE_EPOLL_CREATE1 */
+/* #undef HAVE_EXECINFO_H */
 /* #undef HAVE_FGETC_UNLOCKED */
 /* #undef HAVE_FGETLN */
 /* #undef HAVE_FGETS_UNLOCKED */
@@ -48,12 +53,15 @@
 /* #undef HAVE_FSEEKO */
 /* #undef HAVE_FSEEKO64 */
 /* #undef HAVE_FSETPOS64 */
+/* #undef HAVE_FSTAT */
+/* #undef HAVE_FSTAT64 */
 /* #undef HAVE_FTELLO */
 /* #undef HAVE_FTELLO64 */
 /* #undef HAVE_GETCHAR_UNLOCKED */
 /* #undef HAVE_GETC_UNLOCKED */
 /* #undef HAVE_GETDELIM */
 /* #undef HAVE_GETLINE */
+/* #undef HAVE_GETLOADAVG */
 #define HAVE_CREATEIOCOMPLETIONPORT 1
 #define HAVE_GETQUEUEDCOMPLETIONSTATUS 1
 #define HAVE_GETOVERLAPPEDRESULT 1
@@ -74,11 +82,14 @@
 /* #undef HAVE_MMAP64 */
 /* #undef HAVE_NETINET_IN_H */
 /* #undef HAVE_OPEN64 */
+/* #undef HAVE_PIDFD_OPEN */
 /* #undef HAVE_PIPE */
 /* #undef HAVE_POSIX_MEMALIGN */
 /* #undef HAVE_PRAGMA_INIT */
 /* #undef HAVE_PREAD */
+/* #undef HAVE_PREAD64 */
 #define HAVE_PROCESS_H 1
+/* #undef HAVE_PTHREAD_H */
 #define HAVE_READFILE 1
 #define HAVE_READFILEEX 1
 /* #undef HAVE_READV */
@@ -89,12 +100,17 @@
 #define HAVE_REGEX_H 1
 #define HAVE_REGWEXEC 1
 #define HAVE_REOPENFILE 1
+/* #undef HAVE_SCHED_GETAFFINITY */
+/* #undef HAVE_SCHED_H */
+/* #undef HAVE_SCHED_SETAFFINITY */
 #define HAVE_SETCONSOLEMODE 1
 /* #undef HAVE_SETENV */
 /* #undef HAVE_SETRLIMIT */
 /* #undef HAVE_SIGACTION */
+/* #undef HAVE_SIGALTSTACK */
 /* #undef HAVE_SIGHANDLER_T */
 /* #undef HAVE_SIG_T */
+#define HAVE_SMMINTRIN_H 1
 #define HAVE_SOCKET 1
 /* #undef HAVE_SOCKLEN_T */
 /* #undef HAVE_SOLARIS_FILE */
@@ -103,21 +119,30 @@
 #define HAVE_STRINGS_H 1
 #define HAVE_STRING_H 1
 /* #undef HAVE_SYS_CDEFS_H */
+/* #undef HAVE_SYS_EPOLL_H */
 /* #undef HAVE_SYS_MMAN_H */
+/* #undef HAVE_SYS_PIDFD_H */
+/* #undef HAVE_SYS_PRCTL_H */
 /* #undef HAVE_SYS_RESOURCE_H */
 /* #undef HAVE_SYS_SOCKET_H */
 #define HAVE_SYS_STAT_H 1
+/* #undef HAVE_SYS_SYSCALL_H */
+/* #undef HAVE_SYS_TIMERFD_H */
 /* #undef HAVE_SYS_TIME_H */
 #define HAVE_SYS_TYPES_H 1
 /* #undef HAVE_SYS_UIO_H */
 /* #undef HAVE_SYS_WAIT_H */
+/* #undef HAVE_TIMERFD_CREATE */
+/* #undef HAVE_UCONTEXT_H */
 /* #undef HAVE_UNISTD_H */
 /* #undef HAVE_VALLOC */
 /* #undef HAVE_WAITPID */
 #define HAVE_WINDOWS_H 1
 #define HAVE_WINSOCK2_H 1
+#define HAVE_WMMINTRIN_H 1
 #define HAVE_WRITECONSOLEOUTPUTA 1
 #define HAVE_WRITECONSOLEOUTPUTW 1
+/* #undef HAVE_ZLIB_H */
 /* #undef HAVE__IO_GETC */
 #define HAVE__PIPE 1
 /* #undef HAVE___FGETS_CHK */
@@ -130,6 +155,8 @@
 /* #undef HAVE___FSEEKO64 */
 /* #undef HAVE___FSETPOS64 */
 /* #undef HAVE___FTELLO64 */
+/* #undef HAVE___FXSTAT */
+/* #undef HAVE___FXSTAT64 */
 /* #undef HAVE___GETDELIM */
 /* #undef HAVE___LSEEK64 */
 /* #undef HAVE___OPEN64 */
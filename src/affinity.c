@@ -0,0 +1,196 @@
+/*
+ *  zzuf - general purpose fuzzer
+ *
+ *  Copyright © 2002—2015 Sam Hocevar <sam@hocevar.net>
+ *
+ *  This program is free software. It comes without any warranty, to
+ *  the extent permitted by applicable law. You can redistribute it
+ *  and/or modify it under the terms of the Do What the Fuck You Want
+ *  to Public License, Version 2, as published by the WTFPL Task Force.
+ *  See http://www.wtfpl.net/ for more details.
+ */
+
+/*
+ *  affinity.c: CPU and NUMA node placement of children
+ *
+ *  Each child slot owns one CPU from the user's list. Children are pinned
+ *  to that CPU before exec, and their memory policy prefers the CPU's
+ *  NUMA node so that their pages stay local.
+ */
+
+#include "config.h"
+
+#define _GNU_SOURCE /* for sched_setaffinity() and CPU_SET() */
+
+#if defined HAVE_STDINT_H
+#   include <stdint.h>
+#elif defined HAVE_INTTYPES_H
+#   include <inttypes.h>
+#endif
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#if defined HAVE_UNISTD_H
+#   include <unistd.h>
+#endif
+#if defined HAVE_SCHED_H
+#   include <sched.h>
+#endif
+#if defined HAVE_SYS_SYSCALL_H
+#   include <sys/syscall.h>
+#endif
+
+#include "ranges.h"
+#include "affinity.h"
+
+#if defined HAVE_SCHED_SETAFFINITY && defined HAVE_SCHED_GETAFFINITY \
+     && defined CPU_SETSIZE
+#   define USE_AFFINITY 1
+#endif
+
+#if defined HAVE_SYS_SYSCALL_H && defined SYS_set_mempolicy
+#   define USE_MEMPOLICY 1
+/* From <numaif.h>, which we do not want to depend on */
+#   define ZZUF_MPOL_PREFERRED 1
+#   define MAXNODES 1024
+#endif
+
+static int get_node(int cpu);
+
+/*
+ * Build the list of CPUs children may be pinned to: those that appear in
+ * the user's list (all of them if list is NULL) and that we are currently
+ * allowed to run on. Returns
+ * the number of CPUs, which may be zero. The caller must free the arrays.
+ */
+int zz_affinity_init(char const *list, int **cpus, int **nodes)
+{
+    *cpus = *nodes = NULL;
+
+#if defined USE_AFFINITY
+    cpu_set_t allowed;
+    if (sched_getaffinity(0, sizeof(allowed), &allowed) < 0)
+        return 0;
+
+    int64_t static_ranges[512];
+    int64_t *ranges = list ? _zz_allocrange(list, static_ranges) : NULL;
+    int n = 0, numa = 0;
+
+    *cpus = malloc(CPU_SETSIZE * sizeof(int));
+    *nodes = malloc(CPU_SETSIZE * sizeof(int));
+
+    for (int cpu = 0; cpu < CPU_SETSIZE; ++cpu)
+    {
+        if (!CPU_ISSET(cpu, &allowed) || !_zz_isinrange(cpu, ranges))
+            continue;
+
+        (*cpus)[n] = cpu;
+        (*nodes)[n] = get_node(cpu);
+        if ((*nodes)[n] != (*nodes)[0])
+            numa = 1;
+        ++n;
+    }
+
+    if (ranges && ranges != static_ranges)
+        free(ranges);
+
+    /* No need to mess with memory policy on non-NUMA systems */
+    if (!numa)
+        for (int i = 0; i < n; ++i)
+            (*nodes)[i] = -1;
+
+    return n;
+#else
+    (void)list;
+    return 0;
+#endif
+}
+
+/*
+ * Called in the child before exec: stay on the given CPU and allocate
+ * memory from the given node whenever possible. A negative node means
+ * we do not care.
+ */
+void zz_affinity_apply(int cpu, int node)
+{
+#if defined USE_AFFINITY
+    if (cpu >= 0)
+    {
+        cpu_set_t set;
+        CPU_ZERO(&set);
+        CPU_SET(cpu, &set);
+        sched_setaffinity(0, sizeof(set), &set);
+    }
+#else
+    (void)cpu;
+#endif
+
+#if defined USE_MEMPOLICY
+    if (node >= 0 && node < MAXNODES)
+    {
+        /* Prefer, do not bind: running out of memory on one node must
+         * not look like a crash of the target program. */
+        unsigned long int mask[MAXNODES / (8 * sizeof(unsigned long int))];
+        int const bits = 8 * sizeof(*mask);
+        memset(mask, 0, sizeof(mask));
+        mask[node / bits] |= 1UL << (node % bits);
+        syscall(SYS_set_mempolicy, ZZUF_MPOL_PREFERRED, mask,
+                (unsigned long int)MAXNODES);
+    }
+#else
+    (void)node;
+#endif
+}
+
+/*
+ * Find the NUMA node of a CPU by scanning the per-node CPU lists in
+ * sysfs. Returns -1 if unknown.
+ */
+static int get_node(int cpu)
+{
+#if defined USE_MEMPOLICY
+    char buf[BUFSIZ];
+    FILE *fp = fopen("/sys/devices/system/node/online", "r");
+    if (!fp)
+        return -1;
+    char *online = fgets(buf, sizeof(buf), fp) ? strdup(buf) : NULL;
+    fclose(fp);
+    if (!online)
+        return -1;
+    online[strcspn(online, "\n")] = '\0';
+
+    int64_t static_nodes[512], static_cpus[512];
+    int64_t *nodes = _zz_allocrange(online, static_nodes);
+    int ret = -1;
+
+    for (int node = 0; node < MAXNODES && ret < 0; ++node)
+    {
+        if (!_zz_isinrange(node, nodes))
+            continue;
+
+        sprintf(buf, "/sys/devices/system/node/node%i/cpulist", node);
+        fp = fopen(buf, "r");
+        if (!fp)
+            continue;
+        if (fgets(buf, sizeof(buf), fp))
+        {
+            buf[strcspn(buf, "\n")] = '\0';
+            int64_t *cpus = _zz_allocrange(buf, static_cpus);
+            if (_zz_isinrange(cpu, cpus))
+                ret = node;
+            if (cpus != static_cpus)
+                free(cpus);
+        }
+        fclose(fp);
+    }
+
+    if (nodes != static_nodes)
+        free(nodes);
+    free(online);
+
+    return ret;
+#else
+    (void)cpu;
+    return -1;
+#endif
+}
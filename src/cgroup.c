@@ -0,0 +1,400 @@
+/*
+ *  zzuf - general purpose fuzzer
+ *
+ *  Copyright © 2002—2015 Sam Hocevar <sam@hocevar.net>
+ *
+ *  This program is free software. It comes without any warranty, to
+ *  the extent permitted by applicable law. You can redistribute it
+ *  and/or modify it under the terms of the Do What the Fuck You Want
+ *  to Public License, Version 2, as published by the WTFPL Task Force.
+ *  See http://www.wtfpl.net/ for more details.
+ */
+
+/*
+ *  cgroup.c: cgroup v2 resource isolation of children
+ *
+ *  We create the following hierarchy below our own cgroup, which needs
+ *  to be delegated to us (for instance using "systemd-run --user --scope
+ *  -p Delegate=yes"):
+ *
+ *    zzuf.<pid>/supervisor/   zzuf itself
+ *    zzuf.<pid>/<slot>/       children launched in slot <slot>
+ *
+ *  zzuf moves itself to a leaf because cgroup v2 does not allow enabling
+ *  controllers for the children of a cgroup that contains processes.
+ */
+
+#include "config.h"
+
+#define _DEFAULT_SOURCE
+
+#if defined HAVE_STDINT_H
+#   include <stdint.h>
+#elif defined HAVE_INTTYPES_H
+#   include <inttypes.h>
+#endif
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <signal.h>
+#include <fcntl.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+#if defined HAVE_UNISTD_H
+#   include <unistd.h>
+#endif
+
+#include "cgroup.h"
+
+#if defined __linux__
+#   define USE_CGROUP 1
+#endif
+
+/* Controllers we want for our slots */
+static char const *controllers[] = { "memory", "cpu" };
+#define NCONTROLLERS 2
+
+struct zzuf_cgroup
+{
+    char *base, *top, *supervisor, **slot;
+    int nslots, memory;
+    int enabled[2][NCONTROLLERS]; /* what we enabled in base and top */
+};
+
+#if defined USE_CGROUP
+static char *find_self(void);
+static char *make_path(char const *, char const *);
+static int write_file(char const *, char const *, char const *);
+static int read_file(char const *, char const *, char *, size_t);
+static int has_word(char const *, char const *);
+#endif
+
+zzuf_cgroup_t *zzuf_create_cgroup(int nslots, int maxmem, double maxcpus)
+{
+#if defined USE_CGROUP
+    char buf[BUFSIZ];
+
+    char *base = find_self();
+    if (!base)
+    {
+        fprintf(stderr, "zzuf: cannot find our cgroup v2 hierarchy\n");
+        return NULL;
+    }
+
+    zzuf_cgroup_t *cg = calloc(1, sizeof(zzuf_cgroup_t));
+    sprintf(buf, "zzuf.%i", (int)getpid());
+    cg->base = base;
+    cg->top = make_path(base, buf);
+    cg->supervisor = make_path(cg->top, "supervisor");
+    cg->slot = calloc(nslots, sizeof(char *));
+    cg->nslots = nslots;
+
+    if (mkdir(cg->top, 0755) < 0 || mkdir(cg->supervisor, 0755) < 0)
+    {
+        fprintf(stderr, "zzuf: cannot create cgroup %s: %s\n",
+                cg->supervisor, strerror(errno));
+        zzuf_destroy_cgroup(cg);
+        return NULL;
+    }
+
+    sprintf(buf, "%i", (int)getpid());
+    if (write_file(cg->supervisor, "cgroup.procs", buf) < 0)
+    {
+        fprintf(stderr, "zzuf: cannot move to cgroup %s: %s\n",
+                cg->supervisor, strerror(errno));
+        zzuf_destroy_cgroup(cg);
+        return NULL;
+    }
+
+    /* Enable controllers all the way down to our slots, remembering
+     * what we changed so that we can restore it. */
+    char available[BUFSIZ], enabled[BUFSIZ];
+    if (read_file(base, "cgroup.controllers", available, BUFSIZ) < 0)
+        *available = '\0';
+    if (read_file(base, "cgroup.subtree_control", enabled, BUFSIZ) < 0)
+        *enabled = '\0';
+
+    for (int i = 0; i < NCONTROLLERS; ++i)
+    {
+        if (!has_word(available, controllers[i]))
+            continue;
+
+        sprintf(buf, "+%s", controllers[i]);
+        if (!has_word(enabled, controllers[i]))
+        {
+            if (write_file(base, "cgroup.subtree_control", buf) < 0)
+                continue;
+            cg->enabled[0][i] = 1;
+        }
+        if (write_file(cg->top, "cgroup.subtree_control", buf) == 0)
+            cg->enabled[1][i] = 1;
+    }
+
+    cg->memory = maxmem >= 0;
+    int cpu = maxcpus > 0.0;
+    for (int i = 0; i < nslots; ++i)
+    {
+        sprintf(buf, "%i", i);
+        cg->slot[i] = make_path(cg->top, buf);
+        if (mkdir(cg->slot[i], 0755) < 0)
+        {
+            fprintf(stderr, "zzuf: cannot create cgroup %s: %s\n",
+                    cg->slot[i], strerror(errno));
+            zzuf_destroy_cgroup(cg);
+            return NULL;
+        }
+
+        if (maxmem >= 0)
+        {
+            /* Do not let children swap instead of hitting the limit, and
+             * kill the whole process tree if one process is killed. */
+            sprintf(buf, "%lli", (long long int)maxmem * 1048576);
+            if (write_file(cg->slot[i], "memory.max", buf) < 0)
+                cg->memory = 0;
+            write_file(cg->slot[i], "memory.swap.max", "0");
+            write_file(cg->slot[i], "memory.oom.group", "1");
+        }
+
+        if (maxcpus > 0.0)
+        {
+            /* At most maxcpus CPUs worth of time per 100 ms period */
+            sprintf(buf, "%lli 100000", (long long int)(maxcpus * 100000));
+            if (write_file(cg->slot[i], "cpu.max", buf) < 0)
+                cpu = 0;
+        }
+    }
+
+    if (maxmem >= 0 && !cg->memory)
+        fprintf(stderr, "zzuf: memory controller unavailable in %s, "
+                "using RLIMIT_AS\n", cg->top);
+    if (maxcpus > 0.0 && !cpu)
+        fprintf(stderr, "zzuf: cpu controller unavailable in %s, "
+                "not limiting CPU time\n", cg->top);
+
+    return cg;
+#else
+    (void)nslots;
+    (void)maxmem;
+    (void)maxcpus;
+    fprintf(stderr, "zzuf: cgroups are not supported on this system\n");
+    return NULL;
+#endif
+}
+
+void zzuf_destroy_cgroup(zzuf_cgroup_t *cg)
+{
+#if defined USE_CGROUP
+    char buf[BUFSIZ];
+
+    if (!cg)
+        return;
+
+    for (int i = 0; i < cg->nslots && cg->slot[i]; ++i)
+    {
+        zz_cgroup_kill(cg, i);
+
+        /* Killed processes need a short while to actually leave */
+        for (int tries = 0; rmdir(cg->slot[i]) < 0 && errno == EBUSY
+                             && tries < 1000; ++tries)
+            usleep(1000);
+        free(cg->slot[i]);
+    }
+
+    for (int i = 0; i < NCONTROLLERS; ++i)
+    {
+        sprintf(buf, "-%s", controllers[i]);
+        if (cg->enabled[1][i])
+            write_file(cg->top, "cgroup.subtree_control", buf);
+        if (cg->enabled[0][i])
+            write_file(cg->base, "cgroup.subtree_control", buf);
+    }
+
+    /* Go back where we came from */
+    sprintf(buf, "%i", (int)getpid());
+    write_file(cg->base, "cgroup.procs", buf);
+    rmdir(cg->supervisor);
+    rmdir(cg->top);
+
+    free(cg->slot);
+    free(cg->supervisor);
+    free(cg->top);
+    free(cg->base);
+    free(cg);
+#else
+    (void)cg;
+#endif
+}
+
+/*
+ * Tell whether the memory limit is enforced by the cgroup, in which case
+ * there is no need for RLIMIT_AS.
+ */
+int zz_cgroup_has_memory(zzuf_cgroup_t *cg)
+{
+    return cg && cg->memory;
+}
+
+/*
+ * Move the calling process to the given slot's cgroup. This is called
+ * in the child, just before exec.
+ */
+int zz_cgroup_enter(zzuf_cgroup_t *cg, int slot)
+{
+#if defined USE_CGROUP
+    return write_file(cg->slot[slot], "cgroup.procs", "0");
+#else
+    (void)cg;
+    (void)slot;
+    return -1;
+#endif
+}
+
+/*
+ * Kill every process in the given slot, including grandchildren that
+ * may have escaped their parent. Kernels older than 5.14 do not have
+ * cgroup.kill, so we go through the process list instead.
+ */
+void zz_cgroup_kill(zzuf_cgroup_t *cg, int slot)
+{
+#if defined USE_CGROUP
+    if (write_file(cg->slot[slot], "cgroup.kill", "1") == 0)
+        return;
+
+    char *path = make_path(cg->slot[slot], "cgroup.procs");
+    FILE *fp = fopen(path, "r");
+    free(path);
+    if (!fp)
+        return;
+
+    int pid;
+    while (fscanf(fp, "%i", &pid) == 1)
+        kill((pid_t)pid, SIGKILL);
+    fclose(fp);
+#else
+    (void)cg;
+    (void)slot;
+#endif
+}
+
+/*
+ * Return the number of processes killed by the OOM killer in the given
+ * slot since it was created, or -1 if we cannot know.
+ */
+int64_t zz_cgroup_ooms(zzuf_cgroup_t *cg, int slot)
+{
+#if defined USE_CGROUP
+    char buf[BUFSIZ];
+
+    if (!cg->memory || read_file(cg->slot[slot], "memory.events",
+                                 buf, BUFSIZ) < 0)
+        return -1;
+
+    char *tmp = strstr(buf, "oom_kill ");
+    return tmp ? (int64_t)atoll(tmp + 9) : -1;
+#else
+    (void)cg;
+    (void)slot;
+    return -1;
+#endif
+}
+
+#if defined USE_CGROUP
+/*
+ * Find the directory of our own cgroup in the cgroup v2 hierarchy, using
+ * the "0::" entry of /proc/self/cgroup and the cgroup2 mount point found
+ * in /proc/self/mountinfo.
+ */
+static char *find_self(void)
+{
+    char line[BUFSIZ], mountpoint[BUFSIZ], fstype[64], *self = NULL;
+
+    FILE *fp = fopen("/proc/self/cgroup", "r");
+    if (!fp)
+        return NULL;
+    while (!self && fgets(line, BUFSIZ, fp))
+        if (!strncmp(line, "0::", 3))
+        {
+            line[strcspn(line, "\n")] = '\0';
+            self = strdup(line + 3);
+        }
+    fclose(fp);
+    if (!self)
+        return NULL;
+
+    char *ret = NULL;
+    fp = fopen("/proc/self/mountinfo", "r");
+    while (fp && !ret && fgets(line, BUFSIZ, fp))
+    {
+        /* The filesystem type comes right after the " - " separator */
+        char *sep = strstr(line, " - ");
+        if (!sep || sscanf(sep + 3, "%63s", fstype) != 1
+             || strcmp(fstype, "cgroup2")
+             || sscanf(line, "%*s %*s %*s %*s %4095s", mountpoint) != 1)
+            continue;
+
+        ret = make_path(mountpoint, self);
+    }
+    if (fp)
+        fclose(fp);
+
+    free(self);
+    return ret;
+}
+
+static char *make_path(char const *dir, char const *name)
+{
+    char *ret = malloc(strlen(dir) + strlen(name) + 2);
+
+    while (*name == '/')
+        ++name;
+    sprintf(ret, "%s%s%s", dir, *name ? "/" : "", name);
+
+    return ret;
+}
+
+static int write_file(char const *dir, char const *file, char const *str)
+{
+    char *path = make_path(dir, file);
+    int fd = open(path, O_WRONLY | O_CLOEXEC);
+    free(path);
+    if (fd < 0)
+        return -1;
+
+    int ret = write(fd, str, strlen(str)) == (ssize_t)strlen(str) ? 0 : -1;
+    int saved = errno;
+    close(fd);
+    errno = saved;
+
+    return ret;
+}
+
+static int read_file(char const *dir, char const *file, char *buf, size_t n)
+{
+    char *path = make_path(dir, file);
+    int fd = open(path, O_RDONLY | O_CLOEXEC);
+    free(path);
+    if (fd < 0)
+        return -1;
+
+    ssize_t ret = read(fd, buf, n - 1);
+    close(fd);
+    if (ret < 0)
+        return -1;
+
+    buf[ret] = '\0';
+    return 0;
+}
+
+static int has_word(char const *list, char const *word)
+{
+    size_t len = strlen(word);
+
+    for (char const *tmp = list; (tmp = strstr(tmp, word)); tmp += len)
+        if ((tmp == list || tmp[-1] == ' ')
+             && (tmp[len] == '\0' || tmp[len] == ' ' || tmp[len] == '\n'))
+            return 1;
+
+    return 0;
+}
+#endif
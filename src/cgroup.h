@@ -0,0 +1,28 @@
+/*
+ *  zzuf - general purpose fuzzer
+ *
+ *  Copyright © 2002—2015 Sam Hocevar <sam@hocevar.net>
+ *
+ *  This program is free software. It comes without any warranty, to
+ *  the extent permitted by applicable law. You can redistribute it
+ *  and/or modify it under the terms of the Do What the Fuck You Want
+ *  to Public License, Version 2, as published by the WTFPL Task Force.
+ *  See http://www.wtfpl.net/ for more details.
+ */
+
+#pragma once
+
+/*
+ *  cgroup.h: cgroup v2 resource isolation of children
+ */
+
+typedef struct zzuf_cgroup zzuf_cgroup_t;
+
+extern zzuf_cgroup_t *zzuf_create_cgroup(int nslots, int maxmem,
+                                         double maxcpus);
+extern void zzuf_destroy_cgroup(zzuf_cgroup_t *);
+
+extern int zz_cgroup_has_memory(zzuf_cgroup_t *);
+extern int zz_cgroup_enter(zzuf_cgroup_t *, int slot);
+extern void zz_cgroup_kill(zzuf_cgroup_t *, int slot);
+extern int64_t zz_cgroup_ooms(zzuf_cgroup_t *, int slot);
@@ -35,20 +35,79 @@
  * zzuf may bring a machine down to its knees because of I/O. */
 #define DEFAULT_MEM 1024
 
+/* With --output, we keep the last 64 KiB of each output stream. This is
+ * usually enough for a sanitizer report with its stack traces. */
+#define DEFAULT_OUTSIZE 64
+
 /* We use file descriptor 17 as the debug channel on Unix */
 #define DEBUG_FILENO 17
 
+/* Markers in -b ranges: at most 8 markers of at most 32 bytes each, and
+ * at most 16 ranges after markers are remembered for each file. */
+#define MAX_MARKERS 8
+#define MAX_MARKER_LEN 32
+#define MAX_WINDOWS 16
+
+/* With -f dict, tokens are at most 128 bytes long, and at most 128 of
+ * them are written in each chunk. */
+#define MAX_TOKEN_LEN 128
+#define MAX_CHUNK_TOKENS 128
+
+/* With --insert-delete, at most 32 runs of at most 16 bytes are inserted
+ * or deleted in each chunk. */
+#define MAX_CHUNK_EDITS 32
+#define MAX_EDIT_LEN 16
+
+/* Checksum fix-ups: at most 8 checksums can be given, and at most 16 are
+ * remembered for each file, including PNG chunk checksums. */
+#define MAX_CHECKSUMS 8
+#define MAX_FIXUPS 16
+
+/* A checksum of bytes start to end - 1, stored at offset at. The bytes
+ * before done were already added to sum; done is -1 if some of them were
+ * never seen. */
+struct fuzz_fixup
+{
+    int type;
+    int64_t start, end, at, done;
+    uint32_t sum;
+};
+
 struct fuzz_context
 {
+    /* The settings to use, or NULL for the global ones */
+    struct fuzz_settings *settings;
     uint32_t seed;
     double ratio;
     int64_t cur;
+    /* State of the random generator for the current chunk */
+    unsigned long rng;
 #ifdef HAVE_FGETLN
     char *tmp;
 #endif
     int uflag; int64_t upos; uint8_t uchar; /* ungetc stuff */
+    /* Marker search state: bytes scanned so far, the last few of them in
+     * case a marker spans two reads, and where to fuzz after matches */
+    int64_t scanned;
+    uint8_t tail[MAX_MARKER_LEN - 1];
+    int ntail, nwindows;
+    int64_t windows[MAX_WINDOWS][2];
+    /* Tokens written in the current chunk with -f dict */
+    int ntokens;
+    struct { uint16_t offset, token; } tokens[MAX_CHUNK_TOKENS];
+    /* Checksum fix-up state: bytes checksummed so far (-1 before the
+     * first read), where the next PNG chunk starts, and its header */
+    int64_t fixed, pngnext;
+    uint8_t pnghdr[8];
+    int nfixups;
+    struct fuzz_fixup fixups[MAX_FIXUPS];
+    /* Original bytes just before and after the data being fuzzed, for
+     * words that span two reads */
+    uint8_t before[3], after[3];
+    int nbefore, nafter;
     uint8_t data[CHUNKBYTES];
 };
 
 typedef struct fuzz_context fuzz_context_t;
+typedef struct fuzz_settings fuzz_settings_t;
 
@@ -0,0 +1,191 @@
+/*
+ *  zzuf - general purpose fuzzer
+ *
+ *  Copyright © 2002—2015 Sam Hocevar <sam@hocevar.net>
+ *
+ *  This program is free software. It comes without any warranty, to
+ *  the extent permitted by applicable law. You can redistribute it
+ *  and/or modify it under the terms of the Do What the Fuck You Want
+ *  to Public License, Version 2, as published by the WTFPL Task Force.
+ *  See http://www.wtfpl.net/ for more details.
+ */
+
+
+/*
+ *  dict.c: dictionary of tokens for -f dict
+ *
+ *  Dictionaries use the AFL syntax: one token per line between double
+ *  quotes, optionally preceded by a name and an equal sign, with \\, \"
+ *  and \xNN escapes. Lines starting with # are comments. Interesting
+ *  integers are always added after the user's tokens.
+ */
+
+#include "config.h"
+
+#if defined HAVE_STDINT_H
+#   include <stdint.h>
+#elif defined HAVE_INTTYPES_H
+#   include <inttypes.h>
+#endif
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#if defined HAVE_UNISTD_H
+#   include <unistd.h>
+#endif
+#if defined HAVE_IO_H
+#   include <io.h>
+#endif
+
+#include "common.h"
+#include "dict.h"
+
+#if !defined O_BINARY
+#   define O_BINARY 0
+#endif
+
+/* The same values as AFL's, which are known to trigger boundary bugs */
+static int32_t const interesting8[] =
+{
+    -128, -1, 0, 1, 16, 32, 64, 100, 127
+};
+static int32_t const interesting16[] =
+{
+    -32768, -129, 128, 255, 256, 512, 1000, 1024, 4096, 32767
+};
+static int32_t const interesting32[] =
+{
+    INT32_MIN, -100663046, -32769, 32768, 65535, 65536, 100663045, INT32_MAX
+};
+
+static int parse_line(zzuf_dict_t *dict, char *line, int len);
+static void add_token(zzuf_dict_t *dict, uint8_t const *token, int len);
+static void add_integers(zzuf_dict_t *dict, int32_t const *values,
+                         int count, int size);
+
+int _zz_dict_load(zzuf_dict_t *dict, char const *path)
+{
+    char *file = dict->file;
+    int fd, len = 0, ret;
+
+    dict->ntokens = 0;
+    dict->offsets[0] = 0;
+
+    fd = open(path, O_RDONLY | O_BINARY);
+    if (fd < 0)
+        return -1;
+    while (len < MAX_DICT_SIZE - 1
+            && (ret = (int)read(fd, file + len, MAX_DICT_SIZE - 1 - len)) > 0)
+        len += ret;
+    close(fd);
+
+    for (char *line = file, *end; line < file + len; line = end + 1)
+    {
+        end = memchr(line, '\n', file + len - line);
+        if (!end)
+            end = file + len;
+        if (parse_line(dict, line, (int)(end - line)) < 0)
+            return -1;
+    }
+
+    add_integers(dict, interesting8,
+                 sizeof(interesting8) / sizeof(int32_t), 1);
+    add_integers(dict, interesting16,
+                 sizeof(interesting16) / sizeof(int32_t), 2);
+    add_integers(dict, interesting32,
+                 sizeof(interesting32) / sizeof(int32_t), 4);
+
+    return dict->ntokens;
+}
+
+int _zz_dict_count(zzuf_dict_t const *dict)
+{
+    return dict->ntokens;
+}
+
+uint8_t const *_zz_dict_token(zzuf_dict_t const *dict, int i, int *len)
+{
+    *len = dict->offsets[i + 1] - dict->offsets[i];
+    return dict->data + dict->offsets[i];
+}
+
+/* Parse one line of the dictionary; the token is decoded in place */
+static int parse_line(zzuf_dict_t *dict, char *line, int len)
+{
+    char *start, *end;
+    int n = 0;
+
+    while (len && (*line == ' ' || *line == '\t'))
+        ++line, --len;
+    while (len && (line[len - 1] == ' ' || line[len - 1] == '\t'
+                    || line[len - 1] == '\r'))
+        --len;
+
+    if (!len || *line == '#')
+        return 0;
+
+    start = memchr(line, '"', len);
+    if (!start || line[len - 1] != '"' || start == line + len - 1)
+        return -1;
+    end = line + len - 1;
+
+    for (char *p = start + 1; p < end; ++p)
+    {
+        if (*p != '\\')
+            start[n++] = *p;
+        else if (p + 1 < end && (p[1] == '\\' || p[1] == '"'))
+            start[n++] = *++p;
+        else if (p + 3 < end && p[1] == 'x')
+        {
+            char hex[3] = { p[2], p[3], '\0' };
+            if (!strchr("0123456789abcdefABCDEF", hex[0])
+                 || !strchr("0123456789abcdefABCDEF", hex[1]))
+                return -1;
+            start[n++] = (char)strtol(hex, NULL, 16);
+            p += 3;
+        }
+        else
+            return -1;
+    }
+
+    if (n)
+        add_token(dict, (uint8_t const *)start, n);
+
+    return 0;
+}
+
+/* Tokens that do not fit are silently ignored */
+static void add_token(zzuf_dict_t *dict, uint8_t const *token, int len)
+{
+    int n = dict->ntokens;
+
+    if (n == MAX_TOKENS || len > MAX_TOKEN_LEN
+         || dict->offsets[n] + len > MAX_DICT_SIZE)
+        return;
+
+    memcpy(dict->data + dict->offsets[n], token, len);
+    dict->offsets[n + 1] = dict->offsets[n] + len;
+    ++dict->ntokens;
+}
+
+/* Add integers in little-endian and, if they are wider than a byte,
+ * big-endian order */
+static void add_integers(zzuf_dict_t *dict, int32_t const *values,
+                         int count, int size)
+{
+    for (int i = 0; i < count; ++i)
+    {
+        uint32_t v = (uint32_t)values[i];
+        uint8_t le[4], be[4];
+
+        for (int k = 0; k < size; ++k)
+        {
+            le[k] = (uint8_t)(v >> (8 * k));
+            be[size - 1 - k] = le[k];
+        }
+
+        add_token(dict, le, size);
+        if (size > 1)
+            add_token(dict, be, size);
+    }
+}
@@ -0,0 +1,39 @@
+/*
+ *  zzuf - general purpose fuzzer
+ *
+ *  Copyright © 2002—2015 Sam Hocevar <sam@hocevar.net>
+ *
+ *  This program is free software. It comes without any warranty, to
+ *  the extent permitted by applicable law. You can redistribute it
+ *  and/or modify it under the terms of the Do What the Fuck You Want
+ *  to Public License, Version 2, as published by the WTFPL Task Force.
+ *  See http://www.wtfpl.net/ for more details.
+ */
+
+
+#pragma once
+
+/*
+ *  dict.h: dictionary of tokens for -f dict
+ */
+
+#define MAX_DICT_SIZE 65536
+#define MAX_TOKENS 4096
+
+/* libzzuf loads its dictionary before it can allocate memory, so this is
+ * a plain structure that can be static */
+struct zzuf_dict
+{
+    /* Token i is data[offsets[i]] to data[offsets[i + 1] - 1] */
+    uint8_t data[MAX_DICT_SIZE];
+    int offsets[MAX_TOKENS + 1];
+    int ntokens;
+    /* The file being loaded */
+    char file[MAX_DICT_SIZE];
+};
+
+typedef struct zzuf_dict zzuf_dict_t;
+
+extern int _zz_dict_load(zzuf_dict_t *, char const *);
+extern int _zz_dict_count(zzuf_dict_t const *);
+extern uint8_t const *_zz_dict_token(zzuf_dict_t const *, int, int *);
@@ -44,6 +44,7 @@
 #if defined LIBZZUF
 #   include "debug.h"
 #   include "network.h"
+#   include "libzzuf.h"
 #endif
 #include "util/mutex.h"
 
@@ -67,12 +68,14 @@ static struct files
 {
     int managed, locked, active, already_fuzzed;
     int64_t pos, already_pos;
+    /* Offset map when bytes are inserted and deleted, or NULL */
+    zzuf_resize_t *resize;
     /* Public stuff */
     fuzz_context_t fuzz;
 }
 *files, static_files[STATIC_FILES];
 static int *fds, static_fds[STATIC_FILES];
-static int maxfd, nfiles;
+static int maxfd, nfiles, nwatched;
 
 /* Spinlock. This variable protects the fds variable. */
 static zzuf_mutex_t fds_mutex = 0;
@@ -88,6 +91,10 @@ static double  minratio = DEFAULT_RATIO;
 static double  maxratio = DEFAULT_RATIO;
 static int     autoinc = 0;
 
+/* Whether data read from files is fuzzed. It is not when we only fuzz
+ * what zlib decompresses. */
+static int fuzz_files = 1;
+
 void zzuf_include_pattern(char const *regex)
 {
 #if defined HAVE_REGEX_H
@@ -133,6 +140,13 @@ void zzuf_set_ratio(double r0, double r1)
 }
 
 double zzuf_get_ratio(void)
+{
+    return _zz_ratio((uint32_t)seed, minratio, maxratio);
+}
+
+/* Pick a ratio between min and max for a given seed. Ratios are spread
+ * on a log scale, and consecutive seeds get very different ratios. */
+double _zz_ratio(uint32_t s, double min, double max)
 {
     uint8_t const shuffle[16] =
     { 0, 12, 2, 10,
@@ -140,18 +154,18 @@ double zzuf_get_ratio(void)
       9, 13, 3, 6,
       4, 1, 11, 5 };
     uint16_t rate;
-    double min, max, cur;
+    double cur;
 
-    if (minratio == maxratio)
-        return minratio; /* this also takes care of 0.0 */
+    if (min == max)
+        return min; /* this also takes care of 0.0 */
 
-    rate = shuffle[seed & 0xf] << 12;
-    rate |= (seed & 0xf0) << 4;
-    rate |= (seed & 0xf00) >> 4;
-    rate |= (seed & 0xf000) >> 12;
+    rate = shuffle[s & 0xf] << 12;
+    rate |= (s & 0xf0) << 4;
+    rate |= (s & 0xf00) >> 4;
+    rate |= (s & 0xf000) >> 12;
 
-    min = log(minratio);
-    max = log(maxratio);
+    min = log(min);
+    max = log(max);
 
     cur = min + (max - min) * rate / 0xffff;
 
@@ -163,6 +177,29 @@ void zzuf_set_auto_increment(void)
     autoinc = 1;
 }
 
+void _zz_fuzz_files(int enable)
+{
+    fuzz_files = enable;
+}
+
+/* Set up a fuzzing context with the current seed and ratio */
+void _zz_initfuzz(fuzz_context_t *fuzz)
+{
+    fuzz->settings = NULL;
+    fuzz->seed = seed;
+    fuzz->ratio = zzuf_get_ratio();
+    fuzz->cur = -1;
+#if defined HAVE_FGETLN
+    fuzz->tmp = NULL;
+#endif
+    fuzz->uflag = 0;
+    fuzz->scanned = 0;
+    fuzz->ntail = 0;
+    fuzz->nwindows = 0;
+    fuzz->fixed = -1;
+    fuzz->nbefore = fuzz->nafter = 0;
+}
+
 void _zz_fd_init(void)
 {
     /* We start with 32 file descriptors. This is to reduce the number of
@@ -298,28 +335,24 @@ void _zz_register(int fd)
     files[i].managed = 1;
     files[i].locked = 0;
     files[i].pos = 0;
-    files[i].fuzz.seed = seed;
-    files[i].fuzz.ratio = zzuf_get_ratio();
-    files[i].fuzz.cur = -1;
-#if defined HAVE_FGETLN
-    files[i].fuzz.tmp = NULL;
-#endif
-    files[i].fuzz.uflag = 0;
+    files[i].resize = NULL;
+    _zz_initfuzz(&files[i].fuzz);
 
     /* Check whether we should ignore the fd */
     if (list)
     {
         static int idx = 0;
 
-        files[i].active = _zz_isinrange(++idx, list);
+        files[i].active = _zz_isinrange(++idx, list) && fuzz_files;
     }
     else
-        files[i].active = 1;
+        files[i].active = fuzz_files;
 
     if (autoinc)
         seed++;
 
     fds[fd] = i;
+    nwatched++;
 
 early_exit:
     zzuf_mutex_unlock(&fds_mutex);
@@ -327,20 +360,33 @@ early_exit:
 
 void _zz_unregister(int fd)
 {
+    int last = 0;
+
     zzuf_mutex_lock(&fds_mutex);
 
     if (fd >= 0 && fd < maxfd && fds[fd] != -1)
     {
         files[fds[fd]].managed = 0;
+        if (files[fds[fd]].resize)
+            _zz_resize_free(files[fds[fd]].resize);
 #if defined HAVE_FGETLN
         if (files[fds[fd]].fuzz.tmp)
             free(files[fds[fd]].fuzz.tmp);
 #endif
 
         fds[fd] = -1;
+        last = --nwatched == 0;
     }
 
     zzuf_mutex_unlock(&fds_mutex);
+
+#if defined LIBZZUF
+    /* Let zzuf know what we read and whether anything was fuzzed */
+    if (last)
+        _zz_report("closed");
+#else
+    (void)last;
+#endif
 }
 
 void _zz_lockfd(int fd)
@@ -499,3 +545,29 @@ fuzz_context_t *_zz_getfuzz(int fd)
     return ret;
 }
 
+void _zz_setresize(int fd, zzuf_resize_t *resize)
+{
+    zzuf_mutex_lock(&fds_mutex);
+
+    if (fd >= 0 && fd < maxfd && fds[fd] != -1)
+    {
+        files[fds[fd]].resize = resize;
+    }
+
+    zzuf_mutex_unlock(&fds_mutex);
+}
+
+/* Same FIXME as _zz_getfuzz() */
+zzuf_resize_t *_zz_getresize(int fd)
+{
+    zzuf_resize_t *ret = NULL;
+    zzuf_mutex_lock(&fds_mutex);
+
+    if (fd >= 0 && fd < maxfd && fds[fd] != -1)
+    {
+        ret = files[fds[fd]].resize;
+    }
+
+    zzuf_mutex_unlock(&fds_mutex);
+    return ret;
+}
@@ -22,12 +22,17 @@
 #include <stdint.h>
 #include <wchar.h>
 
+#include "common/resize.h"
+
 extern void zzuf_include_pattern(char const *);
 extern void zzuf_exclude_pattern(char const *);
 extern void zzuf_set_seed(int32_t);
 extern void zzuf_set_ratio(double, double);
 extern double zzuf_get_ratio(void);
+extern double _zz_ratio(uint32_t seed, double min, double max);
 extern void zzuf_set_auto_increment(void);
+extern void _zz_fuzz_files(int);
+extern void _zz_initfuzz(fuzz_context_t *);
 extern void _zz_fd_init(void);
 extern void _zz_fd_fini(void);
 
@@ -48,3 +53,6 @@ extern int _zz_getfuzzed(int);
 
 extern fuzz_context_t *_zz_getfuzz(int);
 
+extern void _zz_setresize(int, zzuf_resize_t *);
+extern zzuf_resize_t *_zz_getresize(int);
+
@@ -0,0 +1,278 @@
+/*
+ *  zzuf - general purpose fuzzer
+ *
+ *  Copyright © 2002—2015 Sam Hocevar <sam@hocevar.net>
+ *
+ *  This program is free software. It comes without any warranty, to
+ *  the extent permitted by applicable law. You can redistribute it
+ *  and/or modify it under the terms of the Do What the Fuck You Want
+ *  to Public License, Version 2, as published by the WTFPL Task Force.
+ *  See http://www.wtfpl.net/ for more details.
+ */
+
+
+/*
+ *  fixup.c: checksum fix-ups after fuzzing
+ *
+ *  Checksums are computed over the fuzzed data as it is read, and written
+ *  over the stored checksum when the reader gets there. This only works
+ *  for checksums stored after the data they cover, and only if the data
+ *  is read forwards; data read again gets the same checksums written, but
+ *  a checksum whose data was partly skipped is left alone.
+ */
+
+#include "config.h"
+
+#if defined HAVE_STDINT_H
+#   include <stdint.h>
+#elif defined HAVE_INTTYPES_H
+#   include <inttypes.h>
+#endif
+#include <stdlib.h>
+#include <string.h>
+
+#include "common.h"
+#include "fixup.h"
+#include "util/checksum.h"
+
+enum
+{
+    FIXUP_CRC32, FIXUP_CRC32LE, FIXUP_ADLER32
+};
+
+/* Checksums given by the user, and whether to fix PNG chunks */
+static struct fuzz_fixup checksums[MAX_CHECKSUMS];
+static int nchecksums = 0;
+static int png = 0;
+
+static void sum(fuzz_context_t *, int64_t, uint8_t const *, int64_t);
+static void add_fixup(fuzz_context_t *, struct fuzz_fixup const *);
+static void parse_png(fuzz_context_t *);
+
+/*
+ * Parse a list of checksums: "png" for all PNG chunk CRCs, or a type among
+ * "crc32", "crc32le" and "adler32" followed by ":start-end@offset", where
+ * start and end are inclusive.
+ */
+int _zz_checksums(char const *list)
+{
+    nchecksums = 0;
+    png = 0;
+
+    for (char const *item = list; *item; )
+    {
+        char const *end = strchr(item, ',');
+        size_t n = end ? (size_t)(end - item) : strlen(item);
+        struct fuzz_fixup f;
+        char const *tmp;
+        char *parse;
+
+        if (n == 3 && !memcmp(item, "png", 3))
+            png = 1;
+        else
+        {
+            if (n > 8 && !memcmp(item, "crc32le:", 8))
+                f.type = FIXUP_CRC32LE, tmp = item + 8;
+            else if (n > 6 && !memcmp(item, "crc32:", 6))
+                f.type = FIXUP_CRC32, tmp = item + 6;
+            else if (n > 8 && !memcmp(item, "adler32:", 8))
+                f.type = FIXUP_ADLER32, tmp = item + 8;
+            else
+                return -1;
+
+            f.start = strtoll(tmp, &parse, 10);
+            if (parse == tmp || *parse != '-')
+                return -1;
+            tmp = parse + 1;
+            f.end = strtoll(tmp, &parse, 10) + 1;
+            if (parse == tmp || *parse != '@')
+                return -1;
+            tmp = parse + 1;
+            f.at = strtoll(tmp, &parse, 10);
+            if (parse == tmp || parse != item + n)
+                return -1;
+
+            /* The checksum must come after the data it covers */
+            if (f.start < 0 || f.end <= f.start || f.at < f.end
+                 || nchecksums == MAX_CHECKSUMS)
+                return -1;
+
+            f.done = f.start;
+            f.sum = f.type == FIXUP_ADLER32 ? 1 : 0;
+            checksums[nchecksums++] = f;
+        }
+
+        item += n;
+        if (*item == ',')
+            ++item;
+    }
+
+    return 0;
+}
+
+/*
+ * Update checksums with fuzzed data and write those that are complete.
+ * Data before fuzz->fixed was already seen, so only the rest is summed.
+ */
+void _zz_fixup(fuzz_context_t *fuzz, int64_t pos, volatile uint8_t *vbuf,
+               int64_t len)
+{
+    uint8_t *buf = (uint8_t *)(uintptr_t)vbuf;
+    int64_t cur, stop = pos + len;
+
+    if (!nchecksums && !png)
+        return;
+
+    /* First read from this file */
+    if (fuzz->fixed < 0)
+    {
+        fuzz->nfixups = 0;
+        for (int i = 0; i < nchecksums; ++i)
+            fuzz->fixups[fuzz->nfixups++] = checksums[i];
+        fuzz->pngnext = png ? 8 : -1; /* skip the PNG signature */
+        fuzz->fixed = 0;
+    }
+
+    /* Some data was skipped; checksums over it cannot be computed, and
+     * we lose track of PNG chunks if a chunk header was skipped */
+    if (pos > fuzz->fixed)
+    {
+        for (int i = 0; i < fuzz->nfixups; ++i)
+        {
+            struct fuzz_fixup *f = &fuzz->fixups[i];
+            if (f->done >= 0 && f->done < f->end && f->done < pos)
+                f->done = -1;
+        }
+        if (fuzz->pngnext >= 0 && fuzz->pngnext < pos)
+            fuzz->pngnext = -1;
+        fuzz->fixed = pos;
+    }
+
+    /* Sum new data, stopping at PNG chunk headers to parse them */
+    for (cur = fuzz->fixed; cur < stop; )
+    {
+        int64_t next = stop;
+
+        if (fuzz->pngnext >= 0 && cur < fuzz->pngnext + 8)
+        {
+            int64_t mark = cur < fuzz->pngnext ? fuzz->pngnext
+                                               : fuzz->pngnext + 8;
+            if (mark < next)
+                next = mark;
+        }
+
+        sum(fuzz, cur, buf + (cur - pos), next - cur);
+
+        if (fuzz->pngnext >= 0 && cur >= fuzz->pngnext)
+        {
+            memcpy(fuzz->pnghdr + (cur - fuzz->pngnext), buf + (cur - pos),
+                   (size_t)(next - cur));
+            if (next == fuzz->pngnext + 8)
+                parse_png(fuzz);
+        }
+
+        cur = next;
+    }
+
+    if (stop > fuzz->fixed)
+        fuzz->fixed = stop;
+
+    /* Write the complete checksums that are in this buffer */
+    for (int i = 0; i < fuzz->nfixups; ++i)
+    {
+        struct fuzz_fixup const *f = &fuzz->fixups[i];
+        uint8_t bytes[4];
+
+        if (f->done != f->end || f->at >= stop || f->at + 4 <= pos)
+            continue;
+
+        for (int k = 0; k < 4; ++k)
+            bytes[k] = (uint8_t)(f->type == FIXUP_CRC32LE
+                                  ? f->sum >> (8 * k)
+                                  : f->sum >> (24 - 8 * k));
+
+        for (int64_t j = f->at > pos ? f->at : pos;
+             j < f->at + 4 && j < stop; ++j)
+            buf[j - pos] = bytes[j - f->at];
+    }
+}
+
+/* Add len bytes at offset pos to the checksums that need them */
+static void sum(fuzz_context_t *fuzz, int64_t pos, uint8_t const *buf,
+                int64_t len)
+{
+    for (int i = 0; i < fuzz->nfixups; ++i)
+    {
+        struct fuzz_fixup *f = &fuzz->fixups[i];
+        int64_t lo = f->done, hi = f->end < pos + len ? f->end : pos + len;
+
+        if (lo < pos || lo >= hi)
+            continue;
+
+        if (f->type == FIXUP_ADLER32)
+            f->sum = zz_adler32(f->sum, buf + (lo - pos), (size_t)(hi - lo));
+        else
+            f->sum = zz_crc32(f->sum, buf + (lo - pos), (size_t)(hi - lo));
+        f->done = hi;
+    }
+}
+
+/* Remember a checksum. When the list is full, the complete checksum that
+ * is stored first is forgotten, since reads usually go forward. */
+static void add_fixup(fuzz_context_t *fuzz, struct fuzz_fixup const *f)
+{
+    int slot = fuzz->nfixups;
+
+    if (slot == MAX_FIXUPS)
+    {
+        slot = -1;
+        for (int i = 0; i < MAX_FIXUPS; ++i)
+        {
+            struct fuzz_fixup const *g = &fuzz->fixups[i];
+            if ((g->done < 0 || g->done == g->end)
+                 && (slot < 0 || g->at < fuzz->fixups[slot].at))
+                slot = i;
+        }
+        if (slot < 0)
+            return;
+    }
+    else
+        fuzz->nfixups++;
+
+    fuzz->fixups[slot] = *f;
+}
+
+/* A PNG chunk is a big-endian length, a four-letter type, the data and a
+ * CRC-32 of the type and the data. Anything else means this is not PNG
+ * data, or not anymore, so we stop looking for chunks. */
+static void parse_png(fuzz_context_t *fuzz)
+{
+    uint8_t const *hdr = fuzz->pnghdr;
+    uint32_t len = (uint32_t)hdr[0] << 24 | (uint32_t)hdr[1] << 16
+                 | (uint32_t)hdr[2] << 8 | (uint32_t)hdr[3];
+    struct fuzz_fixup f;
+
+    for (int k = 4; k < 8; ++k)
+    {
+        if ((hdr[k] | 0x20) < 'a' || (hdr[k] | 0x20) > 'z')
+        {
+            fuzz->pngnext = -1;
+            return;
+        }
+    }
+
+    if (len > 0x7fffffff)
+    {
+        fuzz->pngnext = -1;
+        return;
+    }
+
+    f.type = FIXUP_CRC32;
+    f.start = fuzz->pngnext + 4;
+    f.done = fuzz->pngnext + 8;
+    f.end = f.at = f.done + len;
+    f.sum = zz_crc32(0, hdr + 4, 4);
+    add_fixup(fuzz, &f);
+
+    fuzz->pngnext = f.at + 4;
+}
@@ -0,0 +1,21 @@
+/*
+ *  zzuf - general purpose fuzzer
+ *
+ *  Copyright © 2002—2015 Sam Hocevar <sam@hocevar.net>
+ *
+ *  This program is free software. It comes without any warranty, to
+ *  the extent permitted by applicable law. You can redistribute it
+ *  and/or modify it under the terms of the Do What the Fuck You Want
+ *  to Public License, Version 2, as published by the WTFPL Task Force.
+ *  See http://www.wtfpl.net/ for more details.
+ */
+
+
+#pragma once
+
+/*
+ *  fixup.h: checksum fix-ups after fuzzing
+ */
+
+extern int _zz_checksums(char const *);
+extern void _zz_fixup(fuzz_context_t *, int64_t, volatile uint8_t *, int64_t);
@@ -30,56 +30,245 @@
 #include "fuzz.h"
 #include "fd.h"
 #include "ranges.h"
+#include "fixup.h"
+#include "dict.h"
+#include "mutator.h"
 #if defined LIBZZUF
 #   include "debug.h"
+#   include "libzzuf.h"
 #endif
 
 #define MAGIC1 0x33ea84f7
 #define MAGIC2 0x783bc31f
 #define MAGIC3 0x9b5da2fb
 
+/* Largest value added or subtracted by the arith modes */
+#define ARITH_MAX 35
+
 /* Fuzzing mode */
-static enum fuzzing
+enum fuzzing
+{
+    FUZZING_XOR = 0, FUZZING_SET, FUZZING_UNSET, FUZZING_DICT,
+    FUZZING_BYTE, FUZZING_ARITH8, FUZZING_ARITH16LE, FUZZING_ARITH16BE,
+    FUZZING_ARITH32LE, FUZZING_ARITH32BE, FUZZING_SWAP16, FUZZING_SWAP32,
+    FUZZING_TEXT,
+};
+
+/* A kernel applies the mask of a chunk to the bytes between two offsets
+ * of that chunk. Each mode has its own, chosen once per call rather than
+ * once per byte. */
+typedef void (*kernel_t)(fuzz_context_t *, int64_t, int64_t,
+                         volatile uint8_t *);
+
+static void apply_xor(fuzz_context_t *, int64_t, int64_t, volatile uint8_t *);
+static void apply_set(fuzz_context_t *, int64_t, int64_t, volatile uint8_t *);
+static void apply_unset(fuzz_context_t *, int64_t, int64_t,
+                        volatile uint8_t *);
+static void apply_tokens(fuzz_context_t *, int64_t, int64_t,
+                         volatile uint8_t *);
+static void apply_arith8(fuzz_context_t *, int64_t, int64_t,
+                         volatile uint8_t *);
+static void apply_arith16le(fuzz_context_t *, int64_t, int64_t,
+                            volatile uint8_t *);
+static void apply_arith16be(fuzz_context_t *, int64_t, int64_t,
+                            volatile uint8_t *);
+static void apply_arith32le(fuzz_context_t *, int64_t, int64_t,
+                            volatile uint8_t *);
+static void apply_arith32be(fuzz_context_t *, int64_t, int64_t,
+                            volatile uint8_t *);
+static void apply_swap16(fuzz_context_t *, int64_t, int64_t,
+                         volatile uint8_t *);
+static void apply_swap32(fuzz_context_t *, int64_t, int64_t,
+                         volatile uint8_t *);
+static void apply_text(fuzz_context_t *, int64_t, int64_t, volatile uint8_t *);
+static void apply_mutator(fuzz_context_t *, zzuf_mutate_t, int64_t, int64_t,
+                          int64_t, volatile uint8_t *);
+
+/* Modes in the same order as enum fuzzing. Bit modes have a size of 0;
+ * the others change size bytes wherever their mask is not zero. */
+static struct
 {
-    FUZZING_XOR = 0, FUZZING_SET, FUZZING_UNSET
+    char const *name;
+    kernel_t kernel;
+    int size;
 }
-fuzzing;
+const modes[] =
+{
+    { "xor",       apply_xor,       0 },
+    { "set",       apply_set,       0 },
+    { "unset",     apply_unset,     0 },
+    { "dict",      apply_tokens,    0 },
+    { "byte",      apply_xor,       1 },
+    { "arith8",    apply_arith8,    1 },
+    { "arith16le", apply_arith16le, 2 },
+    { "arith16be", apply_arith16be, 2 },
+    { "arith32le", apply_arith32le, 4 },
+    { "arith32be", apply_arith32be, 4 },
+    { "swap16",    apply_swap16,    2 },
+    { "swap32",    apply_swap32,    4 },
+    { "text",      apply_text,      1 },
+};
 
-/* Per-offset byte protection */
-static int64_t *ranges = NULL;
-static int64_t static_ranges[512];
+/* Everything that says how to fuzz, apart from the seed and ratio. zzuf
+ * and libzzuf use the global settings below; each zzuf_ctx_t has its own,
+ * so that contexts can be used from different threads. */
+struct fuzz_settings
+{
+    enum fuzzing fuzzing;
+    /* Per-offset byte protection, and per-range ratios if any */
+    int64_t *ranges;
+    int64_t static_ranges[512];
+    double *weights;
+    double static_weights[256];
+    /* Markers that anchor ranges, if any */
+    zzuf_marker_t markers[MAX_MARKERS];
+    int nmarkers;
+    /* Per-value byte protection */
+    unsigned char protect[256];
+    unsigned char refuse[256];
+    /* Tokens for -f dict, or NULL */
+    zzuf_dict_t *dict;
+    /* Mutator plugin that replaces the fuzzing mode, or NULL */
+    zzuf_mutate_t mutate;
+    /* Number of bits changed so far */
+    int64_t flips;
+};
 
-/* Per-value byte protection */
-static unsigned char protect[256];
-static unsigned char refuse[256];
+static zzuf_dict_t global_dict;
+static fuzz_settings_t global = { .dict = &global_dict };
+
+/* Character classes for -f text; a character is replaced with another one
+ * from its class. Line breaks and control characters are left alone. */
+static char const *text_classes[] =
+{
+    NULL,
+    "0123456789",
+    "abcdefghijklmnopqrstuvwxyz",
+    "ABCDEFGHIJKLMNOPQRSTUVWXYZ",
+    "!\"#$%&'()*+,-./:;<=>?@[\\]^_`{|}~",
+    " \t",
+};
 
 /* Local prototypes */
+static void add_weighted_flips(fuzz_context_t *, int64_t);
+static void add_tokens(fuzz_context_t *);
+static void add_sites(fuzz_context_t *, int);
+static int must_fuzz(fuzz_context_t const *, int64_t);
+static void scan_markers(fuzz_context_t *, int64_t, uint8_t const *, int64_t);
+static void add_window(fuzz_context_t *, int64_t, int);
+static int in_window(fuzz_context_t const *, int64_t);
+#if defined LIBZZUF
+static int lookaround(fuzz_settings_t const *);
+#endif
 static void add_char_range(unsigned char *, char const *);
+static int text_class(uint8_t, int *);
 
-extern void _zz_fuzzing(char const *mode)
+extern int _zz_fuzzing(char const *mode)
 {
-    if (!strcmp(mode, "xor"))
-        fuzzing = FUZZING_XOR;
-    else if (!strcmp(mode, "set"))
-        fuzzing = FUZZING_SET;
-    else if (!strcmp(mode, "unset"))
-        fuzzing = FUZZING_UNSET;
+    return _zz_settings_fuzzing(&global, mode);
 }
 
 void _zz_bytes(char const *list)
 {
-    /* TODO: free(ranges) if ranges != static_ranges */
-    ranges = _zz_allocrange(list, static_ranges);
+    _zz_settings_bytes(&global, list);
 }
 
 void zzuf_protect_range(char const *list)
 {
-    add_char_range(protect, list);
+    add_char_range(global.protect, list);
 }
 
 void zzuf_refuse_range(char const *list)
 {
-    add_char_range(refuse, list);
+    add_char_range(global.refuse, list);
+}
+
+/* Whether each byte is fuzzed regardless of the bytes around it and of
+ * how the input is read, as --skip-duplicates requires */
+int _zz_fuzzing_bytewise(void)
+{
+    return !global.mutate && global.fuzzing != FUZZING_TEXT
+            && modes[global.fuzzing].size <= 1;
+}
+
+int _zz_mutator(char const *path)
+{
+    global.mutate = _zz_mutator_load(path);
+    return global.mutate ? 0 : -1;
+}
+
+int64_t _zz_getflips(void)
+{
+    return global.flips;
+}
+
+fuzz_settings_t *_zz_settings_new(void)
+{
+    return calloc(1, sizeof(fuzz_settings_t));
+}
+
+void _zz_settings_free(fuzz_settings_t *settings)
+{
+    if (settings->ranges != settings->static_ranges)
+        free(settings->ranges);
+    if (settings->weights != settings->static_weights)
+        free(settings->weights);
+    free(settings->dict);
+    free(settings);
+}
+
+/* Set the fuzzing mode; only fails if a dictionary cannot be loaded, and
+ * an unknown mode leaves the current one */
+int _zz_settings_fuzzing(fuzz_settings_t *settings, char const *mode)
+{
+    if (!strncmp(mode, "dict:", 5))
+    {
+        if (!settings->dict)
+            settings->dict = malloc(sizeof(zzuf_dict_t));
+        if (_zz_dict_load(settings->dict, mode + 5) < 0)
+            return -1;
+        settings->fuzzing = FUZZING_DICT;
+        return 0;
+    }
+
+    for (size_t i = 0; i < sizeof(modes) / sizeof(*modes); ++i)
+        if (i != FUZZING_DICT && !strcmp(mode, modes[i].name))
+            settings->fuzzing = (enum fuzzing)i;
+
+    return 0;
+}
+
+void _zz_settings_bytes(fuzz_settings_t *settings, char const *list)
+{
+    if (settings->ranges != settings->static_ranges)
+        free(settings->ranges);
+    if (settings->weights != settings->static_weights)
+        free(settings->weights);
+
+    settings->ranges = _zz_allocrange(list, settings->static_ranges);
+    settings->weights = _zz_allocweights(list, settings->static_weights);
+    settings->nmarkers = _zz_allocmarkers(list, settings->markers,
+                                          MAX_MARKERS);
+}
+
+void _zz_settings_protect(fuzz_settings_t *settings, char const *list)
+{
+    add_char_range(settings->protect, list);
+}
+
+void _zz_settings_refuse(fuzz_settings_t *settings, char const *list)
+{
+    add_char_range(settings->refuse, list);
+}
+
+void _zz_settings_mutator(fuzz_settings_t *settings, zzuf_mutate_t mutate)
+{
+    settings->mutate = mutate;
+}
+
+int64_t _zz_settings_flips(fuzz_settings_t const *settings)
+{
+    return settings->flips;
 }
 
 void _zz_fuzz(int fd, volatile uint8_t *buf, int64_t len)
@@ -89,15 +278,74 @@ void _zz_fuzz(int fd, volatile uint8_t *buf, int64_t len)
 #if defined LIBZZUF
     debug2("... fuzz(%i, @%lli, %lli)", fd, (long long int)pos,
            (long long int)len);
+
+    if (g_profile_reads)
+        _zz_profile_read(pos, len);
 #endif
 
-    volatile uint8_t *aligned_buf = buf - pos;
     fuzz_context_t *fuzz = _zz_getfuzz(fd);
 
+#if defined LIBZZUF
+    /* Words that span two reads need the original bytes around the data,
+     * which can be read again from files but not from pipes */
+    int around = lookaround(fuzz->settings ? fuzz->settings : &global);
+    if (around && pos % CHUNKBYTES)
+    {
+        int n = pos % CHUNKBYTES < around ? (int)(pos % CHUNKBYTES) : around;
+        if (_zz_peek(fd, pos - n, fuzz->before, n) == n)
+            fuzz->nbefore = n;
+    }
+    if (around && (pos + len) % CHUNKBYTES)
+        fuzz->nafter = _zz_peek(fd, pos + len, fuzz->after, around);
+#endif
+
+    _zz_fuzz_data(fuzz, pos, buf, len);
+
+    /* Checksums must be computed over the fuzzed data */
+    _zz_fixup(fuzz, pos, buf, len);
+
+    /* Handle ungetc() */
+    if (fuzz->uflag)
+    {
+        fuzz->uflag = 0;
+        if (fuzz->upos == pos)
+            buf[0] = fuzz->uchar;
+    }
+}
+
+/* Fuzz len bytes at offset pos of a stream, whether it is a file or
+ * something else, such as the output of zlib. */
+void _zz_fuzz_data(fuzz_context_t *fuzz, int64_t pos,
+                   volatile uint8_t *buf, int64_t len)
+{
+    /* Contexts set up by _zz_initfuzz() use the global settings */
+    if (!fuzz->settings)
+        fuzz->settings = &global;
+
+    fuzz_settings_t const *settings = fuzz->settings;
+    volatile uint8_t *aligned_buf = buf - pos;
+    kernel_t kernel = modes[settings->fuzzing].kernel;
+    zzuf_mutate_t mutate = settings->mutate;
+
+    /* Markers must be found in the data before it gets fuzzed */
+    if (settings->nmarkers)
+        scan_markers(fuzz, pos, (uint8_t const *)(uintptr_t)buf, len);
+
     for (int64_t i = pos / CHUNKBYTES;
          i < (pos + len + CHUNKBYTES - 1) / CHUNKBYTES;
          ++i)
     {
+        int64_t start = (i * CHUNKBYTES > pos) ? i * CHUNKBYTES : pos;
+        int64_t stop = ((i + 1) * CHUNKBYTES < pos + len)
+                      ? (i + 1) * CHUNKBYTES : pos + len;
+
+        /* A mutator plugin replaces the fuzzing mode */
+        if (mutate)
+        {
+            apply_mutator(fuzz, mutate, i, start, stop, aligned_buf);
+            continue;
+        }
+
         /* Cache bitmask array */
         if (fuzz->cur != (int)i)
         {
@@ -109,75 +357,692 @@ void _zz_fuzz(int fd, volatile uint8_t *buf, int64_t len)
             chunkseed ^= fuzz->seed;
             chunkseed += (uint32_t)(i * MAGIC3);
 
-            zzuf_srand(chunkseed);
-
-            memset(fuzz->data, 0, CHUNKBYTES);
+            zzuf_srand_r(&fuzz->rng, chunkseed);
 
-            /* Add some random dithering to handle ratio < 1.0/CHUNKBYTES */
-            int todo = (int)((fuzz->ratio * (8 * CHUNKBYTES) * 1000000.0
-                                + zzuf_rand(1000000)) / 1000000.0);
-            while (todo--)
+            if (settings->fuzzing == FUZZING_DICT)
+                add_tokens(fuzz);
+            else if (modes[settings->fuzzing].size)
+                add_sites(fuzz, modes[settings->fuzzing].size);
+            else if (settings->weights)
             {
-                unsigned int idx = zzuf_rand(CHUNKBYTES);
-                uint8_t bit = (1 << zzuf_rand(8));
+                memset(fuzz->data, 0, CHUNKBYTES);
+                add_weighted_flips(fuzz, i);
+            }
+            else
+            {
+                memset(fuzz->data, 0, CHUNKBYTES);
 
-                fuzz->data[idx] ^= bit;
+                /* Random dithering handles ratio < 1.0/CHUNKBYTES */
+                int todo = (int)((fuzz->ratio * (8 * CHUNKBYTES) * 1000000.0
+                                    + zzuf_rand_r(&fuzz->rng, 1000000))
+                                   / 1000000.0);
+                while (todo--)
+                {
+                    unsigned int idx = zzuf_rand_r(&fuzz->rng, CHUNKBYTES);
+                    uint8_t bit = (1 << zzuf_rand_r(&fuzz->rng, 8));
+
+                    fuzz->data[idx] ^= bit;
+                }
             }
 
             fuzz->cur = i;
         }
 
         /* Apply our bitmask array to the buffer */
-        int64_t start = (i * CHUNKBYTES > pos) ? i * CHUNKBYTES : pos;
-        int64_t stop = ((i + 1) * CHUNKBYTES < pos + len)
-                      ? (i + 1) * CHUNKBYTES : pos + len;
+        kernel(fuzz, start, stop, aligned_buf);
+    }
+
+    fuzz->nbefore = fuzz->nafter = 0;
+}
+
+#if defined LIBZZUF
+/* How many bytes around the fuzzed data the current mode needs to see */
+static int lookaround(fuzz_settings_t const *settings)
+{
+    int size = settings->mutate ? 0 : modes[settings->fuzzing].size;
+
+    /* UTF-8 sequences are up to four bytes long */
+    if (!settings->mutate && settings->fuzzing == FUZZING_TEXT)
+        return 3;
+
+    return size > 1 ? size - 1 : 0;
+}
+#endif
+
+/* Write a fuzzed byte, unless -b, -P or -R forbid it */
+static inline void store(fuzz_context_t *fuzz, volatile uint8_t *aligned_buf,
+                         int64_t offset, uint8_t byte)
+{
+    fuzz_settings_t *settings = fuzz->settings;
+    uint8_t orig = aligned_buf[offset];
 
-        for (int64_t j = start; j < stop; ++j)
+    if (!must_fuzz(fuzz, offset) || settings->protect[orig]
+         || settings->refuse[byte])
+        return;
+
+    for (uint8_t diff = orig ^ byte; diff; diff &= diff - 1)
+        ++settings->flips;
+
+    aligned_buf[offset] = byte;
+}
+
+/* Find the next non-zero mask byte at or after offset j. Masks are mostly
+ * zero, so they are skipped eight bytes at a time. */
+static inline int64_t next_site(uint8_t const *mask, int64_t j,
+                                int64_t start, int64_t stop)
+{
+    uint64_t next8;
+
+    while (j + 8 <= stop
+            && (memcpy(&next8, mask + j - start, 8), !next8))
+        j += 8;
+
+    while (j < stop && !mask[j - start])
+        ++j;
+
+    return j;
+}
+
+/* Kernel for the bit modes. The mode is a constant in each caller, so
+ * that the compiler generates one loop per mode without a switch. */
+static inline void apply_bits(fuzz_context_t *fuzz, int64_t start,
+                              int64_t stop, volatile uint8_t *aligned_buf,
+                              enum fuzzing mode)
+{
+    uint8_t const *mask = fuzz->data + start % CHUNKBYTES;
+
+    for (int64_t j = next_site(mask, start, start, stop); j < stop;
+         j = next_site(mask, j + 1, start, stop))
+    {
+        uint8_t fuzzbyte = mask[j - start], byte = aligned_buf[j];
+
+        switch (mode)
         {
-            uint8_t byte, fuzzbyte;
+        case FUZZING_SET:
+            byte |= fuzzbyte;
+            break;
+        case FUZZING_UNSET:
+            byte &= ~fuzzbyte;
+            break;
+        default:
+            byte ^= fuzzbyte;
+            break;
+        }
 
-            if (ranges && !_zz_isinrange(j, ranges))
-                continue; /* Not in one of the ranges, skip byte */
+        store(fuzz, aligned_buf, j, byte);
+    }
+}
 
-            byte = aligned_buf[j];
+static void apply_xor(fuzz_context_t *fuzz, int64_t start, int64_t stop,
+                      volatile uint8_t *aligned_buf)
+{
+    apply_bits(fuzz, start, stop, aligned_buf, FUZZING_XOR);
+}
 
-            if (protect[byte])
-                continue;
+static void apply_set(fuzz_context_t *fuzz, int64_t start, int64_t stop,
+                      volatile uint8_t *aligned_buf)
+{
+    apply_bits(fuzz, start, stop, aligned_buf, FUZZING_SET);
+}
 
-            fuzzbyte = fuzz->data[j % CHUNKBYTES];
+static void apply_unset(fuzz_context_t *fuzz, int64_t start, int64_t stop,
+                        volatile uint8_t *aligned_buf)
+{
+    apply_bits(fuzz, start, stop, aligned_buf, FUZZING_UNSET);
+}
 
-            if (!fuzzbyte)
-                continue;
+/* Get the byte at an offset that may be just before or just after the
+ * buffer, in which case it is the original byte. Returns -1 if it is not
+ * known. */
+static inline int get_byte(fuzz_context_t const *fuzz,
+                           volatile uint8_t const *aligned_buf,
+                           int64_t offset, int64_t start, int64_t stop)
+{
+    if (offset < start)
+        return offset < start - fuzz->nbefore ? -1
+                : fuzz->before[offset - start + fuzz->nbefore];
+
+    if (offset >= stop)
+        return offset >= stop + fuzz->nafter ? -1
+                : fuzz->after[offset - stop];
+
+    return aligned_buf[offset];
+}
+
+/* Get the original bytes of the word at offset j. Returns 0 if some of
+ * them are not known. */
+static inline int get_word(fuzz_context_t const *fuzz,
+                           volatile uint8_t const *aligned_buf, int64_t j,
+                           int size, int64_t start, int64_t stop,
+                           uint8_t *word)
+{
+    for (int k = 0; k < size; ++k)
+    {
+        int byte = get_byte(fuzz, aligned_buf, j + k, start, stop);
+        if (byte < 0)
+            return 0;
+        word[k] = (uint8_t)byte;
+    }
+
+    return 1;
+}
+
+/* Kernel for the word modes: each site with a non-zero mask byte is a
+ * word of size bytes that either gets the mask byte, as a signed value,
+ * added to it, or gets its bytes reversed. Like chunk masks, words that
+ * span two reads are changed in both, using the original bytes around
+ * the buffer; words that cannot be known entirely are left alone. */
+static inline void apply_words(fuzz_context_t *fuzz, int64_t start,
+                               int64_t stop, volatile uint8_t *aligned_buf,
+                               int size, int big_endian, int swap)
+{
+    /* Sites are in the same chunk, but may start before the buffer */
+    int64_t first = start - start % CHUNKBYTES;
+    if (first < start - (size - 1))
+        first = start - (size - 1);
+
+    uint8_t const *mask = fuzz->data + first % CHUNKBYTES;
+
+    for (int64_t j = next_site(mask, first, first, stop); j < stop;
+         j = next_site(mask, j + 1, first, stop))
+    {
+        int8_t delta = (int8_t)mask[j - first];
+        uint8_t word[4], out[4];
+
+        if (!get_word(fuzz, aligned_buf, j, size, start, stop, word))
+            continue;
+
+        if (swap)
+        {
+            for (int k = 0; k < size; ++k)
+                out[k] = word[size - 1 - k];
+        }
+        else
+        {
+            uint32_t value = 0;
+            for (int k = 0; k < size; ++k)
+                value |= (uint32_t)word[k]
+                             << (8 * (big_endian ? size - 1 - k : k));
+
+            value += (uint32_t)(int32_t)delta;
+
+            for (int k = 0; k < size; ++k)
+                out[k] = (uint8_t)(value
+                                    >> (8 * (big_endian ? size - 1 - k : k)));
+        }
+
+        for (int k = 0; k < size; ++k)
+            if (j + k >= start && j + k < stop)
+                store(fuzz, aligned_buf, j + k, out[k]);
+    }
+}
+
+static void apply_arith8(fuzz_context_t *fuzz, int64_t start, int64_t stop,
+                         volatile uint8_t *aligned_buf)
+{
+    apply_words(fuzz, start, stop, aligned_buf, 1, 0, 0);
+}
+
+static void apply_arith16le(fuzz_context_t *fuzz, int64_t start,
+                            int64_t stop, volatile uint8_t *aligned_buf)
+{
+    apply_words(fuzz, start, stop, aligned_buf, 2, 0, 0);
+}
+
+static void apply_arith16be(fuzz_context_t *fuzz, int64_t start,
+                            int64_t stop, volatile uint8_t *aligned_buf)
+{
+    apply_words(fuzz, start, stop, aligned_buf, 2, 1, 0);
+}
+
+static void apply_arith32le(fuzz_context_t *fuzz, int64_t start,
+                            int64_t stop, volatile uint8_t *aligned_buf)
+{
+    apply_words(fuzz, start, stop, aligned_buf, 4, 0, 0);
+}
+
+static void apply_arith32be(fuzz_context_t *fuzz, int64_t start,
+                            int64_t stop, volatile uint8_t *aligned_buf)
+{
+    apply_words(fuzz, start, stop, aligned_buf, 4, 1, 0);
+}
+
+static void apply_swap16(fuzz_context_t *fuzz, int64_t start, int64_t stop,
+                         volatile uint8_t *aligned_buf)
+{
+    apply_words(fuzz, start, stop, aligned_buf, 2, 0, 1);
+}
+
+static void apply_swap32(fuzz_context_t *fuzz, int64_t start, int64_t stop,
+                         volatile uint8_t *aligned_buf)
+{
+    apply_words(fuzz, start, stop, aligned_buf, 4, 0, 1);
+}
+
+/* Mix a mask byte with the seed and offset of its site, for the choices
+ * in -f text that need more than eight random bits. */
+static inline uint32_t site_random(fuzz_context_t const *fuzz, int64_t offset,
+                                   uint8_t m)
+{
+    uint32_t x = (uint32_t)fuzz->seed ^ (uint32_t)offset * MAGIC3 ^ m * MAGIC1;
+
+    x ^= x >> 16;
+    x *= 0x85ebca6b;
+    x ^= x >> 13;
+    x *= 0xc2b2ae35;
+    x ^= x >> 16;
+
+    return x;
+}
+
+/* Replace the UTF-8 sequence at a given offset, if it covers the site,
+ * with another valid one of the same length, and store the bytes that are
+ * between start and stop. Like words, sequences must be within the chunk
+ * of the site. Invalid or truncated sequences are left alone, and so are
+ * sequences that cannot be written entirely because of -b, -P or -R. */
+static void mutate_utf8(fuzz_context_t *fuzz, volatile uint8_t *aligned_buf,
+                        int64_t offset, int64_t site, int64_t start,
+                        int64_t stop, uint32_t r)
+{
+    static uint32_t const min[] = { 0, 0, 0x80, 0x800, 0x10000 };
+    static uint32_t const max[] = { 0, 0, 0x7ff, 0xffff, 0x10ffff };
+
+    uint8_t orig[4], seq[4];
+    int len = 0;
+    uint32_t cp = 0;
+
+    if (!get_word(fuzz, aligned_buf, offset, 1, start, stop, orig))
+        return;
+
+    len = orig[0] < 0xe0 ? 2 : orig[0] < 0xf0 ? 3 : 4;
+    cp = orig[0] & (0x7f >> len);
+
+    if (offset + len <= site
+         || offset + len > site - site % CHUNKBYTES + CHUNKBYTES
+         || !get_word(fuzz, aligned_buf, offset, len, start, stop, orig))
+        return;
+
+    for (int k = 1; k < len; ++k)
+    {
+        if ((orig[k] & 0xc0) != 0x80)
+            return;
+        cp = (cp << 6) | (orig[k] & 0x3f);
+    }
+
+    if (cp < min[len] || cp > max[len] || (cp >= 0xd800 && cp <= 0xdfff))
+        return;
+
+    /* Number the code points of this length, skipping surrogates, and
+     * pick another one */
+    uint32_t holes = len == 3 ? 0x800 : 0;
+    uint32_t n = max[len] - min[len] + 1 - holes;
+    uint32_t idx = cp - min[len] - (cp > 0xdfff ? holes : 0);
+
+    idx = (idx + 1 + r % (n - 1)) % n;
+    cp = idx + min[len];
+    if (cp >= 0xd800 && len == 3)
+        cp += holes;
+
+    for (int k = len - 1; k > 0; --k, cp >>= 6)
+        seq[k] = 0x80 | (cp & 0x3f);
+    seq[0] = (uint8_t)((0xf00 >> len) | cp);
+
+    for (int k = 0; k < len; ++k)
+        if (!must_fuzz(fuzz, offset + k)
+             || fuzz->settings->protect[orig[k]]
+             || fuzz->settings->refuse[seq[k]])
+            return;
+
+    for (int k = 0; k < len; ++k)
+        if (offset + k >= start && offset + k < stop)
+            store(fuzz, aligned_buf, offset + k, seq[k]);
+}
+
+/* Kernel for -f text: characters are replaced within their class, and
+ * UTF-8 sequences with other sequences. A refused value is not a lost
+ * site, the next value in the class is tried instead. A sequence is
+ * changed by the first site it covers, even if that site is in another
+ * read, so that it does not depend on where reads stop. */
+static void apply_text(fuzz_context_t *fuzz, int64_t start, int64_t stop,
+                       volatile uint8_t *aligned_buf)
+{
+    /* Sites just before or after the buffer may change a sequence that
+     * is partly in it */
+    int64_t base = start - start % CHUNKBYTES;
+    int64_t first = start - 3 > base ? start - 3 : base;
+    int64_t last = stop + 3 < base + CHUNKBYTES ? stop + 3 : base + CHUNKBYTES;
+    uint8_t const *mask = fuzz->data + first % CHUNKBYTES;
+
+    for (int64_t j = next_site(mask, first, first, last); j < last;
+         j = next_site(mask, j + 1, first, last))
+    {
+        uint32_t r = site_random(fuzz, j, mask[j - first]);
+        int byte = get_byte(fuzz, aligned_buf, j, start, stop);
+
+        if (byte >= 0x80)
+        {
+            /* Find the start of the sequence this byte belongs to */
+            int64_t lead = j;
+            int c = byte;
+            while (lead > base && lead > j - 3 && (c & 0xc0) == 0x80)
+                c = get_byte(fuzz, aligned_buf, --lead, start, stop);
+
+            int taken = 0;
+            for (int64_t k = lead; k < j; ++k)
+                taken |= fuzz->data[k % CHUNKBYTES];
+
+            if (!taken && c >= 0xc2 && c <= 0xf4)
+                mutate_utf8(fuzz, aligned_buf, lead, j, start, stop, r);
+            continue;
+        }
+
+        /* Other sites outside of the buffer are not ours */
+        if (j < start || j >= stop)
+            continue;
 
-            switch (fuzzing)
+        int index, c = text_class(byte, &index);
+        if (!c)
+            continue;
+
+        char const *chars = text_classes[c];
+        int n = (int)strlen(chars);
+
+        for (int k = 0; k < n - 1; ++k)
+        {
+            int i = (index + 1 + (r + k) % (n - 1)) % n;
+
+            if (!fuzz->settings->refuse[(uint8_t)chars[i]])
             {
-            case FUZZING_XOR:
-                byte ^= fuzzbyte;
-                break;
-            case FUZZING_SET:
-                byte |= fuzzbyte;
-                break;
-            case FUZZING_UNSET:
-                byte &= ~fuzzbyte;
+                store(fuzz, aligned_buf, j, (uint8_t)chars[i]);
                 break;
             }
+        }
+    }
+}
+
+/* Pick the sites of a chunk for the modes that change whole bytes. Like
+ * tokens, sites never cross the end of the chunk, and the ratio is the
+ * probability that a site starts at a given offset. Words never overlap,
+ * so that each one only depends on its own bytes, wherever reads start
+ * and stop. */
+static void add_sites(fuzz_context_t *fuzz, int size)
+{
+    int todo = (int)((fuzz->ratio * CHUNKBYTES * 1000000.0
+                        + zzuf_rand_r(&fuzz->rng, 1000000)) / 1000000.0);
+
+    memset(fuzz->data, 0, CHUNKBYTES);
+
+    while (todo--)
+    {
+        unsigned int idx = zzuf_rand_r(&fuzz->rng, CHUNKBYTES - size + 1);
+        uint8_t value;
+
+        if (fuzz->settings->fuzzing == FUZZING_BYTE
+             || fuzz->settings->fuzzing == FUZZING_TEXT)
+        {
+            /* Any other value: a non-zero mask to xor with */
+            value = (uint8_t)(1 + zzuf_rand_r(&fuzz->rng, 255));
+        }
+        else if (fuzz->settings->fuzzing == FUZZING_SWAP16
+                  || fuzz->settings->fuzzing == FUZZING_SWAP32)
+        {
+            value = 1;
+        }
+        else
+        {
+            int delta = 1 + zzuf_rand_r(&fuzz->rng, ARITH_MAX);
+            if (!zzuf_rand_r(&fuzz->rng, 2))
+                delta = -delta;
+            value = (uint8_t)delta;
+        }
 
-            if (refuse[byte])
+        if (size > 1)
+        {
+            unsigned int lo = idx > (unsigned int)size - 1
+                            ? idx - (size - 1) : 0;
+            int taken = 0;
+
+            for (unsigned int i = lo; i < idx + size; ++i)
+                taken |= fuzz->data[i];
+            if (taken)
                 continue;
+        }
 
-            aligned_buf[j] = byte;
+        fuzz->data[idx] = value;
+    }
+}
+
+/* Pick the tokens to write in a chunk and where. Tokens never cross the
+ * end of the chunk, so that each chunk only depends on its own seed. The
+ * ratio is the probability that a token starts at a given offset. */
+static void add_tokens(fuzz_context_t *fuzz)
+{
+    zzuf_dict_t const *dict = fuzz->settings->dict;
+    int count = _zz_dict_count(dict);
+    int todo = (int)((fuzz->ratio * CHUNKBYTES * 1000000.0
+                        + zzuf_rand_r(&fuzz->rng, 1000000)) / 1000000.0);
+
+    if (todo > MAX_CHUNK_TOKENS)
+        todo = MAX_CHUNK_TOKENS;
+
+    for (fuzz->ntokens = 0; fuzz->ntokens < todo && count; ++fuzz->ntokens)
+    {
+        int t = zzuf_rand_r(&fuzz->rng, count), len;
+
+        _zz_dict_token(dict, t, &len);
+        fuzz->tokens[fuzz->ntokens].token = (uint16_t)t;
+        fuzz->tokens[fuzz->ntokens].offset
+            = (uint16_t)zzuf_rand_r(&fuzz->rng, CHUNKBYTES - len + 1);
+    }
+}
+
+/* Write the tokens of a chunk that fall between offsets start and stop.
+ * Tokens are written in order, so later ones win when they overlap. */
+static void apply_tokens(fuzz_context_t *fuzz, int64_t start, int64_t stop,
+                         volatile uint8_t *aligned_buf)
+{
+    int64_t i = start / CHUNKBYTES;
+
+    for (int k = 0; k < fuzz->ntokens; ++k)
+    {
+        int len;
+        uint8_t const *token = _zz_dict_token(fuzz->settings->dict,
+                                              fuzz->tokens[k].token, &len);
+        int64_t first = i * CHUNKBYTES + fuzz->tokens[k].offset;
+        int64_t lo = first > start ? first : start;
+        int64_t hi = first + len < stop ? first + len : stop;
+
+        for (int64_t j = lo; j < hi; ++j)
+            store(fuzz, aligned_buf, j, token[j - first]);
+    }
+}
+
+/* Let a mutator plugin change a copy of the bytes between offsets start
+ * and stop of a chunk, then keep the changes that -b, -P and -R allow */
+static void apply_mutator(fuzz_context_t *fuzz, zzuf_mutate_t mutate,
+                          int64_t chunk, int64_t start, int64_t stop,
+                          volatile uint8_t *aligned_buf)
+{
+    uint8_t orig[CHUNKBYTES], tmp[CHUNKBYTES];
+    size_t len = (size_t)(stop - start);
+
+    for (size_t j = 0; j < len; ++j)
+        orig[j] = tmp[j] = aligned_buf[start + j];
+
+    mutate(fuzz->seed, chunk, fuzz->ratio, tmp, len, start);
+
+    for (size_t j = 0; j < len; ++j)
+        if (tmp[j] != orig[j])
+            store(fuzz, aligned_buf, start + j, tmp[j]);
+}
+
+/* Whether the byte at a given offset is within the -b ranges */
+static int must_fuzz(fuzz_context_t const *fuzz, int64_t offset)
+{
+    fuzz_settings_t const *settings = fuzz->settings;
+
+    return !settings->ranges || _zz_isinrange(offset, settings->ranges)
+            || (settings->nmarkers && in_window(fuzz, offset));
+}
+
+/* Fill the bitmask of a chunk range by range, each range getting its
+ * own number of flips according to its ratio. The random generator was
+ * seeded for this chunk, so this is as deterministic as uniform fuzzing. */
+static void add_weighted_flips(fuzz_context_t *fuzz, int64_t chunk)
+{
+    fuzz_settings_t const *settings = fuzz->settings;
+    int64_t start = chunk * CHUNKBYTES, stop = start + CHUNKBYTES;
+
+    /* Ranges after markers can be anywhere, use the default ratio there */
+    if (settings->nmarkers)
+    {
+        int todo = (int)((fuzz->ratio * (8 * CHUNKBYTES) * 1000000.0
+                            + zzuf_rand_r(&fuzz->rng, 1000000)) / 1000000.0);
+        while (todo--)
+        {
+            unsigned int idx = zzuf_rand_r(&fuzz->rng, CHUNKBYTES);
+            uint8_t bit = (1 << zzuf_rand_r(&fuzz->rng, 8));
+
+            if (!_zz_isinrange(start + idx, settings->ranges))
+                fuzz->data[idx] ^= bit;
         }
     }
 
-    /* Handle ungetc() */
-    if (fuzz->uflag)
+    for (int64_t const *r = settings->ranges; r[1]; r += 2)
     {
-        fuzz->uflag = 0;
-        if (fuzz->upos == pos)
-            buf[0] = fuzz->uchar;
+        int64_t lo = r[0] > start ? r[0] : start;
+        int64_t hi = (r[0] == r[1] || r[1] > stop) ? stop : r[1];
+        double ratio = settings->weights[(r - settings->ranges) / 2];
+
+        if (lo >= hi)
+            continue;
+
+        if (ratio < 0.0)
+            ratio = fuzz->ratio;
+
+        int todo = (int)((ratio * (8 * (hi - lo)) * 1000000.0
+                            + zzuf_rand_r(&fuzz->rng, 1000000)) / 1000000.0);
+        while (todo--)
+        {
+            unsigned int idx = (unsigned int)(lo - start)
+                + zzuf_rand_r(&fuzz->rng, (unsigned int)(hi - lo));
+            uint8_t bit = (1 << zzuf_rand_r(&fuzz->rng, 8));
+
+            fuzz->data[idx] ^= bit;
+        }
     }
 }
 
+/* Look for markers in data that was never scanned before, including
+ * matches that started in the previous read. Candidates are found with
+ * memchr(), which the C library vectorises, so that scanning keeps up
+ * with bulk reads. Reading backwards does not find markers again, and
+ * skipping data forgets partial matches. */
+static void scan_markers(fuzz_context_t *fuzz, int64_t pos,
+                         uint8_t const *buf, int64_t len)
+{
+    /* Empty reads, such as fread() refilling its buffer at the end of a
+     * file, must not count as skipping data */
+    if (len <= 0 || pos + len <= fuzz->scanned)
+        return;
+
+    if (pos > fuzz->scanned)
+        fuzz->ntail = 0;
+    else
+    {
+        buf += fuzz->scanned - pos;
+        len -= fuzz->scanned - pos;
+        pos = fuzz->scanned;
+    }
+
+    for (int k = 0; k < fuzz->settings->nmarkers; ++k)
+    {
+        zzuf_marker_t const *m = &fuzz->settings->markers[k];
+
+        /* Matches that start in the previous data */
+        if (fuzz->ntail && m->len > 1)
+        {
+            uint8_t tmp[2 * MAX_MARKER_LEN];
+            int nt = fuzz->ntail < m->len - 1 ? fuzz->ntail : m->len - 1;
+            int nb = len < m->len - 1 ? (int)len : m->len - 1;
+
+            memcpy(tmp, fuzz->tail + fuzz->ntail - nt, nt);
+            memcpy(tmp + nt, buf, nb);
+            for (int s = 0; s < nt && s + m->len <= nt + nb; ++s)
+                if (!memcmp(tmp + s, m->data, m->len))
+                    add_window(fuzz, pos - nt + s + m->len, k);
+        }
+
+        /* Matches within this buffer */
+        for (uint8_t const *p = buf; p + m->len <= buf + len; ++p)
+        {
+            p = memchr(p, m->data[0], buf + len - m->len + 1 - p);
+            if (!p)
+                break;
+            if (!memcmp(p, m->data, m->len))
+                add_window(fuzz, pos + (p - buf) + m->len, k);
+        }
+    }
+
+    /* Keep the last bytes for the next read */
+    if (len >= MAX_MARKER_LEN - 1)
+    {
+        memcpy(fuzz->tail, buf + len - (MAX_MARKER_LEN - 1),
+               MAX_MARKER_LEN - 1);
+        fuzz->ntail = MAX_MARKER_LEN - 1;
+    }
+    else
+    {
+        int keep = fuzz->ntail < MAX_MARKER_LEN - 1 - (int)len
+                 ? fuzz->ntail : MAX_MARKER_LEN - 1 - (int)len;
+        memmove(fuzz->tail, fuzz->tail + fuzz->ntail - keep, keep);
+        memcpy(fuzz->tail + keep, buf, len);
+        fuzz->ntail = keep + (int)len;
+    }
+
+    fuzz->scanned = pos + len;
+}
+
+/* Remember the range to fuzz after a match of marker k ending at offset
+ * end. When the list is full, the range that ends first is replaced,
+ * since reads usually go forward. */
+static void add_window(fuzz_context_t *fuzz, int64_t end, int k)
+{
+    zzuf_marker_t const *m = &fuzz->settings->markers[k];
+    int64_t lo = end + m->start;
+    int64_t hi = m->stop < 0 ? INT64_MAX : end + m->stop;
+    int slot = fuzz->nwindows;
+
+    for (int i = 0; i < fuzz->nwindows; ++i)
+    {
+        /* Already covered, for instance by a previous open range */
+        if (fuzz->windows[i][0] <= lo && fuzz->windows[i][1] >= hi)
+            return;
+    }
+
+    if (slot == MAX_WINDOWS)
+    {
+        slot = 0;
+        for (int i = 1; i < MAX_WINDOWS; ++i)
+            if (fuzz->windows[i][1] < fuzz->windows[slot][1])
+                slot = i;
+    }
+    else
+        fuzz->nwindows++;
+
+    fuzz->windows[slot][0] = lo;
+    fuzz->windows[slot][1] = hi;
+}
+
+static int in_window(fuzz_context_t const *fuzz, int64_t offset)
+{
+    for (int i = 0; i < fuzz->nwindows; ++i)
+        if (offset >= fuzz->windows[i][0] && offset < fuzz->windows[i][1])
+            return 1;
+
+    return 0;
+}
+
 static void add_char_range(unsigned char *table, char const *list)
 {
     static char const hex[] = "0123456789abcdef0123456789ABCDEF";
@@ -244,3 +1109,20 @@ static void add_char_range(unsigned char *table, char const *list)
         table[b] = 1;
 }
 
+/* Class of a character for -f text, or 0 if it has none, and its index in
+ * that class */
+static int text_class(uint8_t c, int *index)
+{
+    for (size_t k = 1; c && k < sizeof(text_classes) / sizeof(*text_classes);
+         ++k)
+    {
+        char const *p = strchr(text_classes[k], c);
+        if (p)
+        {
+            *index = (int)(p - text_classes[k]);
+            return (int)k;
+        }
+    }
+
+    return 0;
+}
@@ -16,11 +16,27 @@
  *  fuzz.h: fuzz functions
  */
 
-extern void _zz_fuzzing(char const *);
+#include "common/mutator.h"
+
+extern int _zz_fuzzing(char const *);
 extern void _zz_bytes(char const *);
 extern void _zz_list(char const *);
 extern void zzuf_protect_range(char const *);
 extern void zzuf_refuse_range(char const *);
+extern int _zz_mutator(char const *);
+extern int _zz_fuzzing_bytewise(void);
+
+extern fuzz_settings_t *_zz_settings_new(void);
+extern void _zz_settings_free(fuzz_settings_t *);
+extern int _zz_settings_fuzzing(fuzz_settings_t *, char const *);
+extern void _zz_settings_bytes(fuzz_settings_t *, char const *);
+extern void _zz_settings_protect(fuzz_settings_t *, char const *);
+extern void _zz_settings_refuse(fuzz_settings_t *, char const *);
+extern void _zz_settings_mutator(fuzz_settings_t *, zzuf_mutate_t);
+extern int64_t _zz_settings_flips(fuzz_settings_t const *);
 
 extern void _zz_fuzz(int, volatile uint8_t *, int64_t);
+extern void _zz_fuzz_data(fuzz_context_t *, int64_t, volatile uint8_t *,
+                          int64_t);
+extern int64_t _zz_getflips(void);
 
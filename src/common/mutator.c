@@ -0,0 +1,58 @@
+/*
+ *  zzuf - general purpose fuzzer
+ *
+ *  Copyright © 2002—2015 Sam Hocevar <sam@hocevar.net>
+ *
+ *  This program is free software. It comes without any warranty, to
+ *  the extent permitted by applicable law. You can redistribute it
+ *  and/or modify it under the terms of the Do What the Fuck You Want
+ *  to Public License, Version 2, as published by the WTFPL Task Force.
+ *  See http://www.wtfpl.net/ for more details.
+ */
+
+/*
+ *  mutator.c: mutator plugins
+ *
+ *  Both zzuf, for the stdin and copy modes, and libzzuf load the plugin
+ *  given with --mutator. When one is loaded, it replaces the -f mode.
+ *  Each zzuf_ctx_t may also have its own.
+ */
+
+#include "config.h"
+
+#if defined HAVE_STDINT_H
+#   include <stdint.h>
+#elif defined HAVE_INTTYPES_H
+#   include <inttypes.h>
+#endif
+#include <stdlib.h>
+#if defined HAVE_DLFCN_H
+#   include <dlfcn.h>
+#endif
+
+#include "common.h"
+#include "mutator.h"
+
+/* Load a plugin; returns NULL if it cannot be loaded, does not export
+ * a mutator function or was built for another version of the interface */
+zzuf_mutate_t _zz_mutator_load(char const *path)
+{
+#if defined HAVE_DLFCN_H
+    void *lib = dlopen(path, RTLD_NOW | RTLD_LOCAL);
+    if (!lib)
+        return NULL;
+
+    int const *version = dlsym(lib, ZZUF_MUTATOR_VERSION_SYMBOL);
+    void *sym = dlsym(lib, ZZUF_MUTATE_SYMBOL);
+    if (!sym || (version && *version != ZZUF_MUTATOR_VERSION))
+    {
+        dlclose(lib);
+        return NULL;
+    }
+
+    return (zzuf_mutate_t)sym;
+#else
+    (void)path;
+    return NULL;
+#endif
+}
@@ -0,0 +1,29 @@
+/*
+ *  zzuf - general purpose fuzzer
+ *
+ *  Copyright © 2002—2015 Sam Hocevar <sam@hocevar.net>
+ *
+ *  This program is free software. It comes without any warranty, to
+ *  the extent permitted by applicable law. You can redistribute it
+ *  and/or modify it under the terms of the Do What the Fuck You Want
+ *  to Public License, Version 2, as published by the WTFPL Task Force.
+ *  See http://www.wtfpl.net/ for more details.
+ */
+
+#pragma once
+
+/*
+ *  mutator.h: mutator plugins
+ *
+ *  See zzuf-mutator.h for what plugins must export.
+ */
+
+#include "zzuf-mutator.h"
+
+typedef void (*zzuf_mutate_t)(uint32_t seed, int64_t chunk, double ratio,
+                              uint8_t *buf, size_t len, int64_t pos);
+
+#define ZZUF_MUTATE_SYMBOL "zzuf_mutate"
+#define ZZUF_MUTATOR_VERSION_SYMBOL "zzuf_mutator_version"
+
+extern zzuf_mutate_t _zz_mutator_load(char const *);
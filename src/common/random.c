@@ -29,17 +29,28 @@ static unsigned long ctx = 1;
 
 void zzuf_srand(uint32_t seed)
 {
-    ctx = (seed ^ 0x12345678);
+    zzuf_srand_r(&ctx, seed);
 }
 
 uint32_t zzuf_rand(uint32_t max)
+{
+    return zzuf_rand_r(&ctx, max);
+}
+
+/* Reentrant versions, with the generator state kept by the caller */
+void zzuf_srand_r(unsigned long *state, uint32_t seed)
+{
+    *state = (seed ^ 0x12345678);
+}
+
+uint32_t zzuf_rand_r(unsigned long *state, uint32_t max)
 {
     /* Could be better, but do we care? */
-    long hi = ctx / 12773L;
-    long lo = ctx % 12773L;
+    long hi = *state / 12773L;
+    long lo = *state % 12773L;
     long x = 16807L * lo - 2836L * hi;
     if (x <= 0)
         x += 0x7fffffffL;
-    return (ctx = x) % (unsigned long)max;
+    return (*state = x) % (unsigned long)max;
 }
 
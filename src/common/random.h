@@ -18,4 +18,6 @@
 
 void zzuf_srand(uint32_t);
 uint32_t zzuf_rand(uint32_t);
+void zzuf_srand_r(unsigned long *, uint32_t);
+uint32_t zzuf_rand_r(unsigned long *, uint32_t);
 
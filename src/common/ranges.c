@@ -27,14 +27,18 @@
 #include "common.h"
 #include "ranges.h"
 
+static char const *item_end(char const *);
+static int unescape(char const **);
+
 /* This function converts a string containing a list of ranges in the format
  * understood by cut(1) such as "1-5,8,10-" into a C array for lookup.
- * If more than 256 slots are required, new memory is allocated, otherwise
- * the static array static_ranges is used. It is the caller's duty to call
- * free() if the returned value is not static_ranges. */
-int64_t *_zz_allocrange(char const *list, int64_t static_ranges[256])
+ * Each range takes two slots, plus two for the terminator. If 256 ranges
+ * or more are given, new memory is allocated, otherwise the static array
+ * static_ranges, which must have 512 slots, is used. It is the caller's
+ * duty to call free() if the returned value is not static_ranges. */
+int64_t *_zz_allocrange(char const *list, int64_t static_ranges[512])
 {
-    char const *parser;
+    char const *parser, *comma;
     int64_t *ranges;
     unsigned int i, chunks;
 
@@ -48,20 +52,30 @@ int64_t *_zz_allocrange(char const *list, int64_t static_ranges[256])
     else
         ranges = static_ranges;
 
-    /* Fill ranges list */
-    for (parser = list, i = 0; i < chunks; ++i)
+    /* Fill ranges list; markers are handled by _zz_allocmarkers() and
+     * weights by _zz_allocweights() */
+    for (parser = list, i = 0; ; parser = comma + 1)
     {
-        char const *comma = strchr(parser, ',');
-        char const *dash = strchr(parser, '-');
-
-        ranges[i * 2] = (dash == parser) ? 0 : atoi(parser);
-        if (dash && (dash + 1 == comma || dash[1] == '\0'))
-            ranges[i * 2 + 1] = ranges[i * 2]; /* special case */
-        else if (dash && (!comma || dash < comma))
-            ranges[i * 2 + 1] = atoi(dash + 1) + 1;
-        else
-            ranges[i * 2 + 1] = ranges[i * 2] + 1;
-        parser = comma + 1;
+        comma = item_end(parser);
+
+        if (*parser != '@')
+        {
+            char const *at = memchr(parser, '@', comma - parser);
+            char const *stop = at ? at : comma;
+            char const *dash = memchr(parser, '-', stop - parser);
+
+            ranges[i * 2] = (dash == parser) ? 0 : atoi(parser);
+            if (dash && dash + 1 == stop)
+                ranges[i * 2 + 1] = ranges[i * 2]; /* special case */
+            else if (dash)
+                ranges[i * 2 + 1] = atoi(dash + 1) + 1;
+            else
+                ranges[i * 2 + 1] = ranges[i * 2] + 1;
+            ++i;
+        }
+
+        if (!*comma)
+            break;
     }
 
     ranges[i * 2] = ranges[i * 2 + 1] = 0;
@@ -69,6 +83,118 @@ int64_t *_zz_allocrange(char const *list, int64_t static_ranges[256])
     return ranges;
 }
 
+/* This function extracts the per-range fuzzing ratios of a list such as
+ * "0-63@0.05,64-@0.0005". Ranges without a ratio get -1.0, meaning the
+ * default ratio. Returns NULL if no range has a ratio. If more than 256
+ * slots are required, new memory is allocated, otherwise the static array
+ * static_weights is used; see _zz_allocrange(). */
+double *_zz_allocweights(char const *list, double static_weights[256])
+{
+    char const *parser, *comma;
+    double *weights;
+    unsigned int i, chunks, found = 0;
+
+    for (parser = list, chunks = 1; *parser; ++parser)
+        if (*parser == ',')
+            chunks++;
+
+    if (chunks >= 256)
+        weights = malloc(chunks * sizeof(double));
+    else
+        weights = static_weights;
+
+    for (parser = list, i = 0; ; parser = comma + 1)
+    {
+        comma = item_end(parser);
+
+        if (*parser != '@')
+        {
+            char const *at = memchr(parser, '@', comma - parser);
+
+            weights[i] = -1.0;
+            if (at)
+            {
+                weights[i] = atof(at + 1);
+                if (weights[i] < 0.0)
+                    weights[i] = 0.0;
+                if (weights[i] > MAX_RATIO)
+                    weights[i] = MAX_RATIO;
+                found = 1;
+            }
+            ++i;
+        }
+
+        if (!*comma)
+            break;
+    }
+
+    if (!found)
+    {
+        if (weights != static_weights)
+            free(weights);
+        return NULL;
+    }
+
+    return weights;
+}
+
+/* This function extracts the markers of a list, such as "@IDAT+0-99" for
+ * the 100 bytes after each "IDAT" or "@\r\n\r\n" for everything after
+ * the first empty line. Markers may use C escapes such as \r or \x00,
+ * and must escape commas and plus signs. At most max markers are kept.
+ * Returns the number of markers. */
+int _zz_allocmarkers(char const *list, zzuf_marker_t *markers, int max)
+{
+    char const *parser, *comma;
+    int n = 0;
+
+    for (parser = list; ; parser = comma + 1)
+    {
+        comma = item_end(parser);
+
+        if (*parser == '@' && n < max)
+        {
+            zzuf_marker_t *m = &markers[n];
+            char const *p = parser + 1;
+
+            m->len = 0;
+            while (p < comma && *p != '+')
+            {
+                int ch = unescape(&p);
+                if (m->len < MAX_MARKER_LEN)
+                    m->data[m->len++] = (uint8_t)ch;
+            }
+
+            /* Without a range, fuzz everything after the marker */
+            m->start = 0;
+            m->stop = -1;
+            if (p < comma)
+            {
+                ++p;
+                char const *at = memchr(p, '@', comma - p);
+                char const *stop = at ? at : comma;
+                char const *dash = memchr(p, '-', stop - p);
+
+                m->start = (dash == p) ? 0 : atoi(p);
+                if (dash && dash + 1 == stop)
+                    m->stop = -1;
+                else if (dash)
+                    m->stop = atoi(dash + 1) + 1;
+                else
+                    m->stop = m->start + 1;
+            }
+
+            if (m->len)
+                ++n;
+        }
+
+        if (!*comma)
+            break;
+    }
+
+    return n;
+}
+
 int _zz_isinrange(int64_t value, int64_t const *ranges)
 {
     int64_t const *r;
@@ -83,3 +209,46 @@ int _zz_isinrange(int64_t value, int64_t const *ranges)
     return 0;
 }
 
+
+/* Find the end of a list item: the next comma that is not escaped with
+ * a backslash, or the end of the list. */
+static char const *item_end(char const *item)
+{
+    for (; *item && *item != ','; ++item)
+        if (*item == '\\' && item[1])
+            ++item;
+
+    return item;
+}
+
+/* Read one possibly escaped character and move past it */
+static int unescape(char const **str)
+{
+    static char const hex[] = "0123456789abcdef0123456789ABCDEF";
+    char const *p = *str;
+    int ch;
+
+    if (p[0] != '\\' || !p[1])
+        ch = (unsigned char)*p++;
+    else if (p[1] == 'n')
+        ch = '\n', p += 2;
+    else if (p[1] == 'r')
+        ch = '\r', p += 2;
+    else if (p[1] == 't')
+        ch = '\t', p += 2;
+    else if ((p[1] == 'x' || p[1] == 'X')
+              && p[2] && strchr(hex, p[2]) && p[3] && strchr(hex, p[3]))
+    {
+        ch = ((int)(strchr(hex, p[2]) - hex) & 0xf) << 4;
+        ch |= (int)(strchr(hex, p[3]) - hex) & 0xf;
+        p += 4;
+    }
+    else
+    {
+        ch = (unsigned char)p[1];
+        p += 2;
+    }
+
+    *str = p;
+    return ch;
+}
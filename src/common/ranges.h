@@ -16,6 +16,18 @@
  *  ranges.c: range handling helper functions
  */
 
-int64_t *_zz_allocrange(char const *, int64_t[256]);
+#include "common/common.h"
+
+typedef struct zzuf_marker
+{
+    uint8_t data[MAX_MARKER_LEN];
+    int len;
+    /* Offsets to fuzz after each match; stop is -1 for the end of file */
+    int64_t start, stop;
+} zzuf_marker_t;
+
+int64_t *_zz_allocrange(char const *, int64_t[512]);
+double *_zz_allocweights(char const *, double[256]);
+int _zz_allocmarkers(char const *, zzuf_marker_t *, int);
 int _zz_isinrange(int64_t, int64_t const *);
 
@@ -0,0 +1,322 @@
+/*
+ *  zzuf - general purpose fuzzer
+ *
+ *  Copyright © 2002—2015 Sam Hocevar <sam@hocevar.net>
+ *
+ *  This program is free software. It comes without any warranty, to
+ *  the extent permitted by applicable law. You can redistribute it
+ *  and/or modify it under the terms of the Do What the Fuck You Want
+ *  to Public License, Version 2, as published by the WTFPL Task Force.
+ *  See http://www.wtfpl.net/ for more details.
+ */
+
+/*
+ *  resize.c: insertion and deletion of byte runs
+ *
+ *  Each chunk of the original ("physical") data gets its own edits, which
+ *  only depend on the seed, the chunk index and the edit ratio, just like
+ *  fuzzing masks. The fuzzed ("logical") data is the concatenation of the
+ *  edited chunks. A map remembers where each edited chunk starts in the
+ *  logical data, so that logical offsets are found by binary search. The
+ *  map is built lazily, so only seeking to the end of a file requires
+ *  computing the edits of all its chunks.
+ */
+
+#include "config.h"
+
+#if defined HAVE_STDINT_H
+#   include <stdint.h>
+#elif defined HAVE_INTTYPES_H
+#   include <inttypes.h>
+#endif
+#include <stdlib.h>
+#include <string.h>
+
+#include "common.h"
+#include "random.h"
+#include "resize.h"
+
+#define MAGIC1 0x6e9d8b1f
+#define MAGIC2 0x2c5f0a73
+#define MAGIC3 0xd1b54a33
+
+/* An edit at a given offset of a chunk: a deletion of len bytes, or an
+ * insertion of len bytes from the pool before the byte at offset. */
+struct edit
+{
+    int offset, len, insert;
+};
+
+struct zzuf_resize
+{
+    uint32_t seed;
+    int64_t size, nchunks;
+    /* Logical offsets of the first known chunks, plus the end of the
+     * last one */
+    int64_t *starts, known;
+    /* The last edited chunk */
+    int64_t cur;
+    int curlen;
+    uint8_t data[CHUNKBYTES + MAX_CHUNK_EDITS * MAX_EDIT_LEN];
+};
+
+/* Probability that an edit starts at a given byte; 0 means no edits */
+static double ratio = 0.0;
+
+static int get_edits(uint32_t seed, int64_t chunk, int len,
+                     struct edit *edits, uint8_t *pool);
+static int chunk_length(struct edit const *edits, int n, int len);
+static void learn_chunk(zzuf_resize_t *rs);
+
+void _zz_set_resize(double r)
+{
+    ratio = r;
+}
+
+double _zz_get_resize(void)
+{
+    return ratio;
+}
+
+/* Edit the len bytes of a chunk, and return the new length, which is at
+ * most CHUNKBYTES + MAX_CHUNK_EDITS * MAX_EDIT_LEN. */
+int _zz_resize_chunk(uint32_t seed, int64_t chunk, uint8_t const *in,
+                     int len, uint8_t *out)
+{
+    struct edit edits[MAX_CHUNK_EDITS];
+    uint8_t pool[MAX_CHUNK_EDITS * MAX_EDIT_LEN];
+    int n = get_edits(seed, chunk, len, edits, pool), ret = 0, deleted = 0;
+
+    for (int i = 0, k = 0; i < len; ++i)
+    {
+        for (; k < n && edits[k].offset == i; ++k)
+        {
+            if (edits[k].insert >= 0)
+            {
+                memcpy(out + ret, pool + edits[k].insert, edits[k].len);
+                ret += edits[k].len;
+            }
+            else if (i + edits[k].len > deleted)
+                deleted = i + edits[k].len;
+        }
+
+        if (i >= deleted)
+            out[ret++] = in[i];
+    }
+
+    return ret;
+}
+
+zzuf_resize_t *_zz_resize_new(uint32_t seed, int64_t size)
+{
+    zzuf_resize_t *rs = malloc(sizeof(zzuf_resize_t));
+
+    rs->seed = seed;
+    rs->size = size;
+    rs->nchunks = (size + CHUNKBYTES - 1) / CHUNKBYTES;
+    rs->starts = malloc((rs->nchunks + 1) * sizeof(int64_t));
+    rs->starts[0] = 0;
+    rs->known = 1;
+    rs->cur = -1;
+
+    return rs;
+}
+
+void _zz_resize_free(zzuf_resize_t *rs)
+{
+    free(rs->starts);
+    free(rs);
+}
+
+/* Size of the logical data */
+int64_t _zz_resize_size(zzuf_resize_t *rs)
+{
+    while (rs->known <= rs->nchunks)
+        learn_chunk(rs);
+
+    return rs->starts[rs->nchunks];
+}
+
+/* Index of the chunk where a logical offset is, or -1 past the end */
+int64_t _zz_resize_find(zzuf_resize_t *rs, int64_t pos)
+{
+    while (rs->known <= rs->nchunks && rs->starts[rs->known - 1] <= pos)
+        learn_chunk(rs);
+
+    if (pos < 0 || pos >= rs->starts[rs->known - 1])
+        return -1;
+
+    /* starts[lo] <= pos < starts[hi] */
+    int64_t lo = 0, hi = rs->known - 1;
+    while (hi - lo > 1)
+    {
+        int64_t mid = (lo + hi) / 2;
+
+        if (rs->starts[mid] <= pos)
+            lo = mid;
+        else
+            hi = mid;
+    }
+
+    return lo;
+}
+
+/* Physical offset of the byte at a logical offset. Inserted bytes map to
+ * the byte they were inserted before. */
+int64_t _zz_resize_tophys(zzuf_resize_t *rs, int64_t pos)
+{
+    int64_t chunk = _zz_resize_find(rs, pos);
+
+    if (chunk < 0)
+        return pos < 0 ? 0 : rs->size + pos - _zz_resize_size(rs);
+
+    struct edit edits[MAX_CHUNK_EDITS];
+    uint8_t pool[MAX_CHUNK_EDITS * MAX_EDIT_LEN];
+    int len = (int)(chunk + 1 < rs->nchunks ? CHUNKBYTES
+                                            : rs->size - chunk * CHUNKBYTES);
+    int n = get_edits(rs->seed, chunk, len, edits, pool);
+    int64_t todo = pos - rs->starts[chunk];
+    int i, k = 0, deleted = 0;
+
+    for (i = 0; i < len; ++i)
+    {
+        for (; k < n && edits[k].offset == i; ++k)
+        {
+            if (edits[k].insert < 0)
+            {
+                if (i + edits[k].len > deleted)
+                    deleted = i + edits[k].len;
+            }
+            else if (todo < edits[k].len)
+                return chunk * CHUNKBYTES + i;
+            else
+                todo -= edits[k].len;
+        }
+
+        if (i >= deleted && todo-- == 0)
+            break;
+    }
+
+    return chunk * CHUNKBYTES + i;
+}
+
+int _zz_resize_cached(zzuf_resize_t const *rs, int64_t chunk)
+{
+    return rs->cur == chunk;
+}
+
+/* Edit a chunk of fuzzed physical data and keep it for _zz_resize_copy() */
+void _zz_resize_load(zzuf_resize_t *rs, int64_t chunk,
+                     uint8_t const *in, int len)
+{
+    rs->curlen = _zz_resize_chunk(rs->seed, chunk, in, len, rs->data);
+    rs->cur = chunk;
+}
+
+/* Copy logical data from the chunk loaded last, which must contain pos,
+ * and return the number of bytes copied. */
+int64_t _zz_resize_copy(zzuf_resize_t *rs, int64_t pos, uint8_t *buf,
+                        int64_t count)
+{
+    int64_t offset = pos - rs->starts[rs->cur];
+
+    if (count > rs->curlen - offset)
+        count = rs->curlen - offset;
+
+    memcpy(buf, rs->data + offset, count);
+    return count;
+}
+
+/* Get the edits of a chunk of len bytes, sorted by offset. Edits that do
+ * not fit in len bytes are dropped, but the same random numbers are used
+ * whatever len is, so that a chunk is edited the same way whether or not
+ * it is the last one. */
+static int get_edits(uint32_t seed, int64_t chunk, int len,
+                     struct edit *edits, uint8_t *pool)
+{
+    unsigned long rng;
+    uint32_t chunkseed;
+    int n = 0, used = 0;
+
+    chunkseed = (uint32_t)chunk;
+    chunkseed ^= MAGIC2;
+    chunkseed += (uint32_t)(ratio * MAGIC1);
+    chunkseed ^= seed;
+    chunkseed += (uint32_t)(chunk * MAGIC3);
+
+    zzuf_srand_r(&rng, chunkseed);
+
+    int todo = (int)((ratio * CHUNKBYTES * 1000000.0
+                        + zzuf_rand_r(&rng, 1000000)) / 1000000.0);
+    if (todo > MAX_CHUNK_EDITS)
+        todo = MAX_CHUNK_EDITS;
+
+    while (todo--)
+    {
+        struct edit e;
+
+        e.offset = zzuf_rand_r(&rng, CHUNKBYTES);
+        e.len = 1 + zzuf_rand_r(&rng, MAX_EDIT_LEN);
+        e.insert = -1;
+
+        if (zzuf_rand_r(&rng, 2))
+        {
+            e.insert = used;
+            for (int k = 0; k < e.len; ++k)
+                pool[used++] = (uint8_t)zzuf_rand_r(&rng, 256);
+        }
+
+        if (e.offset >= len)
+            continue;
+
+        /* Keep edits sorted, and in the order they were drawn */
+        int k = n++;
+        for (; k > 0 && edits[k - 1].offset > e.offset; --k)
+            edits[k] = edits[k - 1];
+        edits[k] = e;
+    }
+
+    return n;
+}
+
+/* Length of a chunk of len bytes after its edits */
+static int chunk_length(struct edit const *edits, int n, int len)
+{
+    int ret = len, deleted = 0;
+
+    for (int k = 0; k < n; ++k)
+    {
+        if (edits[k].insert >= 0)
+        {
+            ret += edits[k].len;
+            continue;
+        }
+
+        /* Deletions may overlap */
+        int start = edits[k].offset > deleted ? edits[k].offset : deleted;
+        int end = edits[k].offset + edits[k].len < len
+                ? edits[k].offset + edits[k].len : len;
+
+        if (end > start)
+        {
+            ret -= end - start;
+            deleted = end;
+        }
+    }
+
+    return ret;
+}
+
+/* Compute where the next unknown chunk ends */
+static void learn_chunk(zzuf_resize_t *rs)
+{
+    struct edit edits[MAX_CHUNK_EDITS];
+    uint8_t pool[MAX_CHUNK_EDITS * MAX_EDIT_LEN];
+    int64_t chunk = rs->known - 1;
+    int len = (int)(chunk + 1 < rs->nchunks ? CHUNKBYTES
+                                            : rs->size - chunk * CHUNKBYTES);
+    int n = get_edits(rs->seed, chunk, len, edits, pool);
+
+    rs->starts[rs->known] = rs->starts[chunk] + chunk_length(edits, n, len);
+    ++rs->known;
+}
@@ -0,0 +1,36 @@
+/*
+ *  zzuf - general purpose fuzzer
+ *
+ *  Copyright © 2002—2015 Sam Hocevar <sam@hocevar.net>
+ *
+ *  This program is free software. It comes without any warranty, to
+ *  the extent permitted by applicable law. You can redistribute it
+ *  and/or modify it under the terms of the Do What the Fuck You Want
+ *  to Public License, Version 2, as published by the WTFPL Task Force.
+ *  See http://www.wtfpl.net/ for more details.
+ */
+
+#pragma once
+
+/*
+ *  resize.h: insertion and deletion of byte runs
+ */
+
+typedef struct zzuf_resize zzuf_resize_t;
+
+extern void _zz_set_resize(double);
+extern double _zz_get_resize(void);
+
+extern int _zz_resize_chunk(uint32_t seed, int64_t chunk,
+                            uint8_t const *in, int len, uint8_t *out);
+
+extern zzuf_resize_t *_zz_resize_new(uint32_t seed, int64_t size);
+extern void _zz_resize_free(zzuf_resize_t *);
+extern int64_t _zz_resize_size(zzuf_resize_t *);
+extern int64_t _zz_resize_find(zzuf_resize_t *, int64_t pos);
+extern int64_t _zz_resize_tophys(zzuf_resize_t *, int64_t pos);
+extern int _zz_resize_cached(zzuf_resize_t const *, int64_t chunk);
+extern void _zz_resize_load(zzuf_resize_t *, int64_t chunk,
+                            uint8_t const *in, int len);
+extern int64_t _zz_resize_copy(zzuf_resize_t *, int64_t pos,
+                               uint8_t *buf, int64_t count);
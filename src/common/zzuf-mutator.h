@@ -0,0 +1,46 @@
+/*
+ *  zzuf - general purpose fuzzer
+ *
+ *  Copyright © 2002—2015 Sam Hocevar <sam@hocevar.net>
+ *
+ *  This program is free software. It comes without any warranty, to
+ *  the extent permitted by applicable law. You can redistribute it
+ *  and/or modify it under the terms of the Do What the Fuck You Want
+ *  to Public License, Version 2, as published by the WTFPL Task Force.
+ *  See http://www.wtfpl.net/ for more details.
+ */
+
+#pragma once
+
+/*
+ *  zzuf-mutator.h: mutator plugins for zzuf --mutator
+ *
+ *  A plugin is a shared object that exports zzuf_mutate(). It is called
+ *  once for each part of a chunk that gets fuzzed, and changes the len
+ *  bytes in buf, which are found at offset pos of the data and belong to
+ *  the given chunk. The same chunk may be seen in several parts, or more
+ *  than once, so the new value of a byte must only depend on seed, ratio,
+ *  chunk, its offset and the data.
+ *
+ *  A plugin should also define zzuf_mutator_version as
+ *  ZZUF_MUTATOR_VERSION, so that zzuf refuses it if this interface ever
+ *  changes. Plugins that do not define it are assumed to use version 1.
+ */
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define ZZUF_MUTATOR_VERSION 1
+
+extern int const zzuf_mutator_version;
+
+extern void zzuf_mutate(uint32_t seed, int64_t chunk, double ratio,
+                        uint8_t *buf, size_t len, int64_t pos);
+
+#ifdef __cplusplus
+}
+#endif
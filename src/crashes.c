@@ -0,0 +1,225 @@
+/*
+ *  zzuf - general purpose fuzzer
+ *
+ *  Copyright © 2002—2015 Sam Hocevar <sam@hocevar.net>
+ *
+ *  This program is free software. It comes without any warranty, to
+ *  the extent permitted by applicable law. You can redistribute it
+ *  and/or modify it under the terms of the Do What the Fuck You Want
+ *  to Public License, Version 2, as published by the WTFPL Task Force.
+ *  See http://www.wtfpl.net/ for more details.
+ */
+
+/*
+ *  crashes.c: crash bucketing
+ *
+ *  Crashes are put in buckets according to a hash of what killed the
+ *  child ("signal 11", "exit 1"...) and of the top of its stack, as found
+ *  in the crash record sent by libzzuf (see the -K flag). Only the module
+ *  and offset of each frame are used, since addresses change with ASLR.
+ *  Leading frames within the C library are skipped so that, for instance,
+ *  all abort() calls or memcpy() overflows do not end up together.
+ */
+
+#include "config.h"
+
+#define _DEFAULT_SOURCE /* for strdup() */
+
+#if defined HAVE_STDINT_H
+#   include <stdint.h>
+#elif defined HAVE_INTTYPES_H
+#   include <inttypes.h>
+#endif
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "crashes.h"
+
+/* Number of stack frames that make a bucket */
+#define TOP_FRAMES 3
+
+struct bucket
+{
+    uint32_t hash;
+    char *kind, *top;
+    int count;
+    uint32_t first_seed, best_seed;
+    double first_ratio, best_ratio;
+};
+
+struct zzuf_crashes
+{
+    struct bucket *buckets;
+    int nbuckets, total;
+};
+
+static void get_top(char const *record, char *top, size_t size);
+static uint32_t fnv1a(uint32_t hash, char const *str);
+
+zzuf_crashes_t *zzuf_create_crashes(void)
+{
+    zzuf_crashes_t *cr = malloc(sizeof(zzuf_crashes_t));
+
+    cr->buckets = NULL;
+    cr->nbuckets = cr->total = 0;
+
+    return cr;
+}
+
+void zzuf_destroy_crashes(zzuf_crashes_t *cr)
+{
+    if (!cr)
+        return;
+
+    for (int i = 0; i < cr->nbuckets; ++i)
+    {
+        free(cr->buckets[i].kind);
+        free(cr->buckets[i].top);
+    }
+    free(cr->buckets);
+    free(cr);
+}
+
+/*
+ * Put a crash in its bucket. The record may be NULL if the child sent no
+ * crash information, in which case only the kind of crash is used. We
+ * remember the first seed and the seed with the smallest ratio, since it
+ * is usually the easiest to analyse. Returns the bucket's hash and stores
+ * the number of crashes in that bucket, including this one, in *count.
+ */
+uint32_t zz_crashes_add(zzuf_crashes_t *cr, char const *kind,
+                        char const *record, uint32_t seed, double ratio,
+                        int *count)
+{
+    char top[BUFSIZ];
+
+    get_top(record, top, sizeof(top));
+    uint32_t hash = fnv1a(fnv1a(2166136261u, kind), top);
+
+    struct bucket *b = NULL;
+    for (int i = 0; i < cr->nbuckets && !b; ++i)
+        if (cr->buckets[i].hash == hash && !strcmp(cr->buckets[i].kind, kind)
+             && !strcmp(cr->buckets[i].top, top))
+            b = &cr->buckets[i];
+
+    if (!b)
+    {
+        cr->buckets = realloc(cr->buckets,
+                              (cr->nbuckets + 1) * sizeof(struct bucket));
+        b = &cr->buckets[cr->nbuckets++];
+        b->hash = hash;
+        b->kind = strdup(kind);
+        b->top = strdup(top);
+        b->count = 0;
+        b->first_seed = b->best_seed = seed;
+        b->first_ratio = b->best_ratio = ratio;
+    }
+    else if (ratio < b->best_ratio)
+    {
+        b->best_seed = seed;
+        b->best_ratio = ratio;
+    }
+
+    ++cr->total;
+    *count = ++b->count;
+    return hash;
+}
+
+/*
+ * Print one line per bucket, most frequent first.
+ */
+void zz_crashes_summary(zzuf_crashes_t *cr, FILE *fp)
+{
+    if (!cr->total)
+        return;
+
+    fprintf(fp, "zzuf: %i crash%s in %i bucket%s\n", cr->total,
+            cr->total > 1 ? "es" : "", cr->nbuckets,
+            cr->nbuckets > 1 ? "s" : "");
+
+    int *order = malloc(cr->nbuckets * sizeof(int));
+    for (int i = 0; i < cr->nbuckets; ++i)
+    {
+        /* Insertion sort is fine, there are few buckets */
+        int j = i;
+        for ( ; j > 0 && cr->buckets[order[j - 1]].count
+                           < cr->buckets[i].count; --j)
+            order[j] = order[j - 1];
+        order[j] = i;
+    }
+
+    for (int i = 0; i < cr->nbuckets; ++i)
+    {
+        struct bucket *b = &cr->buckets[order[i]];
+        fprintf(fp, "zzuf: bucket %08x: %s, %i time%s, first s=%i r=%g, "
+                "smallest s=%i r=%g%s%s\n", b->hash, b->kind, b->count,
+                b->count > 1 ? "s" : "", b->first_seed, b->first_ratio,
+                b->best_seed, b->best_ratio, *b->top ? ", top" : "", b->top);
+    }
+
+    free(order);
+}
+
+/*
+ * Extract the "module+offset" part of the innermost stack frames of a
+ * crash record, which looks like "... pc 0x1234(foo+0x234) ... bt
+ * 0x1234(foo+0x234) 0x5678(libfoo.so+0x678) ...".
+ */
+static void get_top(char const *record, char *top, size_t size)
+{
+    char const *tmp;
+    int frames = 0, skipping = 1;
+
+    *top = '\0';
+    if (!record)
+        return;
+
+    tmp = strstr(record, " bt ");
+    if (!tmp)
+        tmp = strstr(record, " pc ");
+    if (!tmp)
+        return;
+
+    for (tmp += 4; *tmp && frames < TOP_FRAMES; )
+    {
+        char const *start = strchr(tmp, '('), *end;
+        if (!start || !(end = strchr(start, ')')))
+            break;
+        ++start;
+
+        /* Skip leading libc frames, unless that is all we have */
+        if (skipping && (!strncmp(start, "libc.", 5)
+                          || !strncmp(start, "libc-", 5)))
+        {
+            tmp = end + 1;
+            continue;
+        }
+        skipping = 0;
+
+        size_t len = strlen(top);
+        if (len + (end - start) + 2 > size)
+            break;
+        sprintf(top + len, " %.*s", (int)(end - start), start);
+        ++frames;
+        tmp = end + 1;
+    }
+
+    /* The crash happened in libc and we saw nothing else */
+    if (skipping && strchr(record, '('))
+    {
+        tmp = strchr(record, '(');
+        size_t len = strcspn(tmp + 1, ")");
+        if (len + 2 <= size)
+            sprintf(top, " %.*s", (int)len, tmp + 1);
+    }
+}
+
+static uint32_t fnv1a(uint32_t hash, char const *str)
+{
+    do
+        hash = (hash ^ (uint8_t)*str) * 16777619u;
+    while (*str++);
+
+    return hash;
+}
@@ -0,0 +1,29 @@
+/*
+ *  zzuf - general purpose fuzzer
+ *
+ *  Copyright © 2002—2015 Sam Hocevar <sam@hocevar.net>
+ *
+ *  This program is free software. It comes without any warranty, to
+ *  the extent permitted by applicable law. You can redistribute it
+ *  and/or modify it under the terms of the Do What the Fuck You Want
+ *  to Public License, Version 2, as published by the WTFPL Task Force.
+ *  See http://www.wtfpl.net/ for more details.
+ */
+
+#pragma once
+
+/*
+ *  crashes.h: crash bucketing
+ */
+
+#include <stdio.h>
+
+typedef struct zzuf_crashes zzuf_crashes_t;
+
+extern zzuf_crashes_t *zzuf_create_crashes(void);
+extern void zzuf_destroy_crashes(zzuf_crashes_t *);
+
+extern uint32_t zz_crashes_add(zzuf_crashes_t *, char const *kind,
+                               char const *record, uint32_t seed,
+                               double ratio, int *count);
+extern void zz_crashes_summary(zzuf_crashes_t *, FILE *);
@@ -0,0 +1,214 @@
+/*
+ *  zzuf - general purpose fuzzer
+ *
+ *  Copyright © 2002—2015 Sam Hocevar <sam@hocevar.net>
+ *
+ *  This program is free software. It comes without any warranty, to
+ *  the extent permitted by applicable law. You can redistribute it
+ *  and/or modify it under the terms of the Do What the Fuck You Want
+ *  to Public License, Version 2, as published by the WTFPL Task Force.
+ *  See http://www.wtfpl.net/ for more details.
+ */
+
+/*
+ *  dedup.c: detection of seeds that fuzz their input like another seed
+ *
+ *  When we know every input that will be fuzzed, we can fuzz it ourselves
+ *  before launching a child: fuzzing only depends on the seed, the ratio
+ *  and the offset of each byte, not on how the child reads its input.
+ *  Seeds that do not change anything, or that produce exactly the same
+ *  inputs as a seed that was already run, need not be run at all. We only
+ *  keep a 64-bit hash of each set of fuzzed inputs.
+ */
+
+#include "config.h"
+
+#if defined HAVE_STDINT_H
+#   include <stdint.h>
+#elif defined HAVE_INTTYPES_H
+#   include <inttypes.h>
+#endif
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "common.h"
+#include "fd.h"
+#include "fuzz.h"
+#include "util/mmh3.h"
+#include "dedup.h"
+
+struct input
+{
+    uint8_t *data;
+    int64_t len;
+};
+
+struct zzuf_dedup
+{
+    struct input *inputs;
+    int ninputs;
+    uint8_t *buf; /* fuzzed copy of the largest input */
+    int64_t bufsize;
+
+    /* Hashes of the inputs seen so far; 0 means an empty slot */
+    uint64_t *set;
+    size_t size, count;
+
+    int64_t unchanged, duplicates;
+};
+
+static int add_input(zzuf_dedup_t *dd, uint8_t *data, int64_t len);
+static int insert(zzuf_dedup_t *dd, uint64_t hash);
+
+zzuf_dedup_t *zzuf_create_dedup(void)
+{
+    zzuf_dedup_t *dd = calloc(1, sizeof(zzuf_dedup_t));
+
+    dd->size = 1024;
+    dd->set = calloc(dd->size, sizeof(uint64_t));
+
+    return dd;
+}
+
+void zzuf_destroy_dedup(zzuf_dedup_t *dd)
+{
+    for (int i = 0; i < dd->ninputs; ++i)
+        free(dd->inputs[i].data);
+    free(dd->inputs);
+    free(dd->buf);
+    free(dd->set);
+    free(dd);
+}
+
+/*
+ * Add the contents of a file to the inputs. Returns -1 if it cannot be
+ * read, in which case children will not be able to read it either.
+ */
+int zz_dedup_add_file(zzuf_dedup_t *dd, char const *path)
+{
+    FILE *fp = fopen(path, "rb");
+    if (!fp)
+        return -1;
+
+    uint8_t *data = NULL;
+    int64_t len = 0;
+    for (;;)
+    {
+        data = realloc(data, len + BUFSIZ);
+        size_t n = fread(data + len, 1, BUFSIZ, fp);
+        if (n == 0)
+            break;
+        len += n;
+    }
+    fclose(fp);
+
+    return add_input(dd, data, len);
+}
+
+/*
+ * Fuzz all inputs using the current seed and ratio, and tell whether
+ * this gives anything new.
+ */
+enum dedup zz_dedup_check(zzuf_dedup_t *dd)
+{
+    zzuf_mmh3_t *ctx = zzuf_create_mmh3();
+    int changed = 0;
+
+    for (int i = 0; i < dd->ninputs; ++i)
+    {
+        struct input *in = &dd->inputs[i];
+
+        if (!in->len)
+            continue;
+
+        memcpy(dd->buf, in->data, in->len);
+        _zz_register(i);
+        _zz_fuzz(i, dd->buf, in->len);
+        _zz_unregister(i);
+
+        changed |= memcmp(dd->buf, in->data, in->len) != 0;
+        zz_mmh3_add(ctx, dd->buf, in->len);
+    }
+
+    uint8_t digest[16];
+    uint64_t hash;
+    zzuf_destroy_mmh3(digest, ctx);
+    memcpy(&hash, digest, sizeof(hash));
+
+    if (!changed)
+    {
+        ++dd->unchanged;
+        return DEDUP_UNCHANGED;
+    }
+
+    if (!insert(dd, hash ? hash : 1))
+    {
+        ++dd->duplicates;
+        return DEDUP_DUPLICATE;
+    }
+
+    return DEDUP_NEW;
+}
+
+void zz_dedup_summary(zzuf_dedup_t *dd, FILE *fp)
+{
+    int64_t skipped = dd->unchanged + dd->duplicates;
+
+    fprintf(fp, "zzuf: skipped %lli seed%s (%lli unchanged input%s, "
+            "%lli duplicate input%s)\n",
+            (long long int)skipped, skipped > 1 ? "s" : "",
+            (long long int)dd->unchanged, dd->unchanged > 1 ? "s" : "",
+            (long long int)dd->duplicates, dd->duplicates > 1 ? "s" : "");
+}
+
+static int add_input(zzuf_dedup_t *dd, uint8_t *data, int64_t len)
+{
+    dd->inputs = realloc(dd->inputs,
+                         (dd->ninputs + 1) * sizeof(struct input));
+    dd->inputs[dd->ninputs].data = data;
+    dd->inputs[dd->ninputs].len = len;
+    dd->ninputs++;
+
+    if (len > dd->bufsize)
+    {
+        dd->bufsize = len;
+        dd->buf = realloc(dd->buf, len);
+    }
+
+    return 0;
+}
+
+/*
+ * Insert a hash unless it is already there. Returns 1 if it was added.
+ */
+static int insert(zzuf_dedup_t *dd, uint64_t hash)
+{
+    /* Keep the table at most half full */
+    if ((dd->count + 1) * 2 > dd->size)
+    {
+        uint64_t *old = dd->set;
+        size_t oldsize = dd->size;
+
+        dd->size *= 2;
+        dd->set = calloc(dd->size, sizeof(uint64_t));
+        dd->count = 0;
+        for (size_t i = 0; i < oldsize; ++i)
+            if (old[i])
+                insert(dd, old[i]);
+        free(old);
+    }
+
+    for (size_t i = hash & (dd->size - 1); ; i = (i + 1) & (dd->size - 1))
+    {
+        if (dd->set[i] == hash)
+            return 0;
+
+        if (!dd->set[i])
+        {
+            dd->set[i] = hash;
+            ++dd->count;
+            return 1;
+        }
+    }
+}
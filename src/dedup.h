@@ -0,0 +1,35 @@
+/*
+ *  zzuf - general purpose fuzzer
+ *
+ *  Copyright © 2002—2015 Sam Hocevar <sam@hocevar.net>
+ *
+ *  This program is free software. It comes without any warranty, to
+ *  the extent permitted by applicable law. You can redistribute it
+ *  and/or modify it under the terms of the Do What the Fuck You Want
+ *  to Public License, Version 2, as published by the WTFPL Task Force.
+ *  See http://www.wtfpl.net/ for more details.
+ */
+
+#pragma once
+
+/*
+ *  dedup.h: detection of seeds that fuzz their input like another seed
+ */
+
+#include <stdio.h>
+
+typedef struct zzuf_dedup zzuf_dedup_t;
+
+enum dedup
+{
+    DEDUP_NEW,
+    DEDUP_UNCHANGED,
+    DEDUP_DUPLICATE,
+};
+
+extern zzuf_dedup_t *zzuf_create_dedup(void);
+extern void zzuf_destroy_dedup(zzuf_dedup_t *);
+
+extern int zz_dedup_add_file(zzuf_dedup_t *, char const *path);
+extern enum dedup zz_dedup_check(zzuf_dedup_t *);
+extern void zz_dedup_summary(zzuf_dedup_t *, FILE *);
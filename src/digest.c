@@ -0,0 +1,275 @@
+/*
+ *  zzuf - general purpose fuzzer
+ *
+ *  Copyright © 2002—2015 Sam Hocevar <sam@hocevar.net>
+ *
+ *  This program is free software. It comes without any warranty, to
+ *  the extent permitted by applicable law. You can redistribute it
+ *  and/or modify it under the terms of the Do What the Fuck You Want
+ *  to Public License, Version 2, as published by the WTFPL Task Force.
+ *  See http://www.wtfpl.net/ for more details.
+ */
+
+/*
+ *  digest.c: output hashing for -m
+ *
+ *  Each job slot has a stream that receives its child's standard output.
+ *  Where threads are available, the data is only copied to a queue and a
+ *  worker thread does the actual hashing, so that the main loop can keep
+ *  reading from the children. The worker takes whatever is queued in all
+ *  slots at once, which lets it hash MD5 streams several at a time (see
+ *  zz_md5_add_multi). If the worker falls too far behind, the main loop
+ *  waits for it instead of queueing more data.
+ */
+
+#include "config.h"
+
+#if defined HAVE_STDINT_H
+#   include <stdint.h>
+#elif defined HAVE_INTTYPES_H
+#   include <inttypes.h>
+#endif
+#include <stdlib.h>
+#include <string.h>
+#if defined HAVE_PTHREAD_H && !defined _WIN32
+#   include <pthread.h>
+#   define USE_THREAD 1
+#endif
+
+#include "util/md5.h"
+#include "util/mmh3.h"
+#include "digest.h"
+
+/* How much data a slot may queue before the main loop waits */
+#define MAX_QUEUE (4 << 20)
+
+struct stream
+{
+    zzuf_md5sum_t *md5;
+    zzuf_mmh3_t *mmh3;
+#if defined USE_THREAD
+    /* Data queued by the main loop, and data being hashed by the worker */
+    uint8_t *queue, *work;
+    size_t queued, worked, queue_size, work_size;
+#endif
+};
+
+struct zzuf_digest
+{
+    enum zzuf_hash hash;
+    int nslots;
+    struct stream *streams;
+#if defined USE_THREAD
+    pthread_t thread;
+    pthread_mutex_t lock;
+    pthread_cond_t wake, done;
+    int busy, quit;
+#endif
+};
+
+#if defined USE_THREAD
+static void *worker(void *);
+#endif
+static void hash_streams(zzuf_digest_t *d, struct stream **s,
+                         uint8_t const **buf, unsigned *len, int n);
+
+zzuf_digest_t *zzuf_create_digest(enum zzuf_hash hash, int nslots)
+{
+    zzuf_digest_t *d = malloc(sizeof(zzuf_digest_t));
+
+    d->hash = hash;
+    d->nslots = nslots;
+    d->streams = calloc(nslots, sizeof(struct stream));
+
+#if defined USE_THREAD
+    pthread_mutex_init(&d->lock, NULL);
+    pthread_cond_init(&d->wake, NULL);
+    pthread_cond_init(&d->done, NULL);
+    d->busy = d->quit = 0;
+    if (pthread_create(&d->thread, NULL, worker, d) != 0)
+        d->quit = -1; /* hash in the main loop instead */
+#endif
+
+    return d;
+}
+
+void zzuf_destroy_digest(zzuf_digest_t *d)
+{
+    if (!d)
+        return;
+
+#if defined USE_THREAD
+    if (d->quit == 0)
+    {
+        pthread_mutex_lock(&d->lock);
+        d->quit = 1;
+        pthread_cond_signal(&d->wake);
+        pthread_mutex_unlock(&d->lock);
+        pthread_join(d->thread, NULL);
+    }
+    pthread_cond_destroy(&d->done);
+    pthread_cond_destroy(&d->wake);
+    pthread_mutex_destroy(&d->lock);
+#endif
+
+    for (int i = 0; i < d->nslots; ++i)
+    {
+        struct stream *s = &d->streams[i];
+        uint8_t tmp[16];
+
+        if (s->md5)
+            zzuf_destroy_md5(tmp, s->md5);
+        if (s->mmh3)
+            zzuf_destroy_mmh3(tmp, s->mmh3);
+#if defined USE_THREAD
+        free(s->queue);
+        free(s->work);
+#endif
+    }
+    free(d->streams);
+    free(d);
+}
+
+void zz_digest_start(zzuf_digest_t *d, int slot)
+{
+    struct stream *s = &d->streams[slot];
+
+    if (d->hash == ZZUF_HASH_MMH3)
+        s->mmh3 = zzuf_create_mmh3();
+    else
+        s->md5 = zzuf_create_md5();
+}
+
+void zz_digest_add(zzuf_digest_t *d, int slot, uint8_t const *buf,
+                   size_t len)
+{
+    struct stream *s = &d->streams[slot];
+
+#if defined USE_THREAD
+    if (d->quit == 0)
+    {
+        pthread_mutex_lock(&d->lock);
+        while (s->queued >= MAX_QUEUE)
+            pthread_cond_wait(&d->done, &d->lock);
+        if (s->queued + len > s->queue_size)
+        {
+            s->queue_size = (s->queued + len) * 2;
+            s->queue = realloc(s->queue, s->queue_size);
+        }
+        memcpy(s->queue + s->queued, buf, len);
+        s->queued += len;
+        pthread_cond_signal(&d->wake);
+        pthread_mutex_unlock(&d->lock);
+        return;
+    }
+#endif
+
+    unsigned n = (unsigned)len;
+    hash_streams(d, &s, &buf, &n, 1);
+}
+
+/*
+ * Wait until everything queued for this slot has been hashed, then store
+ * the 16-byte digest.
+ */
+void zz_digest_end(zzuf_digest_t *d, int slot, uint8_t *digest)
+{
+    struct stream *s = &d->streams[slot];
+
+#if defined USE_THREAD
+    if (d->quit == 0)
+    {
+        pthread_mutex_lock(&d->lock);
+        while (s->queued || s->worked)
+            pthread_cond_wait(&d->done, &d->lock);
+        pthread_mutex_unlock(&d->lock);
+    }
+#endif
+
+    if (s->mmh3)
+        zzuf_destroy_mmh3(digest, s->mmh3);
+    if (s->md5)
+        zzuf_destroy_md5(digest, s->md5);
+    s->mmh3 = NULL;
+    s->md5 = NULL;
+}
+
+#if defined USE_THREAD
+static void *worker(void *arg)
+{
+    zzuf_digest_t *d = arg;
+    struct stream **s = malloc(d->nslots * sizeof(struct stream *));
+    uint8_t const **buf = malloc(d->nslots * sizeof(uint8_t *));
+    unsigned *len = malloc(d->nslots * sizeof(unsigned));
+
+    pthread_mutex_lock(&d->lock);
+    while (!d->quit)
+    {
+        /* Take all queued data, giving the main loop our empty buffers */
+        int n = 0;
+        for (int i = 0; i < d->nslots; ++i)
+        {
+            struct stream *t = &d->streams[i];
+            if (!t->queued)
+                continue;
+
+            uint8_t *tmp = t->work;
+            size_t tmp_size = t->work_size;
+            t->work = t->queue;
+            t->work_size = t->queue_size;
+            t->worked = t->queued;
+            t->queue = tmp;
+            t->queue_size = tmp_size;
+            t->queued = 0;
+
+            s[n] = t;
+            buf[n] = t->work;
+            len[n] = (unsigned)t->worked;
+            ++n;
+        }
+
+        if (!n)
+        {
+            pthread_cond_wait(&d->wake, &d->lock);
+            continue;
+        }
+
+        /* Queues are empty again, wake up the main loop if it waits */
+        pthread_cond_broadcast(&d->done);
+        pthread_mutex_unlock(&d->lock);
+
+        hash_streams(d, s, buf, len, n);
+
+        pthread_mutex_lock(&d->lock);
+        for (int i = 0; i < n; ++i)
+            s[i]->worked = 0;
+        pthread_cond_broadcast(&d->done);
+    }
+    pthread_mutex_unlock(&d->lock);
+
+    free(len);
+    free(buf);
+    free(s);
+    return NULL;
+}
+#endif
+
+static void hash_streams(zzuf_digest_t *d, struct stream **s,
+                         uint8_t const **buf, unsigned *len, int n)
+{
+    if (d->hash == ZZUF_HASH_MMH3)
+    {
+        for (int i = 0; i < n; ++i)
+            zz_mmh3_add(s[i]->mmh3, buf[i], len[i]);
+        return;
+    }
+
+    for (int i = 0; i < n; i += 4)
+    {
+        zzuf_md5sum_t *ctx[4];
+        int lanes = n - i < 4 ? n - i : 4;
+        for (int l = 0; l < lanes; ++l)
+            ctx[l] = s[i + l]->md5;
+        zz_md5_add_multi(ctx, buf + i, len + i, lanes);
+    }
+}
@@ -0,0 +1,35 @@
+/*
+ *  zzuf - general purpose fuzzer
+ *
+ *  Copyright © 2002—2015 Sam Hocevar <sam@hocevar.net>
+ *
+ *  This program is free software. It comes without any warranty, to
+ *  the extent permitted by applicable law. You can redistribute it
+ *  and/or modify it under the terms of the Do What the Fuck You Want
+ *  to Public License, Version 2, as published by the WTFPL Task Force.
+ *  See http://www.wtfpl.net/ for more details.
+ */
+
+#pragma once
+
+/*
+ *  digest.h: output hashing for -m
+ */
+
+#include <stddef.h>
+
+typedef struct zzuf_digest zzuf_digest_t;
+
+enum zzuf_hash
+{
+    ZZUF_HASH_MD5,
+    ZZUF_HASH_MMH3,
+};
+
+extern zzuf_digest_t *zzuf_create_digest(enum zzuf_hash hash, int nslots);
+extern void zzuf_destroy_digest(zzuf_digest_t *);
+
+extern void zz_digest_start(zzuf_digest_t *, int slot);
+extern void zz_digest_add(zzuf_digest_t *, int slot,
+                          uint8_t const *buf, size_t len);
+extern void zz_digest_end(zzuf_digest_t *, int slot, uint8_t *digest);
@@ -0,0 +1,220 @@
+/*
+ *  zzuf - general purpose fuzzer
+ *
+ *  Copyright © 2002—2015 Sam Hocevar <sam@hocevar.net>
+ *
+ *  This program is free software. It comes without any warranty, to
+ *  the extent permitted by applicable law. You can redistribute it
+ *  and/or modify it under the terms of the Do What the Fuck You Want
+ *  to Public License, Version 2, as published by the WTFPL Task Force.
+ *  See http://www.wtfpl.net/ for more details.
+ */
+
+/*
+ *  jobs.c: adaptive concurrency control for "-j auto"
+ *
+ *  We measure how many children complete per second and hill-climb the
+ *  number of simultaneous jobs: keep going in the same direction while
+ *  throughput improves, turn around when it degrades. Adding jobs that
+ *  bring nothing is considered a loss, removing jobs that cost nothing
+ *  is considered a gain. Rising load average or memory pressure (Linux
+ *  PSI) trigger a multiplicative decrease instead.
+ */
+
+#include "config.h"
+
+#define _DEFAULT_SOURCE /* for getloadavg() */
+
+#if defined HAVE_STDINT_H
+#   include <stdint.h>
+#elif defined HAVE_INTTYPES_H
+#   include <inttypes.h>
+#endif
+#include <stdio.h>
+#include <stdlib.h>
+#include <sys/types.h>
+#if defined HAVE_UNISTD_H
+#   include <unistd.h>
+#endif
+#if defined HAVE_WINDOWS_H
+#   include <windows.h>
+#endif
+
+#include "opts.h"
+#include "jobs.h"
+#include "timer.h"
+
+/* Measurement windows last at least WINDOW microseconds, and at most
+ * MAXWINDOW if children are too slow to give us enough samples. */
+#define WINDOW 500000
+#define MAXWINDOW 4000000
+
+/* Throughput changes smaller than this are considered noise */
+#define TOLERANCE 0.05
+
+/* Back off if tasks spent more than this percentage of the last ten
+ * seconds stalled on memory */
+#define MEMORY_PRESSURE 10.0
+
+struct zzuf_jobs
+{
+    int ncpu, direction;
+    int64_t start, done;
+    double rate, load;
+};
+
+static double get_load(void);
+static double get_memory_pressure(void);
+
+int zz_jobs_ncpu(void)
+{
+#if defined _SC_NPROCESSORS_ONLN
+    long int n = sysconf(_SC_NPROCESSORS_ONLN);
+    return n > 0 ? (int)n : 1;
+#elif defined _WIN32
+    SYSTEM_INFO si;
+    GetSystemInfo(&si);
+    return si.dwNumberOfProcessors > 0 ? (int)si.dwNumberOfProcessors : 1;
+#else
+    return 1;
+#endif
+}
+
+/*
+ * Create a controller. If no maximum was given by the user, allow for
+ * four jobs per CPU. We start with one job per CPU. If children are
+ * pinned, only the CPUs they may use are taken into account.
+ */
+zzuf_jobs_t *zzuf_create_jobs(zzuf_opts_t *opts)
+{
+    zzuf_jobs_t *ctl = malloc(sizeof(zzuf_jobs_t));
+
+    ctl->ncpu = opts->ncpus > 0 ? opts->ncpus : zz_jobs_ncpu();
+    ctl->direction = 1;
+    ctl->start = zzuf_time();
+    ctl->done = opts->nreaped;
+    ctl->rate = 0.0;
+    ctl->load = get_load();
+
+    if (opts->maxchild <= 0)
+        opts->maxchild = 4 * ctl->ncpu;
+    opts->jobs = ctl->ncpu < opts->maxchild ? ctl->ncpu : opts->maxchild;
+
+    if (opts->b_verbose)
+        fprintf(stderr, "zzuf: starting with %i jobs (%i CPUs, max %i)\n",
+                opts->jobs, ctl->ncpu, opts->maxchild);
+
+    return ctl;
+}
+
+void zzuf_destroy_jobs(zzuf_jobs_t *ctl)
+{
+    free(ctl);
+}
+
+/*
+ * Return the date at which zz_jobs_update() may want to do something.
+ * Children exiting wake up the main loop anyway, so we only need to be
+ * called back when the current window expires.
+ */
+int64_t zz_jobs_deadline(zzuf_jobs_t *ctl)
+{
+    int64_t now = zzuf_time();
+
+    return now < ctl->start + WINDOW ? ctl->start + WINDOW
+                                     : ctl->start + MAXWINDOW;
+}
+
+void zz_jobs_update(zzuf_jobs_t *ctl, zzuf_opts_t *opts, int64_t now)
+{
+    int64_t elapsed = now - ctl->start;
+    int64_t done = opts->nreaped - ctl->done;
+
+    /* Wait until we have enough samples for a meaningful measurement */
+    if (elapsed < WINDOW || (done < opts->jobs && elapsed < MAXWINDOW))
+        return;
+
+    double rate = (double)done * 1000000.0 / (double)elapsed;
+    double load = get_load();
+    double pressure = get_memory_pressure();
+    int jobs = opts->jobs;
+    char const *reason;
+
+    ctl->start = now;
+    ctl->done = opts->nreaped;
+
+    if (opts->seed == opts->endseed)
+    {
+        /* Slots are idle because we are running out of work, so the
+         * throughput measure is meaningless. */
+        return;
+    }
+    else if (pressure >= MEMORY_PRESSURE)
+    {
+        jobs = jobs * 3 / 4;
+        ctl->direction = -1;
+        reason = "memory pressure";
+    }
+    else if (load > 2.0 * ctl->ncpu && load > ctl->load)
+    {
+        jobs = jobs * 3 / 4;
+        ctl->direction = -1;
+        reason = "load average";
+    }
+    else
+    {
+        if (rate < ctl->rate * (1.0 - TOLERANCE)
+             || (ctl->direction > 0 && rate < ctl->rate * (1.0 + TOLERANCE)))
+            ctl->direction = -ctl->direction;
+
+        int step = jobs / 8 > 1 ? jobs / 8 : 1;
+        jobs += ctl->direction * step;
+        reason = ctl->direction > 0 ? "climbing" : "receding";
+    }
+
+    if (jobs < 1)
+        jobs = 1;
+    if (jobs > opts->maxchild)
+        jobs = opts->maxchild;
+
+    /* Bounce on the limits */
+    if (jobs == opts->jobs)
+        ctl->direction = jobs == 1 ? 1 : -1;
+
+    if (opts->b_verbose && jobs != opts->jobs)
+        fprintf(stderr, "zzuf: %.1f exec/s, load %.2f, memory pressure %.2f%%, "
+                "%s from %i to %i jobs\n", rate, load, pressure, reason,
+                opts->jobs, jobs);
+
+    ctl->rate = rate;
+    ctl->load = load;
+    opts->jobs = jobs;
+}
+
+static double get_load(void)
+{
+#if defined HAVE_GETLOADAVG
+    double load;
+    if (getloadavg(&load, 1) == 1)
+        return load;
+#endif
+    return 0.0;
+}
+
+/*
+ * Parse the "some avg10=" field of the Linux pressure stall information.
+ * Systems without PSI just report no pressure.
+ */
+static double get_memory_pressure(void)
+{
+    FILE *fp = fopen("/proc/pressure/memory", "r");
+    double pressure = 0.0;
+
+    if (!fp)
+        return 0.0;
+    if (fscanf(fp, "some avg10=%lf", &pressure) != 1)
+        pressure = 0.0;
+    fclose(fp);
+
+    return pressure;
+}
@@ -0,0 +1,29 @@
+/*
+ *  zzuf - general purpose fuzzer
+ *
+ *  Copyright © 2002—2015 Sam Hocevar <sam@hocevar.net>
+ *
+ *  This program is free software. It comes without any warranty, to
+ *  the extent permitted by applicable law. You can redistribute it
+ *  and/or modify it under the terms of the Do What the Fuck You Want
+ *  to Public License, Version 2, as published by the WTFPL Task Force.
+ *  See http://www.wtfpl.net/ for more details.
+ */
+
+#pragma once
+
+/*
+ *  jobs.h: adaptive concurrency control for "-j auto"
+ */
+
+typedef struct zzuf_jobs zzuf_jobs_t;
+
+struct zzuf_opts;
+
+extern int zz_jobs_ncpu(void);
+
+extern zzuf_jobs_t *zzuf_create_jobs(struct zzuf_opts *);
+extern void zzuf_destroy_jobs(zzuf_jobs_t *);
+
+extern void zz_jobs_update(zzuf_jobs_t *, struct zzuf_opts *, int64_t now);
+extern int64_t zz_jobs_deadline(zzuf_jobs_t *);
@@ -44,6 +44,7 @@
 #   include <winsock2.h>
 #endif
 #include <sys/types.h>
+#include <sys/stat.h>
 #if defined HAVE_SYS_SOCKET_H
 #   include <sys/socket.h>
 #endif
@@ -71,6 +72,7 @@
 #include "network.h"
 #include "fuzz.h"
 #include "fd.h"
+#include "resize.h"
 
 #if defined HAVE_SOCKLEN_T
 #   define SOCKLEN_T socklen_t
@@ -91,6 +93,12 @@
 static void fuzz_iovec   (int fd, const struct iovec *iov, ssize_t ret);
 #endif
 static void offset_check (int fd);
+#if defined HAVE_PREAD
+static void resize_open  (int fd);
+static int  resize_read  (int fd, uint8_t *buf, size_t count, int64_t pos);
+static int64_t resize_seek (int fd, int64_t offset, int whence);
+static void set_offset   (int fd, int64_t offset);
+#endif
 
 /* Library functions that we divert */
 static int     (*ORIG(open))    (const char *file, int oflag, ...);
@@ -155,6 +163,10 @@ static ssize_t (*ORIG(readv))   (int fd, const struct iovec *iov, int count);
 #if defined HAVE_PREAD
 static ssize_t (*ORIG(pread))   (int fd, void *buf, size_t count, off_t offset);
 #endif
+#if defined HAVE_PREAD64
+static ssize_t (*ORIG(pread64)) (int fd, void *buf, size_t count,
+                                 off64_t offset);
+#endif
 #if defined HAVE_AIO_READ
 static int     (*ORIG(aio_read))   (struct aiocb *aiocbp);
 static ssize_t (*ORIG(aio_return)) (struct aiocb *aiocbp);
@@ -167,6 +179,24 @@ static off64_t (*ORIG(lseek64)) (int fd, off64_t offset, int whence);
 static off64_t (*ORIG(__lseek64)) (int fd, off64_t offset, int whence);
 #endif
 static int     (*ORIG(close))   (int fd);
+#if defined HAVE_FSTAT
+static int     (*ORIG(fstat))   (int fd, struct stat *buf);
+#endif
+#if defined HAVE_FSTAT64
+static int     (*ORIG(fstat64)) (int fd, struct stat64 *buf);
+#endif
+#if defined HAVE___FXSTAT
+static int     (*ORIG(__fxstat)) (int ver, int fd, struct stat *buf);
+#endif
+#if defined HAVE___FXSTAT64
+static int     (*ORIG(__fxstat64)) (int ver, int fd, struct stat64 *buf);
+#endif
+
+#if defined HAVE_PREAD
+#   define RESIZE_OPEN(fd) resize_open(fd)
+#else
+#   define RESIZE_OPEN(fd) do { } while (0)
+#endif
 
 #define ZZ_OPEN(myopen) \
     do \
@@ -198,6 +228,8 @@ static int     (*ORIG(close))   (int fd);
             else \
                 debug("%s(\"%s\", %i) = %i", __func__, file, oflag, ret); \
             _zz_register(ret); \
+            if ((oflag & (O_RDONLY | O_RDWR | O_WRONLY)) == O_RDONLY) \
+                RESIZE_OPEN(ret); \
         } \
     } while (0)
 
@@ -482,11 +514,29 @@ RECV_T NEW(recvmsg)(int s, struct msghdr *hdr, int flags)
 }
 #endif
 
+#if defined HAVE_PREAD
+#   define RESIZE_READ() \
+        if (must_fuzz_fd(fd) && _zz_getresize(fd)) \
+        { \
+            ret = resize_read(fd, buf, count, _zz_getpos(fd)); \
+            if (ret > 0) \
+                _zz_addpos(fd, ret); \
+            set_offset(fd, _zz_resize_tophys(_zz_getresize(fd), \
+                                             _zz_getpos(fd))); \
+            debug("%s(%i, %p, %li) = %i (resized)", __func__, \
+                  fd, buf, (long int)count, ret); \
+            return ret; \
+        }
+#else
+#   define RESIZE_READ()
+#endif
+
 #define ZZ_READ(myread, myargs) \
     do \
     { \
         LOADSYM(myread); \
         \
+        RESIZE_READ() \
         ret = ORIG(myread) myargs; \
         if (!must_fuzz_fd(fd) || !_zz_hostwatched(fd)) \
             return ret; \
@@ -534,6 +584,33 @@ ssize_t NEW(readv)(int fd, const struct iovec *iov, int count)
 {
     LOADSYM(readv);
 
+#if defined HAVE_PREAD
+    if (must_fuzz_fd(fd) && _zz_getresize(fd))
+    {
+        ssize_t ret = 0;
+
+        for (int i = 0; i < count; ++i)
+        {
+            int n = resize_read(fd, iov[i].iov_base, iov[i].iov_len,
+                                _zz_getpos(fd));
+            if (n <= 0)
+            {
+                ret = ret ? ret : n;
+                break;
+            }
+            _zz_addpos(fd, n);
+            ret += n;
+            if ((size_t)n < iov[i].iov_len)
+                break;
+        }
+
+        set_offset(fd, _zz_resize_tophys(_zz_getresize(fd), _zz_getpos(fd)));
+        debug("%s(%i, %p, %i) = %li (resized)", __func__,
+              fd, iov, count, (long int)ret);
+        return ret;
+    }
+#endif
+
     ssize_t ret = ORIG(readv)(fd, iov, count);
     if (!must_fuzz_fd(fd))
         return ret;
@@ -547,38 +624,72 @@ ssize_t NEW(readv)(int fd, const struct iovec *iov, int count)
 #endif
 
 #if defined HAVE_PREAD
+#define ZZ_PREAD(mypread) \
+    do \
+    { \
+        LOADSYM(mypread); \
+        \
+        if (must_fuzz_fd(fd) && _zz_getresize(fd)) \
+        { \
+            ret = resize_read(fd, buf, count, offset); \
+            debug("%s(%i, %p, %li, %lli) = %i (resized)", __func__, fd, \
+                  buf, (long int)count, (long long int)offset, (int)ret); \
+            return ret; \
+        } \
+        \
+        ret = ORIG(mypread)(fd, buf, count, offset); \
+        if (!must_fuzz_fd(fd)) \
+            return ret; \
+        \
+        if (ret > 0) \
+        { \
+            int64_t curoff = _zz_getpos(fd); \
+            \
+            _zz_setpos(fd, offset); \
+            _zz_fuzz(fd, buf, ret); \
+            _zz_setpos(fd, curoff); \
+        } \
+        \
+        char tmp[128]; \
+        debug_str(tmp, buf, ret, 8); \
+        debug("%s(%i, %p, %li, %lli) = %i %s", __func__, fd, buf, \
+              (long int)count, (long long int)offset, (int)ret, tmp); \
+    } while (0)
+
 #undef pread
 ssize_t NEW(pread)(int fd, void *buf, size_t count, off_t offset)
 {
-    LOADSYM(pread);
-
-    int ret = ORIG(pread)(fd, buf, count, offset);
-    if (!must_fuzz_fd(fd))
-        return ret;
-
-    if (ret > 0)
-    {
-        long int curoff = _zz_getpos(fd);
-
-        _zz_setpos(fd, offset);
-        _zz_fuzz(fd, buf, ret);
-        _zz_setpos(fd, curoff);
-    }
-
-    char tmp[128];
-    debug_str(tmp, buf, ret, 8);
-    debug("%s(%i, %p, %li, %li) = %i %s", __func__,
-          fd, buf, (long int)count, (long int)offset, ret, tmp);
+    ssize_t ret; ZZ_PREAD(pread); return ret;
+}
+#endif
 
-    return ret;
+#if defined HAVE_PREAD64
+#undef pread64
+ssize_t NEW(pread64)(int fd, void *buf, size_t count, off64_t offset)
+{
+    ssize_t ret; ZZ_PREAD(pread64); return ret;
 }
 #endif
 
+#if defined HAVE_PREAD
+#   define RESIZE_SEEK(off_t) \
+        if (must_fuzz_fd(fd) && _zz_getresize(fd)) \
+        { \
+            ret = (off_t)resize_seek(fd, offset, whence); \
+            debug("%s(%i, %lli, %i) = %lli (resized)", __func__, fd, \
+                  (long long int)offset, whence, (long long int)ret); \
+            return ret; \
+        }
+#else
+#   define RESIZE_SEEK(off_t)
+#endif
+
 #define ZZ_LSEEK(mylseek, off_t) \
     do \
     { \
         LOADSYM(mylseek); \
         \
+        RESIZE_SEEK(off_t) \
         ret = ORIG(mylseek)(fd, offset, whence); \
         if (!must_fuzz_fd(fd)) \
             return ret; \
@@ -662,6 +773,55 @@ ssize_t NEW(aio_return)(struct aiocb *aiocbp)
 }
 #endif
 
+/* Files with inserted and deleted bytes report their new size */
+#define ZZ_FSTAT(myfstat, myargs) \
+    do \
+    { \
+        LOADSYM(myfstat); \
+        \
+        ret = ORIG(myfstat) myargs; \
+        if (ret == 0 && must_fuzz_fd(fd) && _zz_getresize(fd)) \
+        { \
+            buf->st_size = _zz_resize_size(_zz_getresize(fd)); \
+            debug("%s(%i, %p) = %i (size %lli)", __func__, fd, buf, ret, \
+                  (long long int)buf->st_size); \
+        } \
+    } while (0)
+
+#if defined HAVE_FSTAT
+#undef fstat
+int NEW(fstat)(int fd, struct stat *buf)
+{
+    int ret; ZZ_FSTAT(fstat, (fd, buf)); return ret;
+}
+#endif
+
+#if defined HAVE_FSTAT64
+#undef fstat64
+int NEW(fstat64)(int fd, struct stat64 *buf)
+{
+    int ret; ZZ_FSTAT(fstat64, (fd, buf)); return ret;
+}
+#endif
+
+#if defined HAVE___FXSTAT
+#undef __fxstat
+extern int __fxstat(int ver, int fd, struct stat *buf);
+int NEW(__fxstat)(int ver, int fd, struct stat *buf)
+{
+    int ret; ZZ_FSTAT(__fxstat, (ver, fd, buf)); return ret;
+}
+#endif
+
+#if defined HAVE___FXSTAT64
+#undef __fxstat64
+extern int __fxstat64(int ver, int fd, struct stat64 *buf);
+int NEW(__fxstat64)(int ver, int fd, struct stat64 *buf)
+{
+    int ret; ZZ_FSTAT(__fxstat64, (ver, fd, buf)); return ret;
+}
+#endif
+
 #undef close
 int NEW(close)(int fd)
 {
@@ -723,6 +883,115 @@ static void offset_check(int fd)
     errno = orig_errno;
 }
 
+#if defined HAVE_PREAD
+/* With --insert-delete, regular files opened for reading get a map from
+ * the offsets the program sees to the offsets in the file. */
+static void resize_open(int fd)
+{
+    struct stat st;
+
+    if (_zz_get_resize() <= 0.0 || !_zz_isactive(fd)
+         || fstat(fd, &st) < 0 || !S_ISREG(st.st_mode))
+        return;
+
+    _zz_setresize(fd, _zz_resize_new(_zz_getfuzz(fd)->seed, st.st_size));
+}
+
+/* Read count bytes at an offset of a file that has an offset map. Whole
+ * chunks are read from the file, fuzzed, then edited. */
+static int resize_read(int fd, uint8_t *buf, size_t count, int64_t pos)
+{
+    LOADSYM(pread);
+
+    zzuf_resize_t *rs = _zz_getresize(fd);
+    size_t done = 0;
+
+    while (done < count)
+    {
+        int64_t chunk = _zz_resize_find(rs, pos + done);
+        if (chunk < 0)
+            break;
+
+        if (!_zz_resize_cached(rs, chunk))
+        {
+            uint8_t tmp[CHUNKBYTES];
+            ssize_t n = ORIG(pread)(fd, tmp, CHUNKBYTES, chunk * CHUNKBYTES);
+            if (n < 0)
+                return done ? (int)done : -1;
+
+            _zz_fuzz_data(_zz_getfuzz(fd), chunk * CHUNKBYTES, tmp, n);
+            _zz_resize_load(rs, chunk, tmp, (int)n);
+        }
+
+        int64_t n = _zz_resize_copy(rs, pos + done, buf + done, count - done);
+        if (n <= 0)
+            break; /* The file was truncated */
+        done += n;
+    }
+
+    return (int)done;
+}
+
+static int64_t resize_seek(int fd, int64_t offset, int whence)
+{
+    zzuf_resize_t *rs = _zz_getresize(fd);
+    int64_t pos;
+
+    switch (whence)
+    {
+    case SEEK_SET:
+        pos = offset;
+        break;
+    case SEEK_CUR:
+        pos = _zz_getpos(fd) + offset;
+        break;
+    case SEEK_END:
+        pos = _zz_resize_size(rs) + offset;
+        break;
+#if defined SEEK_DATA && defined SEEK_HOLE
+    case SEEK_DATA:
+    case SEEK_HOLE:
+        /* There are no holes in our data */
+        if (offset < 0 || offset >= _zz_resize_size(rs))
+        {
+            errno = ENXIO;
+            return -1;
+        }
+        pos = whence == SEEK_DATA ? offset : _zz_resize_size(rs);
+        break;
+#endif
+    default:
+        errno = EINVAL;
+        return -1;
+    }
+
+    if (pos < 0)
+    {
+        errno = EINVAL;
+        return -1;
+    }
+
+    _zz_setpos(fd, pos);
+    set_offset(fd, _zz_resize_tophys(rs, pos));
+    return pos;
+}
+
+/* Keep the file offset where the next byte comes from, for the calls that
+ * we do not divert */
+static void set_offset(int fd, int64_t offset)
+{
+    int orig_errno = errno;
+#if defined HAVE_LSEEK64
+    LOADSYM(lseek64);
+    ORIG(lseek64)(fd, offset, SEEK_SET);
+#else
+    LOADSYM(lseek);
+    ORIG(lseek)(fd, offset, SEEK_SET);
+#endif
+    errno = orig_errno;
+}
+#endif
+
 /* Utility function to know how many bytes are left until the end of
  * the file. */
 size_t _zz_bytes_until_eof(int fd, size_t offset)
@@ -748,3 +1017,20 @@ size_t _zz_bytes_until_eof(int fd, size_t offset)
     return (begin >= end) ? 0 : (size_t)(end - begin);
 }
 
+/* Returns the number of bytes read, or 0 if the file cannot be read this
+ * way, for instance because it is a pipe */
+int _zz_peek(int fd, int64_t offset, uint8_t *buf, int len)
+{
+#if defined HAVE_PREAD
+    int orig_errno = errno;
+    LOADSYM(pread);
+
+    ssize_t ret = ORIG(pread)(fd, buf, len, offset);
+    errno = orig_errno;
+
+    return ret > 0 ? (int)ret : 0;
+#else
+    return 0;
+#endif
+}
+
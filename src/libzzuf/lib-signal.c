@@ -32,6 +32,22 @@
 
 #include <string.h>
 #include <signal.h>
+#include <fcntl.h>
+#if defined HAVE_UNISTD_H
+#   include <unistd.h>
+#endif
+#if defined HAVE_UCONTEXT_H
+#   include <ucontext.h>
+#endif
+#if defined HAVE_EXECINFO_H
+#   include <execinfo.h>
+#endif
+#if defined HAVE_SYS_PRCTL_H
+#   include <sys/prctl.h>
+#endif
+#if defined HAVE_SYS_SYSCALL_H
+#   include <sys/syscall.h>
+#endif
 
 #include "libzzuf.h"
 #include "lib-load.h"
@@ -55,6 +71,18 @@ static int   (*ORIG(sigaction)) (int signum, const struct sigaction *act,
 /* Local functions */
 static int isfatal(int signum);
 
+#if defined HAVE_SIGACTION && defined HAVE_SIGALTSTACK && defined SA_SIGINFO \
+     && defined SA_ONSTACK
+#   define ZZUF_CRASH_HANDLER 1
+static void crash_handler(int signum, siginfo_t *info, void *ctx);
+#endif
+
+/* Number of return addresses in crash records */
+#define CRASH_FRAMES 8
+
+/* Set once our crash handler is installed */
+static int crash_info = 0;
+
 static int isfatal(int signum)
 {
     switch (signum)
@@ -98,6 +126,13 @@ SIG_T NEW(signal)(int signum, SIG_T handler)
     if (!g_disable_sighandlers)
         return ORIG(signal)(signum, handler);
 
+    /* Keep our crash handler instead of restoring the default one */
+    if (crash_info && isfatal(signum))
+    {
+        debug("%s(%i, %p) = %p", __func__, signum, handler, SIG_DFL);
+        return SIG_DFL;
+    }
+
     SIG_T ret = ORIG(signal)(signum, isfatal(signum) ? SIG_DFL : handler);
 
     debug("%s(%i, %p) = %p", __func__, signum, handler, ret);
@@ -117,7 +152,12 @@ int NEW(sigaction)(int signum, const struct sigaction *act,
 
     int ret;
 
-    if (act && isfatal(signum))
+    if (act && isfatal(signum) && crash_info)
+    {
+        /* Keep our crash handler instead of restoring the default one */
+        ret = ORIG(sigaction)(signum, NULL, oldact);
+    }
+    else if (act && isfatal(signum))
     {
         struct sigaction newact;
         memcpy(&newact, act, sizeof(struct sigaction));
@@ -133,3 +173,238 @@ int NEW(sigaction)(int signum, const struct sigaction *act,
 }
 #endif
 
+
+/*
+ * Install a handler for fatal signals that sends a compact crash record
+ * to zzuf through the debug channel and then lets the process die. Also
+ * make sure the kernel does not waste time writing a core dump, since
+ * this includes core_pattern pipes, which ignore RLIMIT_CORE.
+ */
+void _zz_crash_init(void)
+{
+#if defined ZZUF_CRASH_HANDLER
+    LOADSYM(sigaction);
+
+#   if defined HAVE_BACKTRACE
+    /* The first call to backtrace() may load libgcc_s, which is not
+     * something we want to do from a signal handler. */
+    void *dummy[1];
+    backtrace(dummy, 1);
+#   endif
+
+    /* Use an alternate stack so that we can report stack overflows */
+    stack_t ss;
+    ss.ss_size = SIGSTKSZ > 65536 ? SIGSTKSZ : 65536;
+    ss.ss_sp = malloc(ss.ss_size);
+    ss.ss_flags = 0;
+    if (ss.ss_sp)
+        sigaltstack(&ss, NULL);
+
+    struct sigaction sa;
+    memset(&sa, 0, sizeof(sa));
+    sa.sa_sigaction = crash_handler;
+    sa.sa_flags = SA_SIGINFO | SA_ONSTACK;
+    sigemptyset(&sa.sa_mask);
+
+    for (int signum = 1; signum < 32; ++signum)
+        if (isfatal(signum))
+            ORIG(sigaction)(signum, &sa, NULL);
+
+    crash_info = 1;
+#endif
+
+#if defined HAVE_SYS_PRCTL_H && defined PR_SET_DUMPABLE
+    prctl(PR_SET_DUMPABLE, 0);
+#endif
+}
+
+#if defined ZZUF_CRASH_HANDLER
+/* Everything below must be async-signal-safe: no stdio, no malloc. */
+static char crash_buf[4096];
+static size_t crash_len;
+static char crash_maps[65536];
+static ssize_t crash_maps_len = -1;
+
+static void crash_str(char const *str, size_t len)
+{
+    while (len-- && *str && crash_len < sizeof(crash_buf) - 1)
+        crash_buf[crash_len++] = *str++;
+}
+
+static void crash_num(uintptr_t x, int base)
+{
+    char tmp[32], *t = tmp + sizeof(tmp);
+
+    if (base == 16)
+        crash_str("0x", 2);
+    do
+        *--t = "0123456789abcdef"[x % base];
+    while (x /= base);
+    crash_str(t, tmp + sizeof(tmp) - t);
+}
+
+static uintptr_t parse_hex(char const **p, char const *end)
+{
+    uintptr_t ret = 0;
+
+    for ( ; *p < end; ++*p)
+    {
+        char c = **p;
+        if (c >= '0' && c <= '9')
+            ret = ret * 16 + (c - '0');
+        else if (c >= 'a' && c <= 'f')
+            ret = ret * 16 + (c - 'a' + 10);
+        else
+            break;
+    }
+
+    return ret;
+}
+
+/*
+ * Append "(module+0xoffset)" for the given address, using the mapping
+ * list from /proc/self/maps. We use raw system calls because our own
+ * open() and read() would fuzz the data, and they are not signal-safe.
+ */
+static void crash_module(uintptr_t addr)
+{
+    if (crash_maps_len < 0)
+    {
+        crash_maps_len = 0;
+#if defined HAVE_SYS_SYSCALL_H && defined SYS_openat && defined SYS_read
+        int fd = (int)syscall(SYS_openat, AT_FDCWD, "/proc/self/maps",
+                              O_RDONLY);
+        if (fd < 0)
+            return;
+        for (;;)
+        {
+            ssize_t ret = syscall(SYS_read, fd, crash_maps + crash_maps_len,
+                                  sizeof(crash_maps) - crash_maps_len);
+            if (ret <= 0)
+                break;
+            crash_maps_len += ret;
+        }
+        syscall(SYS_close, fd);
+#endif
+    }
+
+    char const *end = crash_maps + crash_maps_len;
+    for (char const *line = crash_maps; line < end; )
+    {
+        char const *eol = line, *p = line;
+        while (eol < end && *eol != '\n')
+            ++eol;
+
+        /* Parse "start-end perms offset dev inode path" */
+        uintptr_t start = parse_hex(&p, eol);
+        ++p;
+        uintptr_t stop = parse_hex(&p, eol);
+        while (p < eol && *p == ' ')
+            ++p;
+        while (p < eol && *p != ' ')
+            ++p;
+        while (p < eol && *p == ' ')
+            ++p;
+        uintptr_t offset = parse_hex(&p, eol);
+
+        if (addr >= start && addr < stop)
+        {
+            char const *path = p, *name = NULL;
+            while (path < eol && *path != '/' && *path != '[')
+                ++path;
+            for (char const *t = path; t < eol; ++t)
+                if (*t == '/')
+                    name = t + 1;
+            if (!name)
+                name = path;
+
+            crash_str("(", 1);
+            crash_str(name < eol ? name : "?", name < eol ? eol - name : 1);
+            crash_str("+", 1);
+            crash_num(addr - start + offset, 16);
+            crash_str(")", 1);
+            return;
+        }
+
+        line = eol + 1;
+    }
+}
+
+static void crash_handler(int signum, siginfo_t *info, void *ctx)
+{
+    uintptr_t pc = 0, sp = 0, fp = 0;
+
+#if defined HAVE_UCONTEXT_H && defined __linux__
+    ucontext_t *uc = (ucontext_t *)ctx;
+#   if defined __x86_64__
+    pc = uc->uc_mcontext.gregs[REG_RIP];
+    sp = uc->uc_mcontext.gregs[REG_RSP];
+    fp = uc->uc_mcontext.gregs[REG_RBP];
+#   elif defined __i386__
+    pc = uc->uc_mcontext.gregs[REG_EIP];
+    sp = uc->uc_mcontext.gregs[REG_ESP];
+    fp = uc->uc_mcontext.gregs[REG_EBP];
+#   elif defined __aarch64__
+    pc = uc->uc_mcontext.pc;
+    sp = uc->uc_mcontext.sp;
+    fp = uc->uc_mcontext.regs[29];
+#   endif
+#else
+    (void)ctx;
+#endif
+
+    crash_len = 0;
+    crash_str("** zzuf crash ** pid ", 21);
+    crash_num((uintptr_t)getpid(), 10);
+    crash_str(" signal ", 8);
+    crash_num((uintptr_t)signum, 10);
+    crash_str(" addr ", 6);
+    crash_num((uintptr_t)info->si_addr, 16);
+    if (pc)
+    {
+        crash_str(" pc ", 4);
+        crash_num(pc, 16);
+        crash_module(pc);
+        crash_str(" sp ", 4);
+        crash_num(sp, 16);
+        crash_str(" fp ", 4);
+        crash_num(fp, 16);
+    }
+
+#if defined HAVE_BACKTRACE
+    /* Skip our own frames, up to the faulting instruction if we can
+     * find it, otherwise the handler and the signal trampoline. */
+    void *frames[CRASH_FRAMES + 8];
+    int n = backtrace(frames, CRASH_FRAMES + 8), first = n < 2 ? n : 2;
+    for (int i = 0; i < n; ++i)
+        if ((uintptr_t)frames[i] == pc)
+        {
+            first = i;
+            break;
+        }
+
+    crash_str(" bt", 3);
+    for (int i = first; i < n && i < first + CRASH_FRAMES; ++i)
+    {
+        crash_str(" ", 1);
+        crash_num((uintptr_t)frames[i], 16);
+        crash_module((uintptr_t)frames[i]);
+    }
+#endif
+
+    crash_str("\n", 1);
+
+    /* A single write() so that the record is not mixed with other
+     * debug messages */
+    if (g_debug_fd >= 0)
+        write(g_debug_fd, crash_buf, crash_len);
+
+    /* Die from the same signal, as soon as we return */
+    struct sigaction sa;
+    memset(&sa, 0, sizeof(sa));
+    sa.sa_handler = SIG_DFL;
+    sigemptyset(&sa.sa_mask);
+    ORIG(sigaction)(signum, &sa, NULL);
+    raise(signum);
+}
+#endif
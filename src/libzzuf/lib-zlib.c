@@ -0,0 +1,256 @@
+/*
+ *  zzuf - general purpose fuzzer
+ *
+ *  Copyright © 2002—2015 Sam Hocevar <sam@hocevar.net>
+ *
+ *  This program is free software. It comes without any warranty, to
+ *  the extent permitted by applicable law. You can redistribute it
+ *  and/or modify it under the terms of the Do What the Fuck You Want
+ *  to Public License, Version 2, as published by the WTFPL Task Force.
+ *  See http://www.wtfpl.net/ for more details.
+ */
+
+
+/*
+ *  lib-zlib.c: loaded zlib functions
+ *
+ *  With --inflate, what inflate() writes is fuzzed instead of what is
+ *  read from files, so that compressed formats such as PNG get fuzzed
+ *  beyond their checksums and Huffman tables. Each z_stream has its own
+ *  offset, from which -b ranges are counted.
+ */
+
+#include "config.h"
+
+/* Need this for RTLD_NEXT */
+#define _GNU_SOURCE
+
+#if defined HAVE_STDINT_H
+#   include <stdint.h>
+#elif defined HAVE_INTTYPES_H
+#   include <inttypes.h>
+#endif
+#include <stdlib.h>
+#include <string.h>
+
+#if defined HAVE_ZLIB_H && defined HAVE_DLFCN_H
+#   include <zlib.h>
+#   include <dlfcn.h>
+#endif
+
+#include "libzzuf.h"
+#include "lib-load.h"
+#include "debug.h"
+#include "fuzz.h"
+#include "fd.h"
+#include "util/mutex.h"
+
+#if defined HAVE_ZLIB_H && defined HAVE_DLFCN_H
+
+#if defined __APPLE__
+#   define ZLIB_SONAME "libz.1.dylib"
+#else
+#   define ZLIB_SONAME "libz.so.1"
+#endif
+
+/* zlib may not be in the global namespace, for instance when it was
+ * loaded by a dlopen()ed module, so RTLD_NEXT does not always find it */
+#define LOADZSYM(x) \
+    do { \
+        if (!ORIG(x)) \
+        { \
+            libzzuf_init(); \
+            ORIG(x) = load_zsym(STR(x)); \
+        } \
+        if (!ORIG(x)) \
+            abort(); \
+    } while (0)
+
+/* Decompression streams being fuzzed; free slots have a NULL strm.
+ * Streams that are never ended would fill the table, so when it is full,
+ * slots are reused in a round-robin fashion. Slots never move, because
+ * other threads may be fuzzing their stream's output. */
+#define MAX_STREAMS 32
+
+static struct stream
+{
+    z_streamp strm;
+    int64_t pos;
+    fuzz_context_t fuzz;
+}
+streams[MAX_STREAMS];
+static int victim = 0;
+static zzuf_mutex_t streams_mutex = 0;
+
+/* Library functions that we divert */
+static int (*ORIG(inflateInit_))  (z_streamp strm, const char *version,
+                                   int stream_size);
+static int (*ORIG(inflateInit2_)) (z_streamp strm, int windowBits,
+                                   const char *version, int stream_size);
+static int (*ORIG(inflate))       (z_streamp strm, int flush);
+static int (*ORIG(inflateReset))  (z_streamp strm);
+static int (*ORIG(inflateReset2)) (z_streamp strm, int windowBits);
+static int (*ORIG(inflateEnd))    (z_streamp strm);
+
+static void *load_zsym(char const *name)
+{
+    void *sym = dlsym(RTLD_NEXT, name);
+
+#if defined RTLD_NOLOAD
+    if (!sym)
+    {
+        void *lib = dlopen(ZLIB_SONAME, RTLD_NOW | RTLD_NOLOAD);
+        if (lib)
+            sym = dlsym(lib, name);
+    }
+#endif
+
+    return sym;
+}
+
+/* Start fuzzing a stream from offset zero, whether we knew it or not */
+static void reset_stream(z_streamp strm)
+{
+    int i, slot = -1;
+
+    zzuf_mutex_lock(&streams_mutex);
+
+    for (i = 0; i < MAX_STREAMS; ++i)
+    {
+        if (streams[i].strm == strm)
+            break;
+        if (slot < 0 && !streams[i].strm)
+            slot = i;
+    }
+
+    if (i == MAX_STREAMS)
+    {
+        if (slot < 0)
+        {
+            slot = victim;
+            victim = (victim + 1) % MAX_STREAMS;
+        }
+        i = slot;
+        streams[i].strm = strm;
+    }
+
+    streams[i].pos = 0;
+    _zz_initfuzz(&streams[i].fuzz);
+
+    zzuf_mutex_unlock(&streams_mutex);
+}
+
+static struct stream *get_stream(z_streamp strm)
+{
+    struct stream *ret = NULL;
+
+    zzuf_mutex_lock(&streams_mutex);
+
+    for (int i = 0; i < MAX_STREAMS && !ret; ++i)
+        if (streams[i].strm == strm)
+            ret = &streams[i];
+
+    zzuf_mutex_unlock(&streams_mutex);
+    return ret;
+}
+
+static void end_stream(z_streamp strm)
+{
+    zzuf_mutex_lock(&streams_mutex);
+
+    for (int i = 0; i < MAX_STREAMS; ++i)
+        if (streams[i].strm == strm)
+            streams[i].strm = NULL;
+
+    zzuf_mutex_unlock(&streams_mutex);
+}
+
+#define ZZ_INFLATEINIT(myinit, myargs) \
+    do \
+    { \
+        LOADZSYM(myinit); \
+        ret = ORIG(myinit) myargs; \
+        if (!g_libzzuf_ready || !g_inflate_fuzzing || ret != Z_OK) \
+            return ret; \
+        reset_stream(strm); \
+        debug("%s(%p, ...) = %i", __func__, strm, ret); \
+    } while (0)
+
+#undef inflateInit_
+int NEW(inflateInit_)(z_streamp strm, const char *version, int stream_size)
+{
+    int ret; ZZ_INFLATEINIT(inflateInit_, (strm, version, stream_size));
+    return ret;
+}
+
+#undef inflateInit2_
+int NEW(inflateInit2_)(z_streamp strm, int windowBits, const char *version,
+                       int stream_size)
+{
+    int ret; ZZ_INFLATEINIT(inflateInit2_,
+                            (strm, windowBits, version, stream_size));
+    return ret;
+}
+
+#undef inflateReset
+int NEW(inflateReset)(z_streamp strm)
+{
+    int ret; ZZ_INFLATEINIT(inflateReset, (strm)); return ret;
+}
+
+#undef inflateReset2
+int NEW(inflateReset2)(z_streamp strm, int windowBits)
+{
+    int ret; ZZ_INFLATEINIT(inflateReset2, (strm, windowBits)); return ret;
+}
+
+#undef inflate
+int NEW(inflate)(z_streamp strm, int flush)
+{
+    LOADZSYM(inflate);
+
+    Bytef *out = strm ? strm->next_out : NULL;
+    int ret = ORIG(inflate)(strm, flush);
+    if (!g_libzzuf_ready || !g_inflate_fuzzing || !out)
+        return ret;
+
+    /* zlib keeps its own copy of the window, so fuzzing the output does
+     * not affect the rest of the decompression */
+    int64_t len = strm->next_out - out;
+    struct stream *s = get_stream(strm);
+    if (!s)
+    {
+        /* The stream was initialised before we were ready */
+        reset_stream(strm);
+        s = get_stream(strm);
+    }
+
+    if (len > 0 && s)
+    {
+        _zz_fuzz_data(&s->fuzz, s->pos, out, len);
+        s->pos += len;
+    }
+
+    char tmp[128];
+    debug_str(tmp, out, (int)len, 8);
+    debug("%s(%p, %i) = %i %s", __func__, strm, flush, ret, tmp);
+
+    return ret;
+}
+
+#undef inflateEnd
+int NEW(inflateEnd)(z_streamp strm)
+{
+    LOADZSYM(inflateEnd);
+
+    int ret = ORIG(inflateEnd)(strm);
+    if (!g_libzzuf_ready || !g_inflate_fuzzing)
+        return ret;
+
+    end_stream(strm);
+    debug("%s(%p) = %i", __func__, strm, ret);
+
+    return ret;
+}
+
+#endif /* HAVE_ZLIB_H && HAVE_DLFCN_H */
@@ -40,6 +40,7 @@
 #include <stdlib.h>
 #include <string.h>
 #include <fcntl.h>
+#include <errno.h>
 
 #include <stdarg.h>
 
@@ -49,7 +50,10 @@
 #include "network.h"
 #include "sys.h"
 #include "fuzz.h"
+#include "fixup.h"
+#include "resize.h"
 #include "util/mutex.h"
+#include "util/extents.h"
 
 #if defined HAVE_WINDOWS_H
 BOOL WINAPI DllMain(HINSTANCE, DWORD, PVOID);
@@ -97,6 +101,35 @@ uint64_t g_memory_limit = 0;
  */
 int g_network_fuzzing = 0;
 
+/**
+ * If set to 1, this boolean will tell libzzuf to send zzuf the number of
+ * bits it flipped when the last watched file is closed and when the
+ * process exits. Its value is set by the ZZUF_FLIPS environment variable.
+ */
+int g_report_flips = 0;
+
+/**
+ * If set to 1, this boolean will tell libzzuf to record which parts of
+ * the watched files are read, and send them to zzuf along with the number
+ * of flipped bits. Its value is set by the ZZUF_PROFILE environment
+ * variable.
+ */
+int g_profile_reads = 0;
+
+/**
+ * If set to 1, this boolean will tell libzzuf to fuzz the data that zlib
+ * decompresses instead of the data read from files. Its value is set by
+ * the ZZUF_INFLATE environment variable.
+ */
+int g_inflate_fuzzing = 0;
+
+/* Parts of the watched files read since the last report. We cannot
+ * allocate memory here, so the list is bounded and gets coarser when
+ * a program reads many scattered ranges. */
+static zzuf_mutex_t reads_mutex = 0;
+static zzuf_extent_t reads_list[48];
+static zzuf_extents_t reads = { reads_list, 0, 48, 0 };
+
 /**
  * Library initialisation routine.
  *
@@ -148,6 +181,14 @@ void libzzuf_init(void)
     if (tmp && *tmp == '1')
         zzuf_set_auto_increment();
 
+    tmp = getenv("ZZUF_FUZZING");
+    if (tmp && *tmp)
+        _zz_fuzzing(tmp);
+
+    tmp = getenv("ZZUF_MUTATOR");
+    if (tmp && *tmp && _zz_mutator(tmp) < 0)
+        debug("cannot load mutator `%s'", tmp);
+
     tmp = getenv("ZZUF_BYTES");
     if (tmp && *tmp)
         _zz_bytes(tmp);
@@ -176,6 +217,14 @@ void libzzuf_init(void)
     if (tmp && *tmp)
         zzuf_refuse_range(tmp);
 
+    tmp = getenv("ZZUF_CHECKSUMS");
+    if (tmp && *tmp)
+        _zz_checksums(tmp);
+
+    tmp = getenv("ZZUF_INSERT_DELETE");
+    if (tmp && *tmp)
+        _zz_set_resize(atof(tmp));
+
     tmp = getenv("ZZUF_INCLUDE");
     if (tmp && *tmp)
         zzuf_include_pattern(tmp);
@@ -192,10 +241,29 @@ void libzzuf_init(void)
     if (tmp)
         g_memory_limit = atoi(tmp);
 
+    tmp = getenv("ZZUF_CRASHINFO");
+    if (tmp && *tmp == '1')
+        _zz_crash_init();
+
     tmp = getenv("ZZUF_NETWORK");
     if (tmp && *tmp == '1')
         g_network_fuzzing = 1;
 
+    tmp = getenv("ZZUF_FLIPS");
+    if (tmp && *tmp == '1')
+        g_report_flips = 1;
+
+    tmp = getenv("ZZUF_PROFILE");
+    if (tmp && *tmp == '1')
+        g_profile_reads = 1;
+
+    tmp = getenv("ZZUF_INFLATE");
+    if (tmp && *tmp == '1')
+    {
+        g_inflate_fuzzing = 1;
+        _zz_fuzz_files(0);
+    }
+
     _zz_fd_init();
     _zz_network_init();
     _zz_sys_init();
@@ -221,12 +289,67 @@ void libzzuf_fini(void)
 
     debug("libzzuf finishing for PID %li", (long int)getpid());
 
+    _zz_report("exit");
+
     _zz_fd_fini();
     _zz_network_fini();
 
     g_libzzuf_ready = 0;
 }
 
+/**
+ * Remember that the given part of a watched file was read.
+ */
+void _zz_profile_read(int64_t pos, int64_t len)
+{
+    zzuf_mutex_lock(&reads_mutex);
+    zz_extents_add(&reads, pos, pos + len, 1);
+    zzuf_mutex_unlock(&reads_mutex);
+}
+
+/**
+ * Send zzuf flip and read records on the debug channel. Each record is
+ * written with a single write() call of less than PIPE_BUF bytes so that
+ * it does not get mixed with debug messages from other threads or
+ * processes. Reads are only sent once.
+ */
+void _zz_report(char const *event)
+{
+    char buf[4096];
+    int len;
+
+    if (g_debug_fd < 0)
+        return;
+
+    int saved_errno = errno;
+
+    if (g_report_flips)
+    {
+        len = snprintf(buf, sizeof(buf), "** zzuf flips ** %lli %s\n",
+                       (long long int)_zz_getflips(), event);
+        if (len > 0 && len < (int)sizeof(buf))
+            write(g_debug_fd, buf, len);
+    }
+
+    zzuf_mutex_lock(&reads_mutex);
+    if (g_profile_reads && reads.count)
+    {
+        len = snprintf(buf, sizeof(buf), "** zzuf reads **");
+        for (int i = 0; i < reads.count && len < (int)sizeof(buf) - 64; ++i)
+            len += snprintf(buf + len, sizeof(buf) - len, " %lli-%lli:%lli",
+                            (long long int)reads.list[i].start,
+                            (long long int)reads.list[i].end,
+                            (long long int)reads.list[i].hits);
+        len += snprintf(buf + len, sizeof(buf) - len, "\n");
+        if (len < (int)sizeof(buf))
+            write(g_debug_fd, buf, len);
+        reads.count = 0;
+    }
+    zzuf_mutex_unlock(&reads_mutex);
+
+    errno = saved_errno;
+}
+
 #if defined HAVE_WINDOWS_H
 BOOL WINAPI DllMain(HINSTANCE hinst, DWORD reason, PVOID impLoad)
 {
@@ -25,6 +25,9 @@ extern int g_debug_fd;
 extern int g_disable_sighandlers;
 extern uint64_t g_memory_limit;
 extern int g_network_fuzzing;
+extern int g_report_flips;
+extern int g_profile_reads;
+extern int g_inflate_fuzzing;
 extern int g_auto_increment;
 
 /* Library initialisation shit */
@@ -39,9 +42,19 @@ extern void libzzuf_fini(void) __attribute__((destructor));
 /* This function is needed to initialise memory functions */
 extern void _zz_mem_init(void);
 
+/* This function installs the crash handler (see lib-signal.c) */
+extern void _zz_crash_init(void);
+
+/* These functions tell zzuf what was read and fuzzed so far */
+extern void _zz_profile_read(int64_t pos, int64_t len);
+extern void _zz_report(char const *event);
+
 /* This function lets us know where the end of a file is. */
 extern size_t _zz_bytes_until_eof(int fd, size_t offset);
 
+/* This function reads original bytes of a file without moving its offset */
+extern int _zz_peek(int fd, int64_t offset, uint8_t *buf, int len);
+
 static inline int must_fuzz_fd(int fd)
 {
     return g_libzzuf_ready && _zz_iswatched(fd)
@@ -0,0 +1,143 @@
+/*
+ *  zzuf - general purpose fuzzer
+ *
+ *  Copyright © 2002—2015 Sam Hocevar <sam@hocevar.net>
+ *
+ *  This program is free software. It comes without any warranty, to
+ *  the extent permitted by applicable law. You can redistribute it
+ *  and/or modify it under the terms of the Do What the Fuck You Want
+ *  to Public License, Version 2, as published by the WTFPL Task Force.
+ *  See http://www.wtfpl.net/ for more details.
+ */
+
+/*
+ *  ctx.c: reentrant fuzzing API
+ *
+ *  A context is a fuzzing context, as used for each file by libzzuf,
+ *  with its own settings instead of the global ones. Nothing here is
+ *  diverted or initialised behind the caller's back.
+ */
+
+#include "config.h"
+
+#if defined HAVE_STDINT_H
+#   include <stdint.h>
+#elif defined HAVE_INTTYPES_H
+#   include <inttypes.h>
+#endif
+#include <stdlib.h>
+
+#include "common.h"
+#include "fuzz.h"
+#include "fd.h"
+#include "zzufctx.h"
+
+struct zzuf_ctx
+{
+    fuzz_settings_t *settings;
+    uint32_t seed;
+    double minratio, maxratio;
+    fuzz_context_t fuzz;
+};
+
+static void restart(zzuf_ctx_t *ctx);
+
+zzuf_ctx_t *zzuf_ctx_new(void)
+{
+    zzuf_ctx_t *ctx = malloc(sizeof(zzuf_ctx_t));
+
+    ctx->settings = _zz_settings_new();
+    ctx->seed = DEFAULT_SEED;
+    ctx->minratio = ctx->maxratio = DEFAULT_RATIO;
+    restart(ctx);
+
+    return ctx;
+}
+
+void zzuf_ctx_free(zzuf_ctx_t *ctx)
+{
+    _zz_settings_free(ctx->settings);
+    free(ctx);
+}
+
+void zzuf_ctx_set_seed(zzuf_ctx_t *ctx, uint32_t seed)
+{
+    ctx->seed = seed;
+    restart(ctx);
+}
+
+void zzuf_ctx_set_ratio(zzuf_ctx_t *ctx, double ratio)
+{
+    zzuf_ctx_set_ratio_range(ctx, ratio, ratio);
+}
+
+/* Same limits as zzuf_set_ratio() */
+void zzuf_ctx_set_ratio_range(zzuf_ctx_t *ctx, double r0, double r1)
+{
+    if (r0 == 0.0 && r1 == 0.0)
+        ctx->minratio = ctx->maxratio = 0.0;
+    else
+    {
+        ctx->minratio = r0 < MIN_RATIO ? MIN_RATIO
+                      : r0 > MAX_RATIO ? MAX_RATIO : r0;
+        ctx->maxratio = r1 < MIN_RATIO ? MIN_RATIO
+                      : r1 > MAX_RATIO ? MAX_RATIO : r1;
+        if (ctx->maxratio < ctx->minratio)
+            ctx->maxratio = ctx->minratio;
+    }
+    restart(ctx);
+}
+
+int zzuf_ctx_set_fuzzing(zzuf_ctx_t *ctx, char const *mode)
+{
+    int ret = _zz_settings_fuzzing(ctx->settings, mode);
+    restart(ctx);
+    return ret;
+}
+
+void zzuf_ctx_set_bytes(zzuf_ctx_t *ctx, char const *list)
+{
+    _zz_settings_bytes(ctx->settings, list);
+    restart(ctx);
+}
+
+void zzuf_ctx_set_protect(zzuf_ctx_t *ctx, char const *list)
+{
+    _zz_settings_protect(ctx->settings, list);
+}
+
+void zzuf_ctx_set_refuse(zzuf_ctx_t *ctx, char const *list)
+{
+    _zz_settings_refuse(ctx->settings, list);
+}
+
+int zzuf_ctx_set_mutator(zzuf_ctx_t *ctx, char const *path)
+{
+    zzuf_mutate_t mutate = _zz_mutator_load(path);
+    if (!mutate)
+        return -1;
+
+    _zz_settings_mutator(ctx->settings, mutate);
+    return 0;
+}
+
+void zzuf_fuzz_buffer(zzuf_ctx_t *ctx, uint8_t *buf, size_t len,
+                      int64_t offset)
+{
+    _zz_fuzz_data(&ctx->fuzz, offset, buf, (int64_t)len);
+}
+
+int64_t zzuf_ctx_get_flips(zzuf_ctx_t const *ctx)
+{
+    return _zz_settings_flips(ctx->settings);
+}
+
+/* Forget the cached chunk and the markers seen so far, which depend on
+ * the settings */
+static void restart(zzuf_ctx_t *ctx)
+{
+    _zz_initfuzz(&ctx->fuzz);
+    ctx->fuzz.settings = ctx->settings;
+    ctx->fuzz.seed = ctx->seed;
+    ctx->fuzz.ratio = _zz_ratio(ctx->seed, ctx->minratio, ctx->maxratio);
+}
@@ -0,0 +1,133 @@
+/*
+ *  zzuf - general purpose fuzzer
+ *
+ *  Copyright © 2002—2015 Sam Hocevar <sam@hocevar.net>
+ *
+ *  This program is free software. It comes without any warranty, to
+ *  the extent permitted by applicable law. You can redistribute it
+ *  and/or modify it under the terms of the Do What the Fuck You Want
+ *  to Public License, Version 2, as published by the WTFPL Task Force.
+ *  See http://www.wtfpl.net/ for more details.
+ */
+
+/*
+ *  libfuzzer.c: libFuzzer custom mutator
+ *
+ *  A libFuzzer target linked with this library has its inputs fuzzed by
+ *  zzuf instead of libFuzzer's own mutations. The settings are read from
+ *  the same environment variables as libzzuf's, the first time an input
+ *  is mutated, and the seed given by libFuzzer is used as zzuf's seed.
+ *  libFuzzer only mutates from one thread, so one context is enough.
+ */
+
+#include "config.h"
+
+#if defined HAVE_STDINT_H
+#   include <stdint.h>
+#elif defined HAVE_INTTYPES_H
+#   include <inttypes.h>
+#endif
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "zzufctx.h"
+
+/* These are declared by libFuzzer's FuzzerInterface.h */
+extern size_t LLVMFuzzerCustomMutator(uint8_t *data, size_t size,
+                                      size_t maxsize, unsigned int seed);
+extern size_t LLVMFuzzerCustomCrossOver(uint8_t const *data1, size_t size1,
+                                        uint8_t const *data2, size_t size2,
+                                        uint8_t *out, size_t maxoutsize,
+                                        unsigned int seed);
+
+/* libFuzzer's own mutator, when we are linked with libFuzzer */
+#if defined __GNUC__
+extern size_t LLVMFuzzerMutate(uint8_t *data, size_t size, size_t maxsize)
+    __attribute__((weak));
+#endif
+
+static zzuf_ctx_t *ctx = NULL;
+
+static void init(void);
+
+size_t LLVMFuzzerCustomMutator(uint8_t *data, size_t size, size_t maxsize,
+                               unsigned int seed)
+{
+    /* zzuf never changes the size of the data, so an empty input would
+     * stay empty forever */
+    if (size == 0)
+    {
+#if defined __GNUC__
+        if (LLVMFuzzerMutate)
+            return LLVMFuzzerMutate(data, size, maxsize);
+#endif
+        return 0;
+    }
+
+    if (!ctx)
+        init();
+
+    if (size > maxsize)
+        size = maxsize;
+
+    zzuf_ctx_set_seed(ctx, seed);
+    zzuf_fuzz_buffer(ctx, data, size, 0);
+
+    return size;
+}
+
+/* Start with the first input and switch to the second one at a random
+ * offset. Bytes keep their offsets, so that -b ranges still make sense
+ * for the result. */
+size_t LLVMFuzzerCustomCrossOver(uint8_t const *data1, size_t size1,
+                                 uint8_t const *data2, size_t size2,
+                                 uint8_t *out, size_t maxoutsize,
+                                 unsigned int seed)
+{
+    size_t cut = size1 < size2 ? size1 : size2;
+
+    cut = seed % (cut + 1);
+    if (size2 > maxoutsize)
+        size2 = maxoutsize;
+    if (cut > size2)
+        cut = size2;
+
+    memcpy(out, data1, cut);
+    memcpy(out + cut, data2 + cut, size2 - cut);
+
+    return size2;
+}
+
+static void init(void)
+{
+    char *tmp, *tmp2;
+
+    ctx = zzuf_ctx_new();
+
+    tmp = getenv("ZZUF_MINRATIO");
+    tmp2 = getenv("ZZUF_MAXRATIO");
+    if (tmp && *tmp && tmp2 && *tmp2)
+        zzuf_ctx_set_ratio_range(ctx, atof(tmp), atof(tmp2));
+
+    tmp = getenv("ZZUF_FUZZING");
+    if (tmp && *tmp && zzuf_ctx_set_fuzzing(ctx, tmp) < 0)
+        fprintf(stderr, "libzzuf-libfuzzer: cannot load `%s'\n", tmp);
+
+    tmp = getenv("ZZUF_MUTATOR");
+    if (tmp && *tmp && zzuf_ctx_set_mutator(ctx, tmp) < 0)
+        fprintf(stderr, "libzzuf-libfuzzer: cannot load mutator `%s'\n",
+                tmp);
+
+    tmp = getenv("ZZUF_BYTES");
+    if (tmp && *tmp)
+        zzuf_ctx_set_bytes(ctx, tmp);
+
+    tmp = getenv("ZZUF_PROTECT");
+    if (tmp && *tmp)
+        zzuf_ctx_set_protect(ctx, tmp);
+
+    tmp = getenv("ZZUF_REFUSE");
+    if (tmp && *tmp)
+        zzuf_ctx_set_refuse(ctx, tmp);
+}
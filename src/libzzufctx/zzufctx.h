@@ -0,0 +1,64 @@
+/*
+ *  zzuf - general purpose fuzzer
+ *
+ *  Copyright © 2002—2015 Sam Hocevar <sam@hocevar.net>
+ *
+ *  This program is free software. It comes without any warranty, to
+ *  the extent permitted by applicable law. You can redistribute it
+ *  and/or modify it under the terms of the Do What the Fuck You Want
+ *  to Public License, Version 2, as published by the WTFPL Task Force.
+ *  See http://www.wtfpl.net/ for more details.
+ */
+
+#pragma once
+
+/*
+ *  zzufctx.h: fuzz buffers in-process with zzuf's fuzzing modes
+ *
+ *  Each context has its own settings, so contexts can be used from
+ *  different threads at the same time. A context must not be used by two
+ *  threads at once. Settings are the same as zzuf's flags of the same
+ *  name, and a buffer fuzzed at a given offset gets the same bytes as
+ *  zzuf would give the file data at that offset.
+ */
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct zzuf_ctx zzuf_ctx_t;
+
+/* A new context fuzzes with seed 0, ratio 0.004 and mode xor */
+extern zzuf_ctx_t *zzuf_ctx_new(void);
+extern void zzuf_ctx_free(zzuf_ctx_t *);
+
+/* Like -s, -r and -r min:max, where the ratio depends on the seed; all
+ * of them restart the data from scratch */
+extern void zzuf_ctx_set_seed(zzuf_ctx_t *, uint32_t);
+extern void zzuf_ctx_set_ratio(zzuf_ctx_t *, double);
+extern void zzuf_ctx_set_ratio_range(zzuf_ctx_t *, double, double);
+
+/* Like -f; returns -1 if a dictionary cannot be loaded */
+extern int zzuf_ctx_set_fuzzing(zzuf_ctx_t *, char const *);
+
+/* Like -b, -P and -R */
+extern void zzuf_ctx_set_bytes(zzuf_ctx_t *, char const *);
+extern void zzuf_ctx_set_protect(zzuf_ctx_t *, char const *);
+extern void zzuf_ctx_set_refuse(zzuf_ctx_t *, char const *);
+
+/* Like --mutator; returns -1 if the plugin cannot be loaded */
+extern int zzuf_ctx_set_mutator(zzuf_ctx_t *, char const *);
+
+/* Fuzz len bytes found at a given offset of the data */
+extern void zzuf_fuzz_buffer(zzuf_ctx_t *, uint8_t *buf, size_t len,
+                             int64_t offset);
+
+/* Number of bits changed so far */
+extern int64_t zzuf_ctx_get_flips(zzuf_ctx_t const *);
+
+#ifdef __cplusplus
+}
+#endif
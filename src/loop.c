@@ -0,0 +1,324 @@
+/*
+ *  zzuf - general purpose fuzzer
+ *
+ *  Copyright © 2002—2015 Sam Hocevar <sam@hocevar.net>
+ *
+ *  This program is free software. It comes without any warranty, to
+ *  the extent permitted by applicable law. You can redistribute it
+ *  and/or modify it under the terms of the Do What the Fuck You Want
+ *  to Public License, Version 2, as published by the WTFPL Task Force.
+ *  See http://www.wtfpl.net/ for more details.
+ */
+
+/*
+ *  loop.c: event loop for children handling
+ *
+ *  On Linux we use epoll(7) to watch the children's pipes, a pidfd per
+ *  child to learn about its death without polling waitpid(), and a single
+ *  timerfd for the next deadline (-U, -t, SIGKILL escalation, -D). Other
+ *  systems get a select() fallback with the same interface.
+ */
+
+#include "config.h"
+
+#define _INCLUDE_POSIX_SOURCE /* for STDERR_FILENO on HP-UX */
+#define _DEFAULT_SOURCE
+
+#if defined HAVE_STDINT_H
+#   include <stdint.h>
+#elif defined HAVE_INTTYPES_H
+#   include <inttypes.h>
+#endif
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <sys/types.h>
+#if defined HAVE_UNISTD_H
+#   include <unistd.h>
+#endif
+#if defined HAVE_WINSOCK2_H
+#   include <winsock2.h> /* for fd_set */
+#endif
+#if defined HAVE_SYS_TIME_H
+#   include <sys/time.h>
+#endif
+#if defined HAVE_SYS_EPOLL_H && defined HAVE_EPOLL_CREATE1
+#   include <sys/epoll.h>
+#   define USE_EPOLL 1
+#endif
+#if defined USE_EPOLL && defined HAVE_SYS_TIMERFD_H \
+     && defined HAVE_TIMERFD_CREATE
+#   include <sys/timerfd.h>
+#   define USE_TIMERFD 1
+#endif
+#if defined HAVE_SYS_PIDFD_H && defined HAVE_PIDFD_OPEN
+#   include <sys/pidfd.h>
+#elif defined HAVE_SYS_SYSCALL_H
+#   include <sys/syscall.h>
+#endif
+
+#include "loop.h"
+
+/* Arbitrary number of events fetched per epoll_wait() call */
+#define MAXEVENTS 64
+
+/* Magic channel used to recognise the timer in the event list */
+#define TIMER_DATA ((uint64_t)-1)
+
+struct zzuf_loop
+{
+#if defined USE_EPOLL
+    int epfd, timerfd, armed;
+#else
+    struct watch
+    {
+        int fd, slot, channel;
+    }
+    *watch;
+    int nwatch, maxwatch;
+#endif
+};
+
+static int open_pidfd(pid_t);
+
+zzuf_loop_t *zzuf_create_loop(void)
+{
+    zzuf_loop_t *loop = malloc(sizeof(zzuf_loop_t));
+
+#if defined USE_EPOLL
+    loop->epfd = epoll_create1(EPOLL_CLOEXEC);
+    if (loop->epfd < 0)
+    {
+        free(loop);
+        return NULL;
+    }
+
+    loop->timerfd = -1;
+    loop->armed = 0;
+#   if defined USE_TIMERFD
+    loop->timerfd = timerfd_create(CLOCK_MONOTONIC,
+                                   TFD_CLOEXEC | TFD_NONBLOCK);
+    if (loop->timerfd >= 0)
+    {
+        struct epoll_event ev;
+        memset(&ev, 0, sizeof(ev));
+        ev.events = EPOLLIN;
+        ev.data.u64 = TIMER_DATA;
+        if (epoll_ctl(loop->epfd, EPOLL_CTL_ADD, loop->timerfd, &ev) < 0)
+        {
+            close(loop->timerfd);
+            loop->timerfd = -1;
+        }
+    }
+#   endif
+#else
+    loop->watch = NULL;
+    loop->nwatch = loop->maxwatch = 0;
+#endif
+
+    return loop;
+}
+
+void zzuf_destroy_loop(zzuf_loop_t *loop)
+{
+    if (!loop)
+        return;
+
+#if defined USE_EPOLL
+    if (loop->timerfd >= 0)
+        close(loop->timerfd);
+    close(loop->epfd);
+#else
+    free(loop->watch);
+#endif
+
+    free(loop);
+}
+
+/*
+ * Watch file descriptor fd for reading. Whenever it becomes readable,
+ * zz_loop_wait() will report the (slot, channel) pair it was added with.
+ */
+int zz_loop_add(zzuf_loop_t *loop, int fd, int slot, int channel)
+{
+    if (fd < 0)
+        return -1;
+
+#if defined USE_EPOLL
+    struct epoll_event ev;
+    memset(&ev, 0, sizeof(ev));
+    ev.events = EPOLLIN;
+    ev.data.u64 = ((uint64_t)slot << 2) | (uint64_t)channel;
+    return epoll_ctl(loop->epfd, EPOLL_CTL_ADD, fd, &ev);
+#else
+    if (fd >= FD_SETSIZE)
+        return -1;
+
+    if (loop->nwatch == loop->maxwatch)
+    {
+        loop->maxwatch = loop->maxwatch ? loop->maxwatch * 2 : 64;
+        loop->watch = realloc(loop->watch,
+                              loop->maxwatch * sizeof(*loop->watch));
+    }
+
+    loop->watch[loop->nwatch].fd = fd;
+    loop->watch[loop->nwatch].slot = slot;
+    loop->watch[loop->nwatch].channel = channel;
+    loop->nwatch++;
+    return 0;
+#endif
+}
+
+void zz_loop_del(zzuf_loop_t *loop, int fd)
+{
+    if (fd < 0)
+        return;
+
+#if defined USE_EPOLL
+    struct epoll_event ev; /* for kernels older than 2.6.9 */
+    epoll_ctl(loop->epfd, EPOLL_CTL_DEL, fd, &ev);
+#else
+    for (int i = 0; i < loop->nwatch; ++i)
+    {
+        if (loop->watch[i].fd != fd)
+            continue;
+
+        loop->watch[i] = loop->watch[--loop->nwatch];
+        break;
+    }
+#endif
+}
+
+/*
+ * Get notified when process pid dies. Returns the new file descriptor
+ * that the caller is responsible for closing, or -1 if the system has
+ * no way to do this, in which case the caller needs to poll waitpid().
+ */
+int zz_loop_add_pid(zzuf_loop_t *loop, pid_t pid, int slot)
+{
+    int fd = open_pidfd(pid);
+    if (fd < 0)
+        return -1;
+
+    if (zz_loop_add(loop, fd, slot, LOOP_EXIT) < 0)
+    {
+        close(fd);
+        return -1;
+    }
+
+    return fd;
+}
+
+/*
+ * Wait for at most timeout microseconds (forever if timeout is negative)
+ * until something happens on the watched file descriptors, and fill the
+ * events array. Returns the number of events, which may be zero.
+ */
+int zz_loop_wait(zzuf_loop_t *loop, int64_t timeout,
+                 zzuf_event_t *events, int maxevents)
+{
+#if defined USE_EPOLL
+    struct epoll_event ev[MAXEVENTS];
+    int ms = timeout < 0 ? -1 : (int)((timeout + 999) / 1000);
+
+#   if defined USE_TIMERFD
+    /* Use the timer for sub-millisecond accuracy */
+    if (loop->timerfd >= 0 && (timeout > 0 || loop->armed))
+    {
+        struct itimerspec its;
+        memset(&its, 0, sizeof(its));
+        if (timeout > 0)
+        {
+            its.it_value.tv_sec = timeout / 1000000;
+            its.it_value.tv_nsec = (timeout % 1000000) * 1000;
+            ms = -1;
+        }
+        if (timerfd_settime(loop->timerfd, 0, &its, NULL) == 0)
+            loop->armed = timeout > 0;
+        else
+            ms = timeout < 0 ? -1 : (int)((timeout + 999) / 1000);
+    }
+#   endif
+
+    if (maxevents > MAXEVENTS)
+        maxevents = MAXEVENTS;
+
+    int n = epoll_wait(loop->epfd, ev, maxevents, ms);
+    if (n < 0)
+    {
+        if (errno == EINTR)
+            return 0;
+        perror("epoll_wait");
+        return -1;
+    }
+
+    int ret = 0;
+    for (int i = 0; i < n; ++i)
+    {
+        if (ev[i].data.u64 == TIMER_DATA)
+        {
+            uint64_t expirations;
+            if (read(loop->timerfd, &expirations, sizeof(expirations)) > 0)
+                loop->armed = 0;
+            continue;
+        }
+
+        events[ret].slot = (int)(ev[i].data.u64 >> 2);
+        events[ret].channel = (int)(ev[i].data.u64 & 3);
+        ++ret;
+    }
+
+    return ret;
+#else
+    struct timeval tv;
+    fd_set fdset;
+    int maxfd = 0;
+
+    FD_ZERO(&fdset);
+    for (int i = 0; i < loop->nwatch; ++i)
+    {
+        FD_SET((unsigned int)loop->watch[i].fd, &fdset);
+        if (loop->watch[i].fd > maxfd)
+            maxfd = loop->watch[i].fd;
+    }
+
+    if (timeout >= 0)
+    {
+        tv.tv_sec = timeout / 1000000;
+        tv.tv_usec = timeout % 1000000;
+    }
+
+    errno = 0;
+    int n = select(maxfd + 1, &fdset, NULL, NULL, timeout >= 0 ? &tv : NULL);
+    if (n < 0 && errno && errno != EINTR)
+        perror("select");
+    if (n <= 0)
+        return n < 0 ? -1 : 0;
+
+    int ret = 0;
+    for (int i = 0; i < loop->nwatch && ret < maxevents; ++i)
+    {
+        if (!FD_ISSET(loop->watch[i].fd, &fdset))
+            continue;
+
+        events[ret].slot = loop->watch[i].slot;
+        events[ret].channel = loop->watch[i].channel;
+        ++ret;
+    }
+
+    return ret;
+#endif
+}
+
+static int open_pidfd(pid_t pid)
+{
+#if defined HAVE_SYS_PIDFD_H && defined HAVE_PIDFD_OPEN
+    return pidfd_open(pid, 0);
+#elif defined HAVE_SYS_SYSCALL_H && defined SYS_pidfd_open
+    return (int)syscall(SYS_pidfd_open, pid, 0);
+#else
+    (void)pid;
+    return -1;
+#endif
+}
@@ -0,0 +1,38 @@
+/*
+ *  zzuf - general purpose fuzzer
+ *
+ *  Copyright © 2002—2015 Sam Hocevar <sam@hocevar.net>
+ *
+ *  This program is free software. It comes without any warranty, to
+ *  the extent permitted by applicable law. You can redistribute it
+ *  and/or modify it under the terms of the Do What the Fuck You Want
+ *  to Public License, Version 2, as published by the WTFPL Task Force.
+ *  See http://www.wtfpl.net/ for more details.
+ */
+
+#pragma once
+
+/*
+ *  loop.h: event loop for children handling
+ */
+
+/* Event channels 0, 1 and 2 are the child's debug, stderr and stdout
+ * pipes, as in zzuf_child_t::fd. The last one is the process itself. */
+#define LOOP_EXIT 3
+
+typedef struct zzuf_loop zzuf_loop_t;
+
+typedef struct zzuf_event
+{
+    int slot, channel;
+}
+zzuf_event_t;
+
+extern zzuf_loop_t *zzuf_create_loop(void);
+extern void zzuf_destroy_loop(zzuf_loop_t *);
+
+extern int zz_loop_add(zzuf_loop_t *, int fd, int slot, int channel);
+extern void zz_loop_del(zzuf_loop_t *, int fd);
+extern int zz_loop_add_pid(zzuf_loop_t *, pid_t pid, int slot);
+extern int zz_loop_wait(zzuf_loop_t *, int64_t timeout,
+                        zzuf_event_t *events, int maxevents);
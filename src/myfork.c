@@ -51,6 +51,8 @@
 #include "fd.h"
 #include "fuzz.h"
 #include "myfork.h"
+#include "affinity.h"
+#include "cgroup.h"
 #include "timer.h"
 
 /* Handle old libtool versions */
@@ -113,6 +115,10 @@ int myfork(zzuf_child_t *child, zzuf_opts_t *opts)
     {
         close(pipefds[i][1]);
         child->fd[i] = pipefds[i][0];
+#if defined F_SETFD && defined FD_CLOEXEC
+        /* Do not leak our end of the pipes to subsequent children */
+        fcntl(child->fd[i], F_SETFD, FD_CLOEXEC);
+#endif
     }
 
     return 0;
@@ -258,8 +264,17 @@ static int run_process(zzuf_child_t *child, zzuf_opts_t *opts, int pipes[][2])
     }
 #endif
 
+#if defined HAVE_FORK
+    /* Enter our slot's cgroup before we allocate anything */
+    if (opts->cgroup && zz_cgroup_enter(opts->cgroup,
+                                        (int)(child - opts->child)) < 0)
+        perror("zzuf: cannot enter cgroup");
+#endif
+
 #if defined HAVE_SETRLIMIT && defined ZZUF_RLIMIT_MEM
-    if (opts->maxmem >= 0)
+    /* The cgroup memory limit, if any, only counts resident memory,
+     * which works a lot better with ASan or Go programs. */
+    if (opts->maxmem >= 0 && !zz_cgroup_has_memory(opts->cgroup))
     {
         struct rlimit rlim;
         rlim.rlim_cur = (uint64_t)opts->maxmem * 1048576;
@@ -278,6 +293,24 @@ static int run_process(zzuf_child_t *child, zzuf_opts_t *opts, int pipes[][2])
     }
 #endif
 
+#if defined HAVE_SETRLIMIT && defined RLIMIT_CORE
+    /* libzzuf reports crashes itself, do not keep the slot busy while
+     * the kernel writes a core file nobody asked for */
+    if (opts->b_crashinfo)
+    {
+        struct rlimit rlim;
+        rlim.rlim_cur = 0;
+        rlim.rlim_max = 0;
+        setrlimit(RLIMIT_CORE, &rlim);
+    }
+#endif
+
+#if defined HAVE_FORK
+    /* Stay on our slot's CPU and NUMA node */
+    if (child->cpu >= 0)
+        zz_affinity_apply(child->cpu, child->node);
+#endif
+
     /* Set environment variables */
     char buf[64];
 #if defined _WIN32
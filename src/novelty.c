@@ -0,0 +1,328 @@
+/*
+ *  zzuf - general purpose fuzzer
+ *
+ *  Copyright © 2002—2015 Sam Hocevar <sam@hocevar.net>
+ *
+ *  This program is free software. It comes without any warranty, to
+ *  the extent permitted by applicable law. You can redistribute it
+ *  and/or modify it under the terms of the Do What the Fuck You Want
+ *  to Public License, Version 2, as published by the WTFPL Task Force.
+ *  See http://www.wtfpl.net/ for more details.
+ */
+
+/*
+ *  novelty.c: database of child behaviours seen so far
+ *
+ *  A behaviour is the digest of a child's standard output, its exit status
+ *  and the order of magnitude of its running time. Each behaviour is
+ *  reduced to a 16-byte key and stored in an open addressing hash table
+ *  that lives in a file, so that a fuzzing campaign can be resumed. The
+ *  file is a small header followed by the table itself:
+ *
+ *    "zzufnov1" | number of slots (u64) | number of keys (u64) | padding
+ *    slot 0 (16 bytes) | slot 1 | ...
+ *
+ *  An all-zero slot is empty. Integers are in native byte order. Where
+ *  mmap() is available the file is mapped directly, otherwise it is read
+ *  at startup and written back when we exit.
+ */
+
+#include "config.h"
+
+#define _DEFAULT_SOURCE /* for strdup() and ftruncate() */
+
+#if defined HAVE_STDINT_H
+#   include <stdint.h>
+#elif defined HAVE_INTTYPES_H
+#   include <inttypes.h>
+#endif
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+#if defined HAVE_UNISTD_H
+#   include <unistd.h>
+#endif
+#if defined HAVE_IO_H
+#   include <io.h>
+#endif
+#if defined HAVE_SYS_MMAN_H && defined HAVE_MMAP && !defined _WIN32
+#   include <sys/mman.h>
+#   define USE_MMAP 1
+#endif
+
+#include "util/mmh3.h"
+#include "novelty.h"
+
+#define MAGIC "zzufnov1"
+#define HEADER_SIZE 32
+#define KEY_SIZE 16
+#define MIN_SLOTS 4096
+
+#if !defined O_BINARY
+#   define O_BINARY 0
+#endif
+
+struct header
+{
+    char magic[8];
+    uint64_t size, count;
+};
+
+struct zzuf_novelty
+{
+    char *path;
+    int fd;
+    uint8_t *map;
+    struct header *hdr;
+    uint8_t *slots;
+    /* Statistics for this run */
+    int64_t seen, added;
+};
+
+static int map_table(zzuf_novelty_t *nv, uint64_t size);
+static int insert(zzuf_novelty_t *nv, uint8_t const *key);
+static int grow(zzuf_novelty_t *nv);
+static int is_empty(uint8_t const *slot);
+
+zzuf_novelty_t *zzuf_create_novelty(char const *path)
+{
+    zzuf_novelty_t *nv = calloc(1, sizeof(zzuf_novelty_t));
+    struct header hdr;
+    struct stat st;
+
+    nv->path = strdup(path);
+    nv->fd = open(path, O_RDWR | O_CREAT | O_BINARY, 0644);
+    if (nv->fd < 0)
+    {
+        fprintf(stderr, "zzuf: cannot open `%s': %s\n", path,
+                strerror(errno));
+        free(nv->path);
+        free(nv);
+        return NULL;
+    }
+
+    /* An empty file is a new database */
+    if (fstat(nv->fd, &st) == 0 && st.st_size == 0)
+    {
+        if (map_table(nv, MIN_SLOTS) < 0)
+            goto error;
+        memset(nv->map, 0, HEADER_SIZE + (size_t)MIN_SLOTS * KEY_SIZE);
+        memcpy(nv->hdr->magic, MAGIC, 8);
+        nv->hdr->size = MIN_SLOTS;
+        nv->hdr->count = 0;
+        return nv;
+    }
+
+    if (read(nv->fd, &hdr, sizeof(hdr)) != sizeof(hdr)
+         || memcmp(hdr.magic, MAGIC, 8)
+         || hdr.size < MIN_SLOTS || (hdr.size & (hdr.size - 1))
+         || (uint64_t)st.st_size != HEADER_SIZE + hdr.size * KEY_SIZE)
+    {
+        fprintf(stderr, "zzuf: `%s' is not a novelty database\n", path);
+        goto error;
+    }
+
+    if (map_table(nv, hdr.size) < 0)
+        goto error;
+
+#if !defined USE_MMAP
+    lseek(nv->fd, 0, SEEK_SET);
+    if (read(nv->fd, nv->map, HEADER_SIZE + (size_t)hdr.size * KEY_SIZE)
+         != (ssize_t)(HEADER_SIZE + hdr.size * KEY_SIZE))
+    {
+        fprintf(stderr, "zzuf: cannot read `%s'\n", path);
+        goto error;
+    }
+#endif
+
+    return nv;
+
+error:
+    zzuf_destroy_novelty(nv);
+    return NULL;
+}
+
+void zzuf_destroy_novelty(zzuf_novelty_t *nv)
+{
+    if (!nv)
+        return;
+
+    if (nv->map)
+    {
+        size_t len = HEADER_SIZE + (size_t)nv->hdr->size * KEY_SIZE;
+#if defined USE_MMAP
+        munmap(nv->map, len);
+#else
+        lseek(nv->fd, 0, SEEK_SET);
+        if (write(nv->fd, nv->map, len) != (ssize_t)len)
+            fprintf(stderr, "zzuf: cannot write `%s'\n", nv->path);
+        free(nv->map);
+#endif
+    }
+
+    close(nv->fd);
+    free(nv->path);
+    free(nv);
+}
+
+/*
+ * Record a behaviour and tell whether it is new. Running times, in
+ * milliseconds, vary a lot from one run to another, so they are only
+ * compared by their order of magnitude: 0 is less than 100 ms, 1 is less
+ * than 1 s, 2 is less than 10 s, etc.
+ */
+int zz_novelty_add(zzuf_novelty_t *nv, uint8_t const *digest,
+                   char const *status, int64_t runtime)
+{
+    uint8_t key[KEY_SIZE], magnitude = 0;
+
+    for (runtime /= 100; runtime > 0; runtime /= 10)
+        ++magnitude;
+
+    zzuf_mmh3_t *ctx = zzuf_create_mmh3();
+    zz_mmh3_add(ctx, digest, 16);
+    zz_mmh3_add(ctx, (uint8_t const *)status, strlen(status) + 1);
+    zz_mmh3_add(ctx, &magnitude, 1);
+    zzuf_destroy_mmh3(key, ctx);
+
+    /* All zeroes means an empty slot */
+    if (is_empty(key))
+        key[0] = 1;
+
+    ++nv->seen;
+
+    if (!nv->map)
+        return 0;
+
+    /* Keep the table at most half full */
+    if ((nv->hdr->count + 1) * 2 > nv->hdr->size && grow(nv) < 0)
+        return 0;
+
+    if (!insert(nv, key))
+        return 0;
+
+    ++nv->added;
+    return 1;
+}
+
+void zz_novelty_summary(zzuf_novelty_t *nv, FILE *fp)
+{
+    if (!nv->map)
+        return;
+
+    fprintf(fp, "zzuf: %lli new behaviour%s in %lli run%s, "
+            "%lli known in `%s'\n",
+            (long long int)nv->added, nv->added > 1 ? "s" : "",
+            (long long int)nv->seen, nv->seen > 1 ? "s" : "",
+            (long long int)nv->hdr->count, nv->path);
+}
+
+/*
+ * Map a table with the given number of slots. The file is resized as
+ * needed; new space is zero-filled.
+ */
+static int map_table(zzuf_novelty_t *nv, uint64_t size)
+{
+    size_t len = HEADER_SIZE + (size_t)size * KEY_SIZE;
+
+#if defined USE_MMAP
+    if (ftruncate(nv->fd, (off_t)len) < 0)
+    {
+        fprintf(stderr, "zzuf: cannot resize `%s': %s\n", nv->path,
+                strerror(errno));
+        return -1;
+    }
+
+    void *map = mmap(NULL, len, PROT_READ | PROT_WRITE, MAP_SHARED,
+                     nv->fd, 0);
+    if (map == MAP_FAILED)
+    {
+        fprintf(stderr, "zzuf: cannot map `%s': %s\n", nv->path,
+                strerror(errno));
+        return -1;
+    }
+    nv->map = map;
+#else
+    nv->map = calloc(1, len);
+#endif
+
+    nv->hdr = (struct header *)(void *)nv->map;
+    nv->slots = nv->map + HEADER_SIZE;
+    return 0;
+}
+
+/*
+ * Insert a key unless it is already there. Returns 1 if it was added.
+ */
+static int insert(zzuf_novelty_t *nv, uint8_t const *key)
+{
+    uint64_t mask = nv->hdr->size - 1, i;
+
+    memcpy(&i, key, sizeof(i));
+    for (i &= mask; ; i = (i + 1) & mask)
+    {
+        uint8_t *slot = nv->slots + i * KEY_SIZE;
+
+        if (!memcmp(slot, key, KEY_SIZE))
+            return 0;
+
+        if (is_empty(slot))
+        {
+            memcpy(slot, key, KEY_SIZE);
+            ++nv->hdr->count;
+            return 1;
+        }
+    }
+}
+
+/*
+ * Double the size of the table. Keys are copied aside first, because
+ * the new table has to be mapped before they can be put back.
+ */
+static int grow(zzuf_novelty_t *nv)
+{
+    uint64_t size = nv->hdr->size, count = 0;
+    uint8_t *keys = malloc((size_t)nv->hdr->count * KEY_SIZE);
+
+    for (uint64_t i = 0; i < size; ++i)
+    {
+        uint8_t *slot = nv->slots + i * KEY_SIZE;
+        if (!is_empty(slot))
+            memcpy(keys + count++ * KEY_SIZE, slot, KEY_SIZE);
+    }
+
+#if defined USE_MMAP
+    munmap(nv->map, HEADER_SIZE + (size_t)size * KEY_SIZE);
+#else
+    free(nv->map);
+#endif
+    if (map_table(nv, size * 2) < 0)
+    {
+        /* We lost the table; stop looking for new behaviours */
+        free(keys);
+        nv->map = NULL;
+        return -1;
+    }
+
+    memset(nv->slots, 0, (size_t)size * 2 * KEY_SIZE);
+    memcpy(nv->hdr->magic, MAGIC, 8);
+    nv->hdr->size = size * 2;
+    nv->hdr->count = 0;
+    for (uint64_t i = 0; i < count; ++i)
+        insert(nv, keys + i * KEY_SIZE);
+
+    free(keys);
+    return 0;
+}
+
+static int is_empty(uint8_t const *slot)
+{
+    for (int i = 0; i < KEY_SIZE; ++i)
+        if (slot[i])
+            return 0;
+    return 1;
+}
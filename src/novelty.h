@@ -0,0 +1,26 @@
+/*
+ *  zzuf - general purpose fuzzer
+ *
+ *  Copyright © 2002—2015 Sam Hocevar <sam@hocevar.net>
+ *
+ *  This program is free software. It comes without any warranty, to
+ *  the extent permitted by applicable law. You can redistribute it
+ *  and/or modify it under the terms of the Do What the Fuck You Want
+ *  to Public License, Version 2, as published by the WTFPL Task Force.
+ *  See http://www.wtfpl.net/ for more details.
+ */
+
+#pragma once
+
+/*
+ *  novelty.h: database of child behaviours seen so far
+ */
+
+typedef struct zzuf_novelty zzuf_novelty_t;
+
+extern zzuf_novelty_t *zzuf_create_novelty(char const *path);
+extern void zzuf_destroy_novelty(zzuf_novelty_t *);
+
+extern int zz_novelty_add(zzuf_novelty_t *, uint8_t const *digest,
+                          char const *status, int64_t runtime);
+extern void zz_novelty_summary(zzuf_novelty_t *, FILE *);
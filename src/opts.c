@@ -37,6 +37,17 @@ zzuf_opts_t *zzuf_create_opts(void)
     opts->opmode = OPMODE_PRELOAD;
     opts->fuzzing = opts->bytes = opts->list = opts->ports = NULL;
     opts->allow = NULL;
+    opts->cpulist = NULL;
+    opts->watch = NULL;
+    opts->nwatch = 0;
+    opts->outdir = NULL;
+    opts->outsize = DEFAULT_OUTSIZE;
+    opts->noveltyfile = NULL;
+    opts->profilefile = NULL;
+    opts->autobytes = NULL;
+    opts->checksums = NULL;
+    opts->insertdelete = NULL;
+    opts->mutator = NULL;
     opts->protect = opts->refuse = NULL;
 
     opts->seed = DEFAULT_SEED;
@@ -45,9 +56,14 @@ zzuf_opts_t *zzuf_create_opts(void)
 
     opts->b_quiet = 0;
     opts->b_md5 = 0;
+    opts->hash = ZZUF_HASH_MD5;
     opts->b_hex = 0;
     opts->b_checkexit = 0;
     opts->b_verbose = 0;
+    opts->b_pin = 0;
+    opts->b_cgroup = 0;
+    opts->b_crashinfo = 0;
+    opts->b_skipunfuzzed = 0;
 
     opts->maxbytes = -1;
     opts->maxmem = DEFAULT_MEM;
@@ -55,14 +71,29 @@ zzuf_opts_t *zzuf_create_opts(void)
     opts->maxtime = 0;
     opts->maxusertime = -1;
     opts->maxcpu = -1;
+    opts->cgroupcpu = 0.0;
     opts->delay = 0;
-    opts->lastlaunch = 0;
+    opts->nextlaunch = 0;
+    opts->burst = 1;
 
     opts->maxchild = 1;
     opts->nchild = 0;
     opts->maxcrashes = 1;
     opts->crashes = 0;
+    opts->jobs = 1;
+    opts->ncpus = 0;
+    opts->nreaped = 0;
+    opts->unfuzzed = 0;
     opts->child = NULL;
+    opts->loop = NULL;
+    opts->autojobs = NULL;
+    opts->cgroup = NULL;
+    opts->buckets = NULL;
+    opts->scan = NULL;
+    opts->digest = NULL;
+    opts->novelty = NULL;
+    opts->dedup = NULL;
+    opts->profile = NULL;
 
     return opts;
 }
@@ -72,11 +103,49 @@ void zzuf_destroy_opts(zzuf_opts_t *opts)
     if (opts->child)
     {
         for (int i = 0; i < opts->maxchild; ++i)
+        {
             if (opts->child[i].newargv)
                 free(opts->child[i].newargv);
+            free(opts->child[i].crash);
+            free(opts->child[i].report);
+            for (int j = 0; j < 2; ++j)
+                if (opts->child[i].ring[j])
+                    zzuf_destroy_ring(opts->child[i].ring[j]);
+        }
         free(opts->child);
     }
 
+#if !defined _WIN32
+    zzuf_destroy_loop(opts->loop);
+#endif
+
+    if (opts->autojobs)
+        zzuf_destroy_jobs(opts->autojobs);
+
+    if (opts->cgroup)
+        zzuf_destroy_cgroup(opts->cgroup);
+
+    if (opts->buckets)
+        zzuf_destroy_crashes(opts->buckets);
+
+    if (opts->scan)
+        zzuf_destroy_scan(opts->scan);
+    free(opts->watch);
+
+    if (opts->digest)
+        zzuf_destroy_digest(opts->digest);
+
+    if (opts->novelty)
+        zzuf_destroy_novelty(opts->novelty);
+
+    if (opts->dedup)
+        zzuf_destroy_dedup(opts->dedup);
+
+    if (opts->profile)
+        zzuf_destroy_profile(opts->profile);
+
+    free(opts->autobytes);
+
     free(opts);
 }
 
@@ -17,7 +17,16 @@
  */
 
 #include "util/hex.h"
-#include "util/md5.h"
+#include "util/ring.h"
+#include "loop.h"
+#include "jobs.h"
+#include "cgroup.h"
+#include "crashes.h"
+#include "scan.h"
+#include "digest.h"
+#include "novelty.h"
+#include "dedup.h"
+#include "profile.h"
 
 #ifdef _WIN32
 #   include <windows.h>
@@ -41,6 +50,9 @@ struct zzuf_child
     } status;
 
     pid_t pid;
+    int pidfd; /* -1 if unsupported or once the child has died */
+    int cpu, node; /* placement for --cpu-list, -1 if none */
+    int64_t ooms; /* cgroup OOM kill count at launch, -1 if unknown */
 #ifdef _WIN32
     HANDLE process_handle;
 #endif
@@ -48,9 +60,16 @@ struct zzuf_child
     int bytes, seed;
     double ratio;
     int64_t date;
-    zzuf_md5sum_t *md5;
     zzuf_hexdump_t *hex;
     char **newargv;
+    char *crash; /* crash record sent by libzzuf, or NULL */
+    char *report; /* error report found in the output, or NULL */
+    uint8_t *debug; /* incomplete last line of the debug channel */
+    int debuglen;
+    int64_t flips; /* bits flipped according to libzzuf, -1 if unknown */
+    int closed; /* all watched files were closed at least once */
+    zzuf_scan_state_t scan[2]; /* for stderr and stdout */
+    zzuf_ring_t *ring[2]; /* same, only for --output */
 };
 
 struct zzuf_opts
@@ -64,6 +83,17 @@ struct zzuf_opts
     char **oldargv;
     int oldargc;
     char *fuzzing, *bytes, *list, *ports, *protect, *refuse, *allow;
+    char *cpulist;
+    char **watch; /* user patterns for -w */
+    int nwatch;
+    char *outdir; /* where to save crashing children output, or NULL */
+    int outsize;
+    char *noveltyfile; /* for --novelty */
+    char *profilefile; /* for --profile-reads */
+    char *autobytes; /* -b ranges built from a profile, or NULL */
+    char *checksums; /* for --fix-checksums */
+    char *insertdelete; /* for --insert-delete */
+    char *mutator; /* for --mutator */
 
     uint32_t seed;
     uint32_t endseed;
@@ -72,23 +102,43 @@ struct zzuf_opts
     double maxratio;
 
     int b_md5;
+    enum zzuf_hash hash; /* for -m */
     int b_hex;
     int b_checkexit;
     int b_verbose;
     int b_quiet;
+    int b_pin;
+    int b_cgroup;
+    int b_crashinfo;
+    int b_skipunfuzzed;
 
     int maxbytes;
     int maxcpu;
     int maxmem;
+    double cgroupcpu; /* CPUs worth of time per slot, 0.0 for no limit */
 
     int64_t starttime;
     int64_t maxtime;
     int64_t maxusertime;
     int64_t delay;
-    int64_t lastlaunch;
+    int64_t nextlaunch; /* token bucket for -D: see launch_delay() */
+    int burst;
 
     int maxchild, nchild, maxcrashes, crashes;
+    int jobs; /* current limit on nchild, at most maxchild */
+    int ncpus; /* number of CPUs children are pinned to, or 0 */
+    int64_t nreaped;
+    int64_t unfuzzed; /* children that read nothing fuzzed */
 
     zzuf_child_t *child;
+    zzuf_loop_t *loop;
+    zzuf_jobs_t *autojobs; /* NULL unless "-j auto" */
+    zzuf_cgroup_t *cgroup; /* NULL unless "--cgroup" */
+    zzuf_crashes_t *buckets;
+    zzuf_scan_t *scan;
+    zzuf_digest_t *digest; /* NULL unless -m or --novelty */
+    zzuf_novelty_t *novelty;
+    zzuf_dedup_t *dedup; /* NULL unless --skip-duplicates */
+    zzuf_profile_t *profile; /* NULL unless --profile-reads */
 };
 
@@ -0,0 +1,197 @@
+/*
+ *  zzuf - general purpose fuzzer
+ *
+ *  Copyright © 2002—2015 Sam Hocevar <sam@hocevar.net>
+ *
+ *  This program is free software. It comes without any warranty, to
+ *  the extent permitted by applicable law. You can redistribute it
+ *  and/or modify it under the terms of the Do What the Fuck You Want
+ *  to Public License, Version 2, as published by the WTFPL Task Force.
+ *  See http://www.wtfpl.net/ for more details.
+ */
+
+/*
+ *  profile.c: parts of the input read by children
+ *
+ *  libzzuf sends the ranges of file offsets read by each child, with the
+ *  number of reads that hit them. We merge them and save them in a text
+ *  file, one range per line, that can be edited by hand or fed back to
+ *  zzuf to only fuzz the bytes that are actually read:
+ *
+ *    # zzuf read profile: start end hits
+ *    0 4096 12
+ *    8192 8300 3
+ *
+ *  Offsets are the same for all fuzzed files, just like with -b. If the
+ *  file already exists, new ranges are merged with the ones it contains.
+ */
+
+#include "config.h"
+
+#define _DEFAULT_SOURCE /* for strdup() */
+
+#if defined HAVE_STDINT_H
+#   include <stdint.h>
+#elif defined HAVE_INTTYPES_H
+#   include <inttypes.h>
+#endif
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "util/extents.h"
+#include "profile.h"
+
+#define HEADER "# zzuf read profile: start end hits\n"
+
+struct zzuf_profile
+{
+    char *path;
+    zzuf_extents_t reads;
+};
+
+static int load(zzuf_extents_t *reads, char const *path);
+
+zzuf_profile_t *zzuf_create_profile(char const *path)
+{
+    zzuf_profile_t *p = calloc(1, sizeof(zzuf_profile_t));
+
+    p->path = strdup(path);
+    p->reads.grow = 1;
+
+    if (load(&p->reads, path) < 0)
+    {
+        fprintf(stderr, "zzuf: `%s' is not a read profile\n", path);
+        zzuf_destroy_profile(p);
+        return NULL;
+    }
+
+    return p;
+}
+
+void zzuf_destroy_profile(zzuf_profile_t *p)
+{
+    free(p->reads.list);
+    free(p->path);
+    free(p);
+}
+
+/*
+ * Merge a read record from libzzuf, without its marker: a list of
+ * "start-end:hits" items separated by spaces.
+ */
+void zz_profile_add(zzuf_profile_t *p, char const *record)
+{
+    long long int start, end, hits;
+    int n;
+
+    while (sscanf(record, " %lld-%lld:%lld%n", &start, &end, &hits, &n) == 3)
+    {
+        zz_extents_add(&p->reads, start, end, hits);
+        record += n;
+    }
+}
+
+int zz_profile_save(zzuf_profile_t *p)
+{
+    FILE *fp = fopen(p->path, "w");
+    if (!fp)
+    {
+        fprintf(stderr, "zzuf: cannot write `%s'\n", p->path);
+        return -1;
+    }
+
+    fputs(HEADER, fp);
+    for (int i = 0; i < p->reads.count; ++i)
+        fprintf(fp, "%lli %lli %lli\n",
+                (long long int)p->reads.list[i].start,
+                (long long int)p->reads.list[i].end,
+                (long long int)p->reads.list[i].hits);
+
+    return fclose(fp) ? -1 : 0;
+}
+
+void zz_profile_summary(zzuf_profile_t *p, FILE *fp)
+{
+    int64_t bytes = 0;
+
+    for (int i = 0; i < p->reads.count; ++i)
+        bytes += p->reads.list[i].end - p->reads.list[i].start;
+
+    fprintf(fp, "zzuf: %lli byte%s read in %i range%s, saved in `%s'\n",
+            (long long int)bytes, bytes > 1 ? "s" : "",
+            p->reads.count, p->reads.count > 1 ? "s" : "", p->path);
+}
+
+/*
+ * Build a list of ranges suitable for -b from a profile. Returns NULL
+ * if the profile cannot be read or is empty.
+ */
+char *zz_profile_ranges(char const *path)
+{
+    zzuf_extents_t reads = { NULL, 0, 0, 1 };
+
+    if (load(&reads, path) < 0 || !reads.count)
+    {
+        free(reads.list);
+        return NULL;
+    }
+
+    /* Each range takes at most 2 * 20 digits, a dash and a comma */
+    char *ranges = malloc(reads.count * 42 + 1), *tmp = ranges;
+
+    for (int i = 0; i < reads.count; ++i)
+    {
+        long long int start = reads.list[i].start, end = reads.list[i].end;
+
+        tmp += sprintf(tmp, i ? ",%lli" : "%lli", start);
+        if (end - start > 1)
+            tmp += sprintf(tmp, "-%lli", end - 1);
+    }
+
+    free(reads.list);
+    return ranges;
+}
+
+/*
+ * Load a profile; a missing file is an empty profile. Returns -1 if the
+ * file is not a profile.
+ */
+static int load(zzuf_extents_t *reads, char const *path)
+{
+    char line[256];
+
+    FILE *fp = fopen(path, "r");
+    if (!fp)
+        return 0;
+
+    /* An empty file is an empty profile, too */
+    if (!fgets(line, sizeof(line), fp))
+    {
+        fclose(fp);
+        return 0;
+    }
+
+    if (strcmp(line, HEADER))
+    {
+        fclose(fp);
+        return -1;
+    }
+
+    while (fgets(line, sizeof(line), fp))
+    {
+        long long int start, end, hits;
+
+        if (sscanf(line, "%lld %lld %lld", &start, &end, &hits) != 3
+             || start < 0 || end <= start)
+        {
+            fclose(fp);
+            return -1;
+        }
+
+        zz_extents_add(reads, start, end, hits);
+    }
+
+    fclose(fp);
+    return 0;
+}
@@ -0,0 +1,30 @@
+/*
+ *  zzuf - general purpose fuzzer
+ *
+ *  Copyright © 2002—2015 Sam Hocevar <sam@hocevar.net>
+ *
+ *  This program is free software. It comes without any warranty, to
+ *  the extent permitted by applicable law. You can redistribute it
+ *  and/or modify it under the terms of the Do What the Fuck You Want
+ *  to Public License, Version 2, as published by the WTFPL Task Force.
+ *  See http://www.wtfpl.net/ for more details.
+ */
+
+#pragma once
+
+/*
+ *  profile.h: parts of the input read by children
+ */
+
+#include <stdio.h>
+
+typedef struct zzuf_profile zzuf_profile_t;
+
+extern zzuf_profile_t *zzuf_create_profile(char const *path);
+extern void zzuf_destroy_profile(zzuf_profile_t *);
+
+extern void zz_profile_add(zzuf_profile_t *, char const *record);
+extern int zz_profile_save(zzuf_profile_t *);
+extern void zz_profile_summary(zzuf_profile_t *, FILE *);
+
+extern char *zz_profile_ranges(char const *path);
@@ -0,0 +1,467 @@
+/*
+ *  zzuf - general purpose fuzzer
+ *
+ *  Copyright © 2002—2015 Sam Hocevar <sam@hocevar.net>
+ *
+ *  This program is free software. It comes without any warranty, to
+ *  the extent permitted by applicable law. You can redistribute it
+ *  and/or modify it under the terms of the Do What the Fuck You Want
+ *  to Public License, Version 2, as published by the WTFPL Task Force.
+ *  See http://www.wtfpl.net/ for more details.
+ */
+
+/*
+ *  scan.c: detection of error reports in child output
+ *
+ *  Children's stdout and stderr go through an Aho-Corasick automaton that
+ *  looks for sanitizer report headers, C library abort messages and user
+ *  patterns all at once. The automaton is compiled into a full transition
+ *  table, so that it costs one table lookup per byte and never needs to go
+ *  back when a partial match fails.
+ *
+ *  Table lookups depend on each other, though, which limits us to a few
+ *  hundred megabytes per second. So while the automaton is in its initial
+ *  state, we first look for the first two bytes of any pattern, 16 bytes
+ *  at a time with SSE2, or using a bitmap of all such byte pairs.
+ *
+ *  When a pattern matches, we collect the rest of the line and extract a
+ *  short description of the error and, when available, its first stack
+ *  frame, so that reports can be sorted into crash buckets.
+ */
+
+#include "config.h"
+
+#define _DEFAULT_SOURCE /* for strdup() */
+
+#if defined HAVE_STDINT_H
+#   include <stdint.h>
+#elif defined HAVE_INTTYPES_H
+#   include <inttypes.h>
+#endif
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdarg.h>
+#include <string.h>
+#if defined __SSE2__
+#   include <emmintrin.h>
+#endif
+
+#include "scan.h"
+
+enum what
+{
+    WHAT_SANITIZER, /* "<name>: <error type>" */
+    WHAT_UBSAN,     /* "<file:line:col>: runtime error: <error type>: ..." */
+    WHAT_FRAME,     /* "#0 0x<address> in <function> <file:line>" */
+    WHAT_ASSERT,    /* "<prog>: <file:line>: <function>: Assertion `...'" */
+    WHAT_PLAIN,     /* the pattern itself is the description */
+    WHAT_USER,      /* user-supplied pattern */
+};
+
+static struct pattern
+{
+    char const *str, *name;
+    enum what what;
+}
+const builtins[] =
+{
+    { "ERROR: AddressSanitizer: ",   "AddressSanitizer",   WHAT_SANITIZER },
+    { "ERROR: MemorySanitizer: ",    "MemorySanitizer",    WHAT_SANITIZER },
+    { "WARNING: MemorySanitizer: ",  "MemorySanitizer",    WHAT_SANITIZER },
+    { "ERROR: ThreadSanitizer: ",    "ThreadSanitizer",    WHAT_SANITIZER },
+    { "WARNING: ThreadSanitizer: ",  "ThreadSanitizer",    WHAT_SANITIZER },
+    { "ERROR: HWAddressSanitizer: ", "HWAddressSanitizer", WHAT_SANITIZER },
+    { "ERROR: LeakSanitizer: ",      "LeakSanitizer: memory leak", WHAT_PLAIN },
+    { "runtime error: ",             "UndefinedBehaviorSanitizer", WHAT_UBSAN },
+    { "#0 0x",                       NULL,                 WHAT_FRAME },
+    { "Assertion `",                 "assertion",          WHAT_ASSERT },
+    { "*** stack smashing detected ***", "stack smashing", WHAT_PLAIN },
+    { "*** buffer overflow detected ***", "buffer overflow", WHAT_PLAIN },
+    { "double free or corruption",   "double free or corruption", WHAT_PLAIN },
+    { "free(): invalid pointer",     "free(): invalid pointer", WHAT_PLAIN },
+    { "malloc(): corrupted",         "malloc(): corrupted heap", WHAT_PLAIN },
+    { "' panicked at ",              "Rust panic",         WHAT_PLAIN },
+};
+
+#define NBUILTINS (int)(sizeof(builtins) / sizeof(*builtins))
+
+/* Beyond this many different two-byte prefixes, SSE2 is not worth it */
+#define MAXPAIRS 16
+
+struct zzuf_scan
+{
+    struct pattern *patterns;
+    int npatterns, nstates;
+    uint16_t *delta; /* nstates * 256 transitions */
+    int16_t *out; /* pattern matched in each state, or -1 */
+    uint8_t prefix[65536 / 8]; /* bitmap of two-byte pattern prefixes */
+    int skip; /* whether we may use the prefix table */
+    /* The same prefixes as a list, for SSE2; empty if too many of them */
+    uint8_t pairs[MAXPAIRS][2];
+    int npairs;
+};
+
+static size_t skip(zzuf_scan_t const *, uint8_t const *, size_t, size_t);
+static void process(zzuf_scan_t *, zzuf_scan_state_t *, char **report);
+static int location(char **line, char const *match);
+static void add_report(char **report, char const *fmt, ...);
+
+zzuf_scan_t *zzuf_create_scan(char * const *patterns, int npatterns)
+{
+    zzuf_scan_t *sc = malloc(sizeof(zzuf_scan_t));
+
+    sc->npatterns = NBUILTINS + npatterns;
+    sc->patterns = malloc(sc->npatterns * sizeof(struct pattern));
+    memcpy(sc->patterns, builtins, sizeof(builtins));
+    for (int i = 0; i < npatterns; ++i)
+    {
+        sc->patterns[NBUILTINS + i].str = patterns[i];
+        sc->patterns[NBUILTINS + i].name = patterns[i];
+        sc->patterns[NBUILTINS + i].what = WHAT_USER;
+    }
+
+    /* There cannot be more states than pattern bytes, plus the root */
+    int maxstates = 1;
+    for (int i = 0; i < sc->npatterns; ++i)
+        maxstates += (int)strlen(sc->patterns[i].str);
+    if (maxstates > 65535)
+        maxstates = 65535;
+
+    sc->delta = calloc((size_t)maxstates * 256, sizeof(uint16_t));
+    sc->out = malloc(maxstates * sizeof(int16_t));
+    int *fail = calloc(maxstates, sizeof(int));
+    int *queue = malloc(maxstates * sizeof(int));
+
+    /* The prefix table only works if no pattern is shorter than that */
+    memset(sc->prefix, 0, sizeof(sc->prefix));
+    sc->skip = 1;
+    for (int i = 0; i < sc->npatterns; ++i)
+    {
+        uint8_t const *p = (uint8_t const *)sc->patterns[i].str;
+        if (!p[0])
+            continue;
+        if (!p[1])
+            sc->skip = 0;
+        else
+            sc->prefix[(p[0] << 5) | (p[1] >> 3)] |= 1 << (p[1] & 7);
+    }
+
+    sc->npairs = 0;
+    for (int i = 0; i < 65536 && sc->npairs <= MAXPAIRS; ++i)
+        if (sc->prefix[i >> 3] & (1 << (i & 7)))
+        {
+            if (sc->npairs < MAXPAIRS)
+            {
+                sc->pairs[sc->npairs][0] = (uint8_t)(i >> 8);
+                sc->pairs[sc->npairs][1] = (uint8_t)i;
+            }
+            ++sc->npairs;
+        }
+    if (sc->npairs > MAXPAIRS)
+        sc->npairs = 0;
+
+    /* Build the trie; zero means "no transition yet" since no edge can
+     * lead back to the root while building it. */
+    sc->nstates = 1;
+    sc->out[0] = -1;
+    for (int i = 0; i < sc->npatterns; ++i)
+    {
+        uint8_t const *p = (uint8_t const *)sc->patterns[i].str;
+        int s = 0;
+
+        if (!*p)
+            continue;
+
+        for ( ; *p; ++p)
+        {
+            uint16_t *next = &sc->delta[s * 256 + *p];
+            if (!*next)
+            {
+                if (sc->nstates == maxstates)
+                    break;
+                sc->out[sc->nstates] = -1;
+                *next = (uint16_t)sc->nstates++;
+            }
+            s = *next;
+        }
+
+        if (!*p && sc->out[s] < 0)
+            sc->out[s] = (int16_t)i;
+    }
+
+    /* Turn the trie into a DFA, breadth first: missing transitions go
+     * where the longest proper suffix would go, and states inherit the
+     * matches of their suffix. */
+    int head = 0, tail = 0;
+    for (int c = 0; c < 256; ++c)
+        if (sc->delta[c])
+            queue[tail++] = sc->delta[c];
+
+    while (head < tail)
+    {
+        int s = queue[head++];
+
+        if (sc->out[s] < 0)
+            sc->out[s] = sc->out[fail[s]];
+
+        for (int c = 0; c < 256; ++c)
+        {
+            uint16_t *next = &sc->delta[s * 256 + c];
+            if (*next)
+            {
+                fail[*next] = sc->delta[fail[s] * 256 + c];
+                queue[tail++] = *next;
+            }
+            else
+                *next = sc->delta[fail[s] * 256 + c];
+        }
+    }
+
+    free(queue);
+    free(fail);
+
+    return sc;
+}
+
+void zzuf_destroy_scan(zzuf_scan_t *sc)
+{
+    free(sc->delta);
+    free(sc->out);
+    free(sc->patterns);
+    free(sc);
+}
+
+void zz_scan_reset(zzuf_scan_state_t *st)
+{
+    st->state = 0;
+    st->match = -1;
+    st->len = 0;
+    st->offset = 0;
+    st->frame = 0;
+}
+
+/*
+ * Feed child output to the automaton. When something is found, a short
+ * description is stored in *report, unless there is already one, in which
+ * case we may only append a stack frame to it.
+ */
+void zz_scan_feed(zzuf_scan_t *sc, zzuf_scan_state_t *st,
+                  uint8_t const *buf, size_t len, char **report)
+{
+    uint16_t const *delta = sc->delta;
+    int16_t const *out = sc->out;
+
+    for (size_t i = 0; i < len; )
+    {
+        if (st->match >= 0)
+        {
+            /* Collect the rest of the line */
+            for ( ; i < len && buf[i] != '\n'
+                     && st->len < (int)sizeof(st->line) - 1; ++i)
+                st->line[st->len++] = buf[i];
+
+            if (i == len)
+                break;
+
+            st->line[st->len] = '\0';
+            process(sc, st, report);
+            st->match = -1;
+            st->state = 0;
+            continue;
+        }
+
+        /* Fast path: this is where we spend all our time */
+        int s = st->state;
+        for ( ; i < len; ++i)
+        {
+            if (s == 0 && sc->skip)
+                i = skip(sc, buf, i, len);
+
+            s = delta[s * 256 + buf[i]];
+            if (out[s] >= 0)
+                break;
+        }
+        st->state = s;
+
+        if (i == len)
+            break;
+
+        /* Found something: keep the beginning of the line, as far as
+         * this buffer goes, since some reports start with a location */
+        size_t start = i, plen = strlen(sc->patterns[out[s]].str);
+        while (start > 0 && buf[start - 1] != '\n'
+                && i + 1 - start < sizeof(st->line) / 2)
+            --start;
+
+        st->match = out[s];
+        st->len = (int)(i + 1 - start);
+        st->offset = st->len >= (int)plen ? st->len - plen : 0;
+        memcpy(st->line, buf + start, st->len);
+        ++i;
+    }
+}
+
+/*
+ * Return the first position, starting from i, where a pattern may start.
+ * The last byte of the buffer is always a candidate, since we do not know
+ * what follows.
+ */
+static size_t skip(zzuf_scan_t const *sc, uint8_t const *buf,
+                   size_t i, size_t len)
+{
+#if defined __SSE2__
+    __m128i first[MAXPAIRS], second[MAXPAIRS];
+    int const npairs = i + 17 <= len ? sc->npairs : 0;
+
+    for (int k = 0; k < npairs; ++k)
+    {
+        first[k] = _mm_set1_epi8((char)sc->pairs[k][0]);
+        second[k] = _mm_set1_epi8((char)sc->pairs[k][1]);
+    }
+
+    if (npairs)
+        for ( ; i + 17 <= len; i += 16)
+        {
+            __m128i a = _mm_loadu_si128((__m128i const *)(buf + i));
+            __m128i b = _mm_loadu_si128((__m128i const *)(buf + i + 1));
+            __m128i hits = _mm_setzero_si128();
+
+            for (int k = 0; k < npairs; ++k)
+                hits = _mm_or_si128(hits,
+                           _mm_and_si128(_mm_cmpeq_epi8(a, first[k]),
+                                         _mm_cmpeq_epi8(b, second[k])));
+
+            int mask = _mm_movemask_epi8(hits);
+            if (mask)
+            {
+                while (!(mask & 1))
+                {
+                    mask >>= 1;
+                    ++i;
+                }
+                return i;
+            }
+        }
+#endif
+
+    while (i + 1 < len && !(sc->prefix[(buf[i] << 5) | (buf[i + 1] >> 3)]
+                              & (1 << (buf[i + 1] & 7))))
+        ++i;
+
+    return i;
+}
+
+/*
+ * Called when the child exits, in case its last line had no newline.
+ */
+void zz_scan_flush(zzuf_scan_t *sc, zzuf_scan_state_t *st, char **report)
+{
+    zz_scan_feed(sc, st, (uint8_t const *)"\n", 1, report);
+}
+
+static void process(zzuf_scan_t *sc, zzuf_scan_state_t *st, char **report)
+{
+    struct pattern const *p = &sc->patterns[st->match];
+    char *line = st->line, *match = line + st->offset;
+    char *after = match + strlen(p->str);
+    size_t n;
+    int loc;
+
+    if (after > line + st->len)
+        after = line + st->len;
+
+    /* Strip the trailing carriage return, if any */
+    n = strlen(line);
+    if (n && line[n - 1] == '\r')
+        line[n - 1] = '\0';
+
+    switch (p->what)
+    {
+    case WHAT_SANITIZER:
+        /* Error types are followed by addresses, thread IDs etc. */
+        for (n = 0; after[n] && !(after[n] >= '0' && after[n] <= '9')
+                     && strncmp(after + n, " on ", 4)
+                     && strncmp(after + n, " at ", 4)
+                     && strncmp(after + n, " (", 2); ++n)
+            ;
+        while (n && after[n - 1] == ' ')
+            --n;
+        add_report(report, "%s: %.*s", p->name, (int)n, after);
+        st->frame = 1;
+        break;
+    case WHAT_UBSAN:
+        /* The location comes before the match; the error type ends at
+         * the first colon, after which come actual values */
+        n = strcspn(after, ":");
+        loc = location(&line, match);
+        add_report(report, "%s: %.*s in %.*s", p->name, (int)n, after,
+                   loc, line);
+        break;
+    case WHAT_FRAME:
+        /* Only the innermost frame of the first report is interesting */
+        if (!st->frame || !*report)
+            break;
+        while ((*after >= '0' && *after <= '9')
+                || (*after >= 'a' && *after <= 'f'))
+            ++after;
+        while (*after == ' ')
+            ++after;
+        if (!strncmp(after, "in ", 3))
+            after += 3;
+        if (*after)
+        {
+            char *tmp = malloc(strlen(*report) + strlen(after) + 5);
+            sprintf(tmp, "%s in %s", *report, after);
+            free(*report);
+            *report = tmp;
+        }
+        st->frame = 0;
+        break;
+    case WHAT_ASSERT:
+        n = strlen(after);
+        if (n && after[n - 1] == '.')
+            --n;
+        loc = location(&line, match);
+        add_report(report, "%s `%.*s in %.*s", p->name, (int)n, after,
+                   loc, line);
+        break;
+    case WHAT_PLAIN:
+        add_report(report, "%s", p->name);
+        break;
+    case WHAT_USER:
+        add_report(report, "output matched `%s'", p->name);
+        break;
+    }
+}
+
+/*
+ * The location of UBSan errors and assertions comes before the match, as
+ * in "foo.c:12:5: runtime error: ...". Return its length and skip leading
+ * spaces.
+ */
+static int location(char **line, char const *match)
+{
+    while (**line == ' ')
+        ++*line;
+
+    int n = (int)(match - *line);
+    while (n > 0 && ((*line)[n - 1] == ' ' || (*line)[n - 1] == ':'))
+        --n;
+
+    return n;
+}
+
+static void add_report(char **report, char const *fmt, ...)
+{
+    char buf[BUFSIZ];
+    va_list args;
+
+    if (*report)
+        return;
+
+    va_start(args, fmt);
+    vsnprintf(buf, sizeof(buf), fmt, args);
+    va_end(args);
+
+    *report = strdup(buf);
+}
@@ -0,0 +1,38 @@
+/*
+ *  zzuf - general purpose fuzzer
+ *
+ *  Copyright © 2002—2015 Sam Hocevar <sam@hocevar.net>
+ *
+ *  This program is free software. It comes without any warranty, to
+ *  the extent permitted by applicable law. You can redistribute it
+ *  and/or modify it under the terms of the Do What the Fuck You Want
+ *  to Public License, Version 2, as published by the WTFPL Task Force.
+ *  See http://www.wtfpl.net/ for more details.
+ */
+
+#pragma once
+
+/*
+ *  scan.h: detection of error reports in child output
+ */
+
+#include <stddef.h>
+
+typedef struct zzuf_scan zzuf_scan_t;
+
+/* Matching state for one output stream of one child */
+typedef struct zzuf_scan_state
+{
+    int state, match, len;
+    int frame; /* waiting for the first stack frame of a report */
+    size_t offset; /* where the match starts in line[] */
+    char line[256];
+} zzuf_scan_state_t;
+
+extern zzuf_scan_t *zzuf_create_scan(char * const *patterns, int npatterns);
+extern void zzuf_destroy_scan(zzuf_scan_t *);
+
+extern void zz_scan_reset(zzuf_scan_state_t *);
+extern void zz_scan_feed(zzuf_scan_t *, zzuf_scan_state_t *,
+                         uint8_t const *buf, size_t len, char **report);
+extern void zz_scan_flush(zzuf_scan_t *, zzuf_scan_state_t *, char **report);
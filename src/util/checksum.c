@@ -0,0 +1,247 @@
+/*
+ *  zzuf - general purpose fuzzer
+ *
+ *  Copyright © 2002—2015 Sam Hocevar <sam@hocevar.net>
+ *
+ *  This program is free software. It comes without any warranty, to
+ *  the extent permitted by applicable law. You can redistribute it
+ *  and/or modify it under the terms of the Do What the Fuck You Want
+ *  to Public License, Version 2, as published by the WTFPL Task Force.
+ *  See http://www.wtfpl.net/ for more details.
+ */
+
+
+/*
+ *  checksum.c: CRC-32 and Adler-32 computation
+ *
+ *  The CRC-32 is the one used by zlib, PNG and ZIP. It is computed with
+ *  the ARMv8 CRC instructions when the compiler targets them, by folding
+ *  with carry-less multiplications on x86 CPUs that have PCLMULQDQ, and
+ *  with slicing-by-8 tables otherwise.
+ */
+
+#include "config.h"
+
+#if defined HAVE_STDINT_H
+#   include <stdint.h>
+#elif defined HAVE_INTTYPES_H
+#   include <inttypes.h>
+#endif
+#include <stddef.h>
+#include <string.h>
+
+#if defined __ARM_FEATURE_CRC32 && defined HAVE_ARM_ACLE_H
+#   include <arm_acle.h>
+#   define USE_ARM_CRC 1
+#elif (defined __x86_64__ || defined __i386__) && defined __GNUC__ \
+       && defined HAVE_CPUID_H && defined HAVE_SMMINTRIN_H \
+       && defined HAVE_WMMINTRIN_H
+#   include <cpuid.h>
+#   include <smmintrin.h>
+#   include <wmmintrin.h>
+#   define USE_PCLMUL 1
+#endif
+
+#include "util/checksum.h"
+
+#if !defined USE_ARM_CRC
+static uint32_t slice8(uint32_t crc, uint8_t const *buf, size_t len);
+#endif
+#if defined USE_PCLMUL
+static uint32_t fold(uint32_t crc, uint8_t const *buf, size_t len);
+#endif
+
+uint32_t zz_crc32(uint32_t crc, uint8_t const *buf, size_t len)
+{
+    crc = ~crc;
+
+#if defined USE_ARM_CRC
+    for (; len && ((uintptr_t)buf & 7); --len)
+        crc = __crc32b(crc, *buf++);
+    for (; len >= 8; buf += 8, len -= 8)
+    {
+        uint64_t tmp;
+        memcpy(&tmp, buf, 8);
+        crc = __crc32d(crc, tmp);
+    }
+    while (len--)
+        crc = __crc32b(crc, *buf++);
+#else
+#   if defined USE_PCLMUL
+    /* 0 means not tested yet; the answer does not change, so several
+     * threads may safely race to compute it */
+    static int has_pclmul = 0;
+
+    if (!has_pclmul)
+    {
+        unsigned int eax, ebx, ecx, edx;
+        has_pclmul = __get_cpuid(1, &eax, &ebx, &ecx, &edx)
+                      && (ecx & bit_PCLMUL) && (ecx & bit_SSE4_1) ? 1 : -1;
+    }
+
+    if (has_pclmul > 0 && len >= 64)
+    {
+        size_t n = len & ~(size_t)15;
+        crc = fold(crc, buf, n);
+        buf += n;
+        len -= n;
+    }
+#   endif
+    crc = slice8(crc, buf, len);
+#endif
+
+    return ~crc;
+}
+
+/* Adler-32 sums are reduced every 5552 bytes, the largest count for which
+ * the second sum cannot overflow 32 bits. */
+uint32_t zz_adler32(uint32_t adler, uint8_t const *buf, size_t len)
+{
+    uint32_t a = adler & 0xffff, b = adler >> 16;
+
+    while (len)
+    {
+        size_t n = len < 5552 ? len : 5552;
+
+        len -= n;
+        while (n--)
+        {
+            a += *buf++;
+            b += a;
+        }
+        a %= 65521;
+        b %= 65521;
+    }
+
+    return (b << 16) | a;
+}
+
+#if !defined USE_ARM_CRC
+/* The tables are built on first use. As with has_pclmul above, racing
+ * threads can only write the same values. */
+static uint32_t table[8][256];
+static int table_ready = 0;
+
+static uint32_t slice8(uint32_t crc, uint8_t const *buf, size_t len)
+{
+    if (!table_ready)
+    {
+        for (int i = 0; i < 256; ++i)
+        {
+            uint32_t c = (uint32_t)i;
+            for (int k = 0; k < 8; ++k)
+                c = (c >> 1) ^ (0xedb88320 & (0 - (c & 1)));
+            table[0][i] = c;
+        }
+        for (int i = 0; i < 256; ++i)
+            for (int k = 1; k < 8; ++k)
+                table[k][i] = (table[k - 1][i] >> 8)
+                            ^ table[0][table[k - 1][i] & 0xff];
+        table_ready = 1;
+    }
+
+    for (; len >= 8; buf += 8, len -= 8)
+    {
+        uint32_t lo = crc ^ ((uint32_t)buf[0] | (uint32_t)buf[1] << 8
+                              | (uint32_t)buf[2] << 16
+                              | (uint32_t)buf[3] << 24);
+        crc = table[7][lo & 0xff] ^ table[6][(lo >> 8) & 0xff]
+            ^ table[5][(lo >> 16) & 0xff] ^ table[4][lo >> 24]
+            ^ table[3][buf[4]] ^ table[2][buf[5]]
+            ^ table[1][buf[6]] ^ table[0][buf[7]];
+    }
+
+    while (len--)
+        crc = (crc >> 8) ^ table[0][(crc ^ *buf++) & 0xff];
+
+    return crc;
+}
+#endif
+
+#if defined USE_PCLMUL
+/* Fold 64 bytes at a time with carry-less multiplications, then reduce
+ * the remaining 128 bits with Barrett's method. The constants are powers
+ * of x modulo the bit-reflected CRC-32 polynomial, as described in Intel's
+ * "Fast CRC Computation for Generic Polynomials Using PCLMULQDQ". The
+ * length must be a multiple of 16 and at least 64. */
+__attribute__((target("pclmul,sse4.1")))
+static uint32_t fold(uint32_t crc, uint8_t const *buf, size_t len)
+{
+    static uint64_t const k1k2[2] = { 0x0154442bd4, 0x01c6e41596 };
+    static uint64_t const k3k4[2] = { 0x01751997d0, 0x00ccaa009e };
+    static uint64_t const k5k0[2] = { 0x0163cd6124, 0x0000000000 };
+    static uint64_t const poly[2] = { 0x01db710641, 0x01f7011641 };
+
+    __m128i x0, x1, x2, x3, x4, x5, x6, x7, x8;
+
+    x1 = _mm_loadu_si128((__m128i const *)(void const *)(buf + 0x00));
+    x2 = _mm_loadu_si128((__m128i const *)(void const *)(buf + 0x10));
+    x3 = _mm_loadu_si128((__m128i const *)(void const *)(buf + 0x20));
+    x4 = _mm_loadu_si128((__m128i const *)(void const *)(buf + 0x30));
+    x1 = _mm_xor_si128(x1, _mm_cvtsi32_si128((int)crc));
+    x0 = _mm_loadu_si128((__m128i const *)(void const *)k1k2);
+    buf += 64;
+    len -= 64;
+
+    /* Four parallel folds */
+    for (; len >= 64; buf += 64, len -= 64)
+    {
+        x5 = _mm_clmulepi64_si128(x1, x0, 0x00);
+        x6 = _mm_clmulepi64_si128(x2, x0, 0x00);
+        x7 = _mm_clmulepi64_si128(x3, x0, 0x00);
+        x8 = _mm_clmulepi64_si128(x4, x0, 0x00);
+        x1 = _mm_clmulepi64_si128(x1, x0, 0x11);
+        x2 = _mm_clmulepi64_si128(x2, x0, 0x11);
+        x3 = _mm_clmulepi64_si128(x3, x0, 0x11);
+        x4 = _mm_clmulepi64_si128(x4, x0, 0x11);
+        x1 = _mm_xor_si128(_mm_xor_si128(x1, x5), _mm_loadu_si128(
+                 (__m128i const *)(void const *)(buf + 0x00)));
+        x2 = _mm_xor_si128(_mm_xor_si128(x2, x6), _mm_loadu_si128(
+                 (__m128i const *)(void const *)(buf + 0x10)));
+        x3 = _mm_xor_si128(_mm_xor_si128(x3, x7), _mm_loadu_si128(
+                 (__m128i const *)(void const *)(buf + 0x20)));
+        x4 = _mm_xor_si128(_mm_xor_si128(x4, x8), _mm_loadu_si128(
+                 (__m128i const *)(void const *)(buf + 0x30)));
+    }
+
+    /* Fold the four accumulators into one */
+    x0 = _mm_loadu_si128((__m128i const *)(void const *)k3k4);
+    x5 = _mm_clmulepi64_si128(x1, x0, 0x00);
+    x1 = _mm_clmulepi64_si128(x1, x0, 0x11);
+    x1 = _mm_xor_si128(_mm_xor_si128(x1, x2), x5);
+    x5 = _mm_clmulepi64_si128(x1, x0, 0x00);
+    x1 = _mm_clmulepi64_si128(x1, x0, 0x11);
+    x1 = _mm_xor_si128(_mm_xor_si128(x1, x3), x5);
+    x5 = _mm_clmulepi64_si128(x1, x0, 0x00);
+    x1 = _mm_clmulepi64_si128(x1, x0, 0x11);
+    x1 = _mm_xor_si128(_mm_xor_si128(x1, x4), x5);
+
+    /* Remaining blocks of 16 bytes */
+    for (; len >= 16; buf += 16, len -= 16)
+    {
+        x5 = _mm_clmulepi64_si128(x1, x0, 0x00);
+        x1 = _mm_clmulepi64_si128(x1, x0, 0x11);
+        x1 = _mm_xor_si128(_mm_xor_si128(x1, x5), _mm_loadu_si128(
+                 (__m128i const *)(void const *)buf));
+    }
+
+    /* Fold 128 bits to 64 bits */
+    x2 = _mm_clmulepi64_si128(x1, x0, 0x10);
+    x3 = _mm_setr_epi32(~0, 0, ~0, 0);
+    x1 = _mm_xor_si128(_mm_srli_si128(x1, 8), x2);
+    x0 = _mm_loadl_epi64((__m128i const *)(void const *)k5k0);
+    x2 = _mm_srli_si128(x1, 4);
+    x1 = _mm_and_si128(x1, x3);
+    x1 = _mm_xor_si128(_mm_clmulepi64_si128(x1, x0, 0x00), x2);
+
+    /* Barrett reduction to 32 bits */
+    x0 = _mm_loadu_si128((__m128i const *)(void const *)poly);
+    x2 = _mm_and_si128(x1, x3);
+    x2 = _mm_clmulepi64_si128(x2, x0, 0x10);
+    x2 = _mm_and_si128(x2, x3);
+    x2 = _mm_clmulepi64_si128(x2, x0, 0x00);
+    x1 = _mm_xor_si128(x1, x2);
+
+    return (uint32_t)_mm_extract_epi32(x1, 1);
+}
+#endif
@@ -0,0 +1,23 @@
+/*
+ *  zzuf - general purpose fuzzer
+ *
+ *  Copyright © 2002—2015 Sam Hocevar <sam@hocevar.net>
+ *
+ *  This program is free software. It comes without any warranty, to
+ *  the extent permitted by applicable law. You can redistribute it
+ *  and/or modify it under the terms of the Do What the Fuck You Want
+ *  to Public License, Version 2, as published by the WTFPL Task Force.
+ *  See http://www.wtfpl.net/ for more details.
+ */
+
+
+#pragma once
+
+/*
+ *  checksum.h: CRC-32 and Adler-32 computation
+ */
+
+/* Both functions take the checksum of the previous data, or 0 and 1
+ * respectively for the first call, just like zlib's crc32() and adler32(). */
+extern uint32_t zz_crc32(uint32_t crc, uint8_t const *buf, size_t len);
+extern uint32_t zz_adler32(uint32_t adler, uint8_t const *buf, size_t len);
@@ -0,0 +1,92 @@
+/*
+ *  zzuf - general purpose fuzzer
+ *
+ *  Copyright © 2002—2015 Sam Hocevar <sam@hocevar.net>
+ *
+ *  This program is free software. It comes without any warranty, to
+ *  the extent permitted by applicable law. You can redistribute it
+ *  and/or modify it under the terms of the Do What the Fuck You Want
+ *  to Public License, Version 2, as published by the WTFPL Task Force.
+ *  See http://www.wtfpl.net/ for more details.
+ */
+
+/*
+ *  extents.c: sorted list of disjoint byte ranges with hit counts
+ */
+
+#include "config.h"
+
+#if defined HAVE_STDINT_H
+#   include <stdint.h>
+#elif defined HAVE_INTTYPES_H
+#   include <inttypes.h>
+#endif
+#include <stdlib.h>
+#include <string.h>
+
+#include "util/extents.h"
+
+/*
+ * Add a range to the list. Ranges that overlap or touch the new one are
+ * merged with it and their hit counts are summed. When the list is full
+ * and cannot grow, the new range is merged with its nearest neighbour
+ * instead, so that the list may cover more bytes than were added, but
+ * never fewer.
+ */
+void zz_extents_add(zzuf_extents_t *e, int64_t start, int64_t end,
+                    int64_t hits)
+{
+    int i = 0, j;
+
+    if (start >= end)
+        return;
+
+    /* Find the extents that touch [start, end) */
+    while (i < e->count && e->list[i].end < start)
+        ++i;
+    for (j = i; j < e->count && e->list[j].start <= end; ++j)
+    {
+        if (e->list[j].start < start)
+            start = e->list[j].start;
+        if (e->list[j].end > end)
+            end = e->list[j].end;
+        hits += e->list[j].hits;
+    }
+
+    if (i == j && e->count == e->max)
+    {
+        if (e->grow)
+        {
+            e->max = e->max ? e->max * 2 : 64;
+            e->list = realloc(e->list, e->max * sizeof(zzuf_extent_t));
+        }
+        else
+        {
+            /* Extend whichever neighbour is closest */
+            zzuf_extent_t *n;
+
+            if (i == e->count
+                 || (i > 0 && start - e->list[i - 1].end
+                               < e->list[i].start - end))
+            {
+                n = &e->list[i - 1];
+                n->end = end;
+            }
+            else
+            {
+                n = &e->list[i];
+                n->start = start;
+            }
+            n->hits += hits;
+            return;
+        }
+    }
+
+    /* Replace extents i to j - 1 with the new one */
+    memmove(e->list + i + 1, e->list + j,
+            (e->count - j) * sizeof(zzuf_extent_t));
+    e->count += 1 - (j - i);
+    e->list[i].start = start;
+    e->list[i].end = end;
+    e->list[i].hits = hits;
+}
@@ -0,0 +1,34 @@
+/*
+ *  zzuf - general purpose fuzzer
+ *
+ *  Copyright © 2002—2015 Sam Hocevar <sam@hocevar.net>
+ *
+ *  This program is free software. It comes without any warranty, to
+ *  the extent permitted by applicable law. You can redistribute it
+ *  and/or modify it under the terms of the Do What the Fuck You Want
+ *  to Public License, Version 2, as published by the WTFPL Task Force.
+ *  See http://www.wtfpl.net/ for more details.
+ */
+
+#pragma once
+
+/*
+ *  extents.h: sorted list of disjoint byte ranges with hit counts
+ */
+
+typedef struct zzuf_extent
+{
+    int64_t start, end; /* end is excluded */
+    int64_t hits;
+} zzuf_extent_t;
+
+/* If grow is zero, the list never holds more than max extents and the
+ * caller provides the storage, which libzzuf needs. */
+typedef struct zzuf_extents
+{
+    zzuf_extent_t *list;
+    int count, max, grow;
+} zzuf_extents_t;
+
+extern void zz_extents_add(zzuf_extents_t *, int64_t start, int64_t end,
+                           int64_t hits);
@@ -27,6 +27,9 @@
 #endif
 #include <string.h>
 #include <stdlib.h>
+#if defined __SSE2__
+#   include <emmintrin.h>
+#endif
 
 #include "util/md5.h"
 
@@ -39,6 +42,9 @@ struct zzuf_md5sum
 
 static void swapwords(uint32_t *buf, unsigned words);
 static void transform(uint32_t buf[4], uint32_t in[16]);
+#if defined __SSE2__
+static void transform4(uint32_t *buf[4], uint8_t const *in[4]);
+#endif
 
 zzuf_md5sum_t *zzuf_create_md5(void)
 {
@@ -55,7 +61,7 @@ zzuf_md5sum_t *zzuf_create_md5(void)
     return ctx;
 }
 
-void zz_md5_add(zzuf_md5sum_t *ctx, uint8_t *buf, unsigned len)
+void zz_md5_add(zzuf_md5sum_t *ctx, uint8_t const *buf, unsigned len)
 {
     uint32_t t = ctx->bits[0];
     if ((ctx->bits[0] = t + ((uint32_t)len << 3)) < t)
@@ -93,6 +99,77 @@ void zz_md5_add(zzuf_md5sum_t *ctx, uint8_t *buf, unsigned len)
     memcpy(ctx->in, buf, len);
 }
 
+/*
+ * Add data to several MD5 contexts at once. Where SSE2 is available, the
+ * whole blocks common to all contexts are hashed four at a time, one
+ * context per 32-bit lane, which is almost four times as fast as hashing
+ * them one after the other. Whatever is left is hashed the usual way.
+ */
+void zz_md5_add_multi(zzuf_md5sum_t **ctx, uint8_t const **buf,
+                      unsigned *len, int n)
+{
+#if defined __SSE2__
+    for (int i = 0; i < n; i += 4)
+    {
+        int lanes = n - i < 4 ? n - i : 4;
+        unsigned blocks = ~0u;
+        uint8_t const *p[4];
+        unsigned left[4];
+
+        /* Complete each context's pending partial block first */
+        for (int l = 0; l < lanes; ++l)
+        {
+            zzuf_md5sum_t *c = ctx[i + l];
+            unsigned head = (64 - ((c->bits[0] >> 3) & 0x3f)) & 0x3f;
+            if (head > len[i + l])
+                head = len[i + l];
+            zz_md5_add(c, buf[i + l], head);
+
+            p[l] = buf[i + l] + head;
+            left[l] = len[i + l] - head;
+            if (left[l] / 64 < blocks)
+                blocks = left[l] / 64;
+        }
+
+        if (lanes > 1 && blocks > 0)
+        {
+            /* Unused lanes hash the first context's data into a dummy */
+            uint32_t dummy[4], *state[4];
+            uint8_t const *in[4];
+            for (int l = 0; l < 4; ++l)
+            {
+                state[l] = l < lanes ? ctx[i + l]->buf : dummy;
+                in[l] = p[l < lanes ? l : 0];
+            }
+
+            for (unsigned b = 0; b < blocks; ++b)
+            {
+                transform4(state, in);
+                for (int l = 0; l < 4; ++l)
+                    in[l] += 64;
+            }
+
+            for (int l = 0; l < lanes; ++l)
+            {
+                zzuf_md5sum_t *c = ctx[i + l];
+                uint32_t t = c->bits[0];
+                if ((c->bits[0] = t + (blocks << 9)) < t)
+                    c->bits[1]++;
+                c->bits[1] += blocks >> 23;
+                p[l] += blocks * 64;
+                left[l] -= blocks * 64;
+            }
+        }
+
+        for (int l = 0; l < lanes; ++l)
+            zz_md5_add(ctx[i + l], p[l], left[l]);
+    }
+#else
+    for (int i = 0; i < n; ++i)
+        zz_md5_add(ctx[i], buf[i], len[i]);
+#endif
+}
+
 void zzuf_destroy_md5(uint8_t *digest, zzuf_md5sum_t *ctx)
 {
     unsigned count = (ctx->bits[0] >> 3) & 0x3F;
@@ -148,6 +225,79 @@ static void swapwords(uint32_t *buf, unsigned words)
 #define MD5STEP(f, w, x, y, z, data, s) \
     (w += f(x, y, z) + data, w = w << s | w >> (32 - s), w += x)
 
+/* The 64 MD5 steps, shared by the scalar and the SIMD transforms */
+#define MD5_STEPS(STEP) \
+    STEP(F1, a, b, c, d, 0, 0xd76aa478, 7) \
+    STEP(F1, d, a, b, c, 1, 0xe8c7b756, 12) \
+    STEP(F1, c, d, a, b, 2, 0x242070db, 17) \
+    STEP(F1, b, c, d, a, 3, 0xc1bdceee, 22) \
+    STEP(F1, a, b, c, d, 4, 0xf57c0faf, 7) \
+    STEP(F1, d, a, b, c, 5, 0x4787c62a, 12) \
+    STEP(F1, c, d, a, b, 6, 0xa8304613, 17) \
+    STEP(F1, b, c, d, a, 7, 0xfd469501, 22) \
+    STEP(F1, a, b, c, d, 8, 0x698098d8, 7) \
+    STEP(F1, d, a, b, c, 9, 0x8b44f7af, 12) \
+    STEP(F1, c, d, a, b, 10, 0xffff5bb1, 17) \
+    STEP(F1, b, c, d, a, 11, 0x895cd7be, 22) \
+    STEP(F1, a, b, c, d, 12, 0x6b901122, 7) \
+    STEP(F1, d, a, b, c, 13, 0xfd987193, 12) \
+    STEP(F1, c, d, a, b, 14, 0xa679438e, 17) \
+    STEP(F1, b, c, d, a, 15, 0x49b40821, 22) \
+    \
+    STEP(F2, a, b, c, d, 1, 0xf61e2562, 5) \
+    STEP(F2, d, a, b, c, 6, 0xc040b340, 9) \
+    STEP(F2, c, d, a, b, 11, 0x265e5a51, 14) \
+    STEP(F2, b, c, d, a, 0, 0xe9b6c7aa, 20) \
+    STEP(F2, a, b, c, d, 5, 0xd62f105d, 5) \
+    STEP(F2, d, a, b, c, 10, 0x02441453, 9) \
+    STEP(F2, c, d, a, b, 15, 0xd8a1e681, 14) \
+    STEP(F2, b, c, d, a, 4, 0xe7d3fbc8, 20) \
+    STEP(F2, a, b, c, d, 9, 0x21e1cde6, 5) \
+    STEP(F2, d, a, b, c, 14, 0xc33707d6, 9) \
+    STEP(F2, c, d, a, b, 3, 0xf4d50d87, 14) \
+    STEP(F2, b, c, d, a, 8, 0x455a14ed, 20) \
+    STEP(F2, a, b, c, d, 13, 0xa9e3e905, 5) \
+    STEP(F2, d, a, b, c, 2, 0xfcefa3f8, 9) \
+    STEP(F2, c, d, a, b, 7, 0x676f02d9, 14) \
+    STEP(F2, b, c, d, a, 12, 0x8d2a4c8a, 20) \
+    \
+    STEP(F3, a, b, c, d, 5, 0xfffa3942, 4) \
+    STEP(F3, d, a, b, c, 8, 0x8771f681, 11) \
+    STEP(F3, c, d, a, b, 11, 0x6d9d6122, 16) \
+    STEP(F3, b, c, d, a, 14, 0xfde5380c, 23) \
+    STEP(F3, a, b, c, d, 1, 0xa4beea44, 4) \
+    STEP(F3, d, a, b, c, 4, 0x4bdecfa9, 11) \
+    STEP(F3, c, d, a, b, 7, 0xf6bb4b60, 16) \
+    STEP(F3, b, c, d, a, 10, 0xbebfbc70, 23) \
+    STEP(F3, a, b, c, d, 13, 0x289b7ec6, 4) \
+    STEP(F3, d, a, b, c, 0, 0xeaa127fa, 11) \
+    STEP(F3, c, d, a, b, 3, 0xd4ef3085, 16) \
+    STEP(F3, b, c, d, a, 6, 0x04881d05, 23) \
+    STEP(F3, a, b, c, d, 9, 0xd9d4d039, 4) \
+    STEP(F3, d, a, b, c, 12, 0xe6db99e5, 11) \
+    STEP(F3, c, d, a, b, 15, 0x1fa27cf8, 16) \
+    STEP(F3, b, c, d, a, 2, 0xc4ac5665, 23) \
+    \
+    STEP(F4, a, b, c, d, 0, 0xf4292244, 6) \
+    STEP(F4, d, a, b, c, 7, 0x432aff97, 10) \
+    STEP(F4, c, d, a, b, 14, 0xab9423a7, 15) \
+    STEP(F4, b, c, d, a, 5, 0xfc93a039, 21) \
+    STEP(F4, a, b, c, d, 12, 0x655b59c3, 6) \
+    STEP(F4, d, a, b, c, 3, 0x8f0ccc92, 10) \
+    STEP(F4, c, d, a, b, 10, 0xffeff47d, 15) \
+    STEP(F4, b, c, d, a, 1, 0x85845dd1, 21) \
+    STEP(F4, a, b, c, d, 8, 0x6fa87e4f, 6) \
+    STEP(F4, d, a, b, c, 15, 0xfe2ce6e0, 10) \
+    STEP(F4, c, d, a, b, 6, 0xa3014314, 15) \
+    STEP(F4, b, c, d, a, 13, 0x4e0811a1, 21) \
+    STEP(F4, a, b, c, d, 4, 0xf7537e82, 6) \
+    STEP(F4, d, a, b, c, 11, 0xbd3af235, 10) \
+    STEP(F4, c, d, a, b, 2, 0x2ad7d2bb, 15) \
+    STEP(F4, b, c, d, a, 9, 0xeb86d391, 21)
+
+#define SCALAR_STEP(f, w, x, y, z, k, t, s) \
+    MD5STEP(f, w, x, y, z, in[k] + t, s);
+
 static void transform(uint32_t buf[4], uint32_t in[16])
 {
     uint32_t a = buf[0];
@@ -155,73 +305,7 @@ static void transform(uint32_t buf[4], uint32_t in[16])
     uint32_t c = buf[2];
     uint32_t d = buf[3];
 
-    MD5STEP(F1, a, b, c, d, in[0] + 0xd76aa478, 7);
-    MD5STEP(F1, d, a, b, c, in[1] + 0xe8c7b756, 12);
-    MD5STEP(F1, c, d, a, b, in[2] + 0x242070db, 17);
-    MD5STEP(F1, b, c, d, a, in[3] + 0xc1bdceee, 22);
-    MD5STEP(F1, a, b, c, d, in[4] + 0xf57c0faf, 7);
-    MD5STEP(F1, d, a, b, c, in[5] + 0x4787c62a, 12);
-    MD5STEP(F1, c, d, a, b, in[6] + 0xa8304613, 17);
-    MD5STEP(F1, b, c, d, a, in[7] + 0xfd469501, 22);
-    MD5STEP(F1, a, b, c, d, in[8] + 0x698098d8, 7);
-    MD5STEP(F1, d, a, b, c, in[9] + 0x8b44f7af, 12);
-    MD5STEP(F1, c, d, a, b, in[10] + 0xffff5bb1, 17);
-    MD5STEP(F1, b, c, d, a, in[11] + 0x895cd7be, 22);
-    MD5STEP(F1, a, b, c, d, in[12] + 0x6b901122, 7);
-    MD5STEP(F1, d, a, b, c, in[13] + 0xfd987193, 12);
-    MD5STEP(F1, c, d, a, b, in[14] + 0xa679438e, 17);
-    MD5STEP(F1, b, c, d, a, in[15] + 0x49b40821, 22);
-
-    MD5STEP(F2, a, b, c, d, in[1] + 0xf61e2562, 5);
-    MD5STEP(F2, d, a, b, c, in[6] + 0xc040b340, 9);
-    MD5STEP(F2, c, d, a, b, in[11] + 0x265e5a51, 14);
-    MD5STEP(F2, b, c, d, a, in[0] + 0xe9b6c7aa, 20);
-    MD5STEP(F2, a, b, c, d, in[5] + 0xd62f105d, 5);
-    MD5STEP(F2, d, a, b, c, in[10] + 0x02441453, 9);
-    MD5STEP(F2, c, d, a, b, in[15] + 0xd8a1e681, 14);
-    MD5STEP(F2, b, c, d, a, in[4] + 0xe7d3fbc8, 20);
-    MD5STEP(F2, a, b, c, d, in[9] + 0x21e1cde6, 5);
-    MD5STEP(F2, d, a, b, c, in[14] + 0xc33707d6, 9);
-    MD5STEP(F2, c, d, a, b, in[3] + 0xf4d50d87, 14);
-    MD5STEP(F2, b, c, d, a, in[8] + 0x455a14ed, 20);
-    MD5STEP(F2, a, b, c, d, in[13] + 0xa9e3e905, 5);
-    MD5STEP(F2, d, a, b, c, in[2] + 0xfcefa3f8, 9);
-    MD5STEP(F2, c, d, a, b, in[7] + 0x676f02d9, 14);
-    MD5STEP(F2, b, c, d, a, in[12] + 0x8d2a4c8a, 20);
-
-    MD5STEP(F3, a, b, c, d, in[5] + 0xfffa3942, 4);
-    MD5STEP(F3, d, a, b, c, in[8] + 0x8771f681, 11);
-    MD5STEP(F3, c, d, a, b, in[11] + 0x6d9d6122, 16);
-    MD5STEP(F3, b, c, d, a, in[14] + 0xfde5380c, 23);
-    MD5STEP(F3, a, b, c, d, in[1] + 0xa4beea44, 4);
-    MD5STEP(F3, d, a, b, c, in[4] + 0x4bdecfa9, 11);
-    MD5STEP(F3, c, d, a, b, in[7] + 0xf6bb4b60, 16);
-    MD5STEP(F3, b, c, d, a, in[10] + 0xbebfbc70, 23);
-    MD5STEP(F3, a, b, c, d, in[13] + 0x289b7ec6, 4);
-    MD5STEP(F3, d, a, b, c, in[0] + 0xeaa127fa, 11);
-    MD5STEP(F3, c, d, a, b, in[3] + 0xd4ef3085, 16);
-    MD5STEP(F3, b, c, d, a, in[6] + 0x04881d05, 23);
-    MD5STEP(F3, a, b, c, d, in[9] + 0xd9d4d039, 4);
-    MD5STEP(F3, d, a, b, c, in[12] + 0xe6db99e5, 11);
-    MD5STEP(F3, c, d, a, b, in[15] + 0x1fa27cf8, 16);
-    MD5STEP(F3, b, c, d, a, in[2] + 0xc4ac5665, 23);
-
-    MD5STEP(F4, a, b, c, d, in[0] + 0xf4292244, 6);
-    MD5STEP(F4, d, a, b, c, in[7] + 0x432aff97, 10);
-    MD5STEP(F4, c, d, a, b, in[14] + 0xab9423a7, 15);
-    MD5STEP(F4, b, c, d, a, in[5] + 0xfc93a039, 21);
-    MD5STEP(F4, a, b, c, d, in[12] + 0x655b59c3, 6);
-    MD5STEP(F4, d, a, b, c, in[3] + 0x8f0ccc92, 10);
-    MD5STEP(F4, c, d, a, b, in[10] + 0xffeff47d, 15);
-    MD5STEP(F4, b, c, d, a, in[1] + 0x85845dd1, 21);
-    MD5STEP(F4, a, b, c, d, in[8] + 0x6fa87e4f, 6);
-    MD5STEP(F4, d, a, b, c, in[15] + 0xfe2ce6e0, 10);
-    MD5STEP(F4, c, d, a, b, in[6] + 0xa3014314, 15);
-    MD5STEP(F4, b, c, d, a, in[13] + 0x4e0811a1, 21);
-    MD5STEP(F4, a, b, c, d, in[4] + 0xf7537e82, 6);
-    MD5STEP(F4, d, a, b, c, in[11] + 0xbd3af235, 10);
-    MD5STEP(F4, c, d, a, b, in[2] + 0x2ad7d2bb, 15);
-    MD5STEP(F4, b, c, d, a, in[9] + 0xeb86d391, 21);
+    MD5_STEPS(SCALAR_STEP)
 
     buf[0] += a;
     buf[1] += b;
@@ -229,3 +313,56 @@ static void transform(uint32_t buf[4], uint32_t in[16])
     buf[3] += d;
 }
 
+#if defined __SSE2__
+#define F1_4(x, y, z) \
+    _mm_xor_si128(z, _mm_and_si128(x, _mm_xor_si128(y, z)))
+#define F2_4(x, y, z) F1_4(z, x, y)
+#define F3_4(x, y, z) _mm_xor_si128(x, _mm_xor_si128(y, z))
+#define F4_4(x, y, z) \
+    _mm_xor_si128(y, _mm_or_si128(x, _mm_xor_si128(z, ones)))
+
+#define SIMD_STEP(f, w, x, y, z, k, t, s) \
+    w = _mm_add_epi32(w, _mm_add_epi32(f##_4(x, y, z), \
+            _mm_add_epi32(in[k], _mm_set1_epi32((int)t)))); \
+    w = _mm_or_si128(_mm_slli_epi32(w, s), _mm_srli_epi32(w, 32 - s)); \
+    w = _mm_add_epi32(w, x);
+
+/*
+ * Hash one 64-byte block for each of four contexts. SSE2 only exists on
+ * little endian machines, so the input needs no swapping.
+ */
+static void transform4(uint32_t *buf[4], uint8_t const *data[4])
+{
+    __m128i const ones = _mm_set1_epi32(-1);
+    __m128i in[16];
+    uint32_t w[4][16];
+
+    for (int l = 0; l < 4; ++l)
+        memcpy(w[l], data[l], 64);
+    for (int k = 0; k < 16; ++k)
+        in[k] = _mm_set_epi32((int)w[3][k], (int)w[2][k],
+                              (int)w[1][k], (int)w[0][k]);
+
+    __m128i a = _mm_set_epi32((int)buf[3][0], (int)buf[2][0],
+                              (int)buf[1][0], (int)buf[0][0]);
+    __m128i b = _mm_set_epi32((int)buf[3][1], (int)buf[2][1],
+                              (int)buf[1][1], (int)buf[0][1]);
+    __m128i c = _mm_set_epi32((int)buf[3][2], (int)buf[2][2],
+                              (int)buf[1][2], (int)buf[0][2]);
+    __m128i d = _mm_set_epi32((int)buf[3][3], (int)buf[2][3],
+                              (int)buf[1][3], (int)buf[0][3]);
+    __m128i const a0 = a, b0 = b, c0 = c, d0 = d;
+
+    MD5_STEPS(SIMD_STEP)
+
+    uint32_t out[4][4];
+    _mm_storeu_si128((__m128i *)out[0], _mm_add_epi32(a, a0));
+    _mm_storeu_si128((__m128i *)out[1], _mm_add_epi32(b, b0));
+    _mm_storeu_si128((__m128i *)out[2], _mm_add_epi32(c, c0));
+    _mm_storeu_si128((__m128i *)out[3], _mm_add_epi32(d, d0));
+
+    for (int l = 0; l < 4; ++l)
+        for (int j = 0; j < 4; ++j)
+            buf[l][j] = out[j][l];
+}
+#endif
@@ -19,6 +19,8 @@
 typedef struct zzuf_md5sum zzuf_md5sum_t;
 
 extern zzuf_md5sum_t *zzuf_create_md5(void);
-extern void zz_md5_add(zzuf_md5sum_t *ctx, uint8_t *buf, unsigned len);
+extern void zz_md5_add(zzuf_md5sum_t *ctx, uint8_t const *buf, unsigned len);
+extern void zz_md5_add_multi(zzuf_md5sum_t **ctx, uint8_t const **buf,
+                             unsigned *len, int n);
 extern void zzuf_destroy_md5(uint8_t *digest, zzuf_md5sum_t *ctx);
 
@@ -0,0 +1,157 @@
+/*
+ *  zzuf - general purpose fuzzer
+ *
+ *  Copyright © 2002—2015 Sam Hocevar <sam@hocevar.net>
+ *
+ *  This program is free software. It comes without any warranty, to
+ *  the extent permitted by applicable law. You can redistribute it
+ *  and/or modify it under the terms of the Do What the Fuck You Want
+ *  to Public License, Version 2, as published by the WTFPL Task Force.
+ *  See http://www.wtfpl.net/ for more details.
+ */
+
+/*
+ *  mmh3.c: 128-bit MurmurHash3 computation. This is the x64 variant of
+ *  Austin Appleby's public domain hash, with a zero seed, turned into a
+ *  streaming function. It is not a cryptographic hash, but it is several
+ *  times faster than MD5 and good enough to tell outputs apart.
+ */
+
+#include "config.h"
+
+#if defined HAVE_STDINT_H
+#   include <stdint.h>
+#elif defined HAVE_INTTYPES_H
+#   include <inttypes.h>
+#endif
+#include <string.h>
+#include <stdlib.h>
+
+#include "util/mmh3.h"
+
+#define C1 0x87c37b91114253d5ull
+#define C2 0x4cf5ad432745937full
+
+struct zzuf_mmh3
+{
+    uint64_t h1, h2;
+    uint64_t total;
+    /* Pending bytes, until we have a full 16-byte block */
+    uint8_t tail[16];
+    unsigned ntail;
+};
+
+static inline uint64_t rotl64(uint64_t x, int r)
+{
+    return x << r | x >> (64 - r);
+}
+
+static inline uint64_t get64(uint8_t const *p)
+{
+    return (uint64_t)p[0] | (uint64_t)p[1] << 8 | (uint64_t)p[2] << 16
+         | (uint64_t)p[3] << 24 | (uint64_t)p[4] << 32
+         | (uint64_t)p[5] << 40 | (uint64_t)p[6] << 48
+         | (uint64_t)p[7] << 56;
+}
+
+static inline uint64_t fmix64(uint64_t k)
+{
+    k ^= k >> 33;
+    k *= 0xff51afd7ed558ccdull;
+    k ^= k >> 33;
+    k *= 0xc4ceb9fe1a85ec53ull;
+    k ^= k >> 33;
+    return k;
+}
+
+static void blocks(zzuf_mmh3_t *ctx, uint8_t const *buf, size_t count);
+
+zzuf_mmh3_t *zzuf_create_mmh3(void)
+{
+    zzuf_mmh3_t *ctx = malloc(sizeof(zzuf_mmh3_t));
+
+    ctx->h1 = ctx->h2 = 0;
+    ctx->total = 0;
+    ctx->ntail = 0;
+
+    return ctx;
+}
+
+void zz_mmh3_add(zzuf_mmh3_t *ctx, uint8_t const *buf, size_t len)
+{
+    ctx->total += len;
+
+    if (ctx->ntail)
+    {
+        size_t n = 16 - ctx->ntail;
+        if (len < n)
+        {
+            memcpy(ctx->tail + ctx->ntail, buf, len);
+            ctx->ntail += (unsigned)len;
+            return;
+        }
+        memcpy(ctx->tail + ctx->ntail, buf, n);
+        blocks(ctx, ctx->tail, 1);
+        buf += n;
+        len -= n;
+    }
+
+    blocks(ctx, buf, len / 16);
+    ctx->ntail = (unsigned)(len % 16);
+    memcpy(ctx->tail, buf + len - ctx->ntail, ctx->ntail);
+}
+
+void zzuf_destroy_mmh3(uint8_t *digest, zzuf_mmh3_t *ctx)
+{
+    uint64_t h1 = ctx->h1, h2 = ctx->h2, k1 = 0, k2 = 0;
+
+    for (unsigned i = ctx->ntail; i-- > 8; )
+        k2 = k2 << 8 | ctx->tail[i];
+    for (unsigned i = ctx->ntail < 8 ? ctx->ntail : 8; i-- > 0; )
+        k1 = k1 << 8 | ctx->tail[i];
+
+    if (ctx->ntail > 8)
+    {
+        k2 *= C2; k2 = rotl64(k2, 33); k2 *= C1; h2 ^= k2;
+    }
+    if (ctx->ntail > 0)
+    {
+        k1 *= C1; k1 = rotl64(k1, 31); k1 *= C2; h1 ^= k1;
+    }
+
+    h1 ^= ctx->total;
+    h2 ^= ctx->total;
+    h1 += h2;
+    h2 += h1;
+    h1 = fmix64(h1);
+    h2 = fmix64(h2);
+    h1 += h2;
+    h2 += h1;
+
+    for (int i = 0; i < 8; ++i)
+    {
+        digest[i] = (uint8_t)(h1 >> (8 * i));
+        digest[i + 8] = (uint8_t)(h2 >> (8 * i));
+    }
+
+    free(ctx);
+}
+
+static void blocks(zzuf_mmh3_t *ctx, uint8_t const *buf, size_t count)
+{
+    uint64_t h1 = ctx->h1, h2 = ctx->h2;
+
+    for ( ; count--; buf += 16)
+    {
+        uint64_t k1 = get64(buf), k2 = get64(buf + 8);
+
+        k1 *= C1; k1 = rotl64(k1, 31); k1 *= C2; h1 ^= k1;
+        h1 = rotl64(h1, 27); h1 += h2; h1 = h1 * 5 + 0x52dce729;
+
+        k2 *= C2; k2 = rotl64(k2, 33); k2 *= C1; h2 ^= k2;
+        h2 = rotl64(h2, 31); h2 += h1; h2 = h2 * 5 + 0x38495ab5;
+    }
+
+    ctx->h1 = h1;
+    ctx->h2 = h2;
+}
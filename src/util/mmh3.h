@@ -0,0 +1,23 @@
+/*
+ *  zzuf - general purpose fuzzer
+ *
+ *  Copyright © 2002—2015 Sam Hocevar <sam@hocevar.net>
+ *
+ *  This program is free software. It comes without any warranty, to
+ *  the extent permitted by applicable law. You can redistribute it
+ *  and/or modify it under the terms of the Do What the Fuck You Want
+ *  to Public License, Version 2, as published by the WTFPL Task Force.
+ *  See http://www.wtfpl.net/ for more details.
+ */
+
+#pragma once
+
+/*
+ *  mmh3.h: 128-bit MurmurHash3 computation
+ */
+
+typedef struct zzuf_mmh3 zzuf_mmh3_t;
+
+extern zzuf_mmh3_t *zzuf_create_mmh3(void);
+extern void zz_mmh3_add(zzuf_mmh3_t *ctx, uint8_t const *buf, size_t len);
+extern void zzuf_destroy_mmh3(uint8_t *digest, zzuf_mmh3_t *ctx);
@@ -0,0 +1,99 @@
+/*
+ *  zzuf - general purpose fuzzer
+ *
+ *  Copyright © 2002—2015 Sam Hocevar <sam@hocevar.net>
+ *
+ *  This program is free software. It comes without any warranty, to
+ *  the extent permitted by applicable law. You can redistribute it
+ *  and/or modify it under the terms of the Do What the Fuck You Want
+ *  to Public License, Version 2, as published by the WTFPL Task Force.
+ *  See http://www.wtfpl.net/ for more details.
+ */
+
+/*
+ *  ring.c: bounded buffer keeping the last bytes of a stream
+ */
+
+#include "config.h"
+
+#if defined HAVE_STDINT_H
+#   include <stdint.h>
+#elif defined HAVE_INTTYPES_H
+#   include <inttypes.h>
+#endif
+#include <string.h>
+#include <stdlib.h>
+#include <stdio.h>
+
+#include "util/ring.h"
+
+struct zzuf_ring
+{
+    uint8_t *data;
+    /* Buffer size and where the next byte goes */
+    size_t size, pos;
+    /* Number of bytes seen so far */
+    int64_t count;
+};
+
+zzuf_ring_t *zzuf_create_ring(size_t size)
+{
+    zzuf_ring_t *ctx = malloc(sizeof(zzuf_ring_t));
+
+    ctx->data = malloc(size);
+    ctx->size = size;
+    zz_ring_reset(ctx);
+
+    return ctx;
+}
+
+void zz_ring_reset(zzuf_ring_t *ctx)
+{
+    ctx->pos = 0;
+    ctx->count = 0;
+}
+
+void zz_ring_add(zzuf_ring_t *ctx, uint8_t const *buf, size_t len)
+{
+    ctx->count += len;
+
+    /* Only the end of large buffers matters */
+    if (len >= ctx->size)
+    {
+        memcpy(ctx->data, buf + len - ctx->size, ctx->size);
+        ctx->pos = 0;
+        return;
+    }
+
+    size_t first = ctx->size - ctx->pos < len ? ctx->size - ctx->pos : len;
+    memcpy(ctx->data + ctx->pos, buf, first);
+    memcpy(ctx->data, buf + first, len - first);
+    ctx->pos = (ctx->pos + len) % ctx->size;
+}
+
+int64_t zz_ring_count(zzuf_ring_t *ctx)
+{
+    return ctx->count;
+}
+
+/*
+ * Write the buffer contents, oldest bytes first, to the given file.
+ */
+int zz_ring_save(zzuf_ring_t *ctx, char const *path)
+{
+    FILE *fp = fopen(path, "wb");
+    if (!fp)
+        return -1;
+
+    if (ctx->count > (int64_t)ctx->size)
+        fwrite(ctx->data + ctx->pos, 1, ctx->size - ctx->pos, fp);
+    fwrite(ctx->data, 1, ctx->pos, fp);
+
+    return fclose(fp) ? -1 : 0;
+}
+
+void zzuf_destroy_ring(zzuf_ring_t *ctx)
+{
+    free(ctx->data);
+    free(ctx);
+}
@@ -0,0 +1,26 @@
+/*
+ *  zzuf - general purpose fuzzer
+ *
+ *  Copyright © 2002—2015 Sam Hocevar <sam@hocevar.net>
+ *
+ *  This program is free software. It comes without any warranty, to
+ *  the extent permitted by applicable law. You can redistribute it
+ *  and/or modify it under the terms of the Do What the Fuck You Want
+ *  to Public License, Version 2, as published by the WTFPL Task Force.
+ *  See http://www.wtfpl.net/ for more details.
+ */
+
+#pragma once
+
+/*
+ *  ring.h: bounded buffer keeping the last bytes of a stream
+ */
+
+typedef struct zzuf_ring zzuf_ring_t;
+
+extern zzuf_ring_t *zzuf_create_ring(size_t size);
+extern void zz_ring_reset(zzuf_ring_t *ctx);
+extern void zz_ring_add(zzuf_ring_t *ctx, uint8_t const *buf, size_t len);
+extern int64_t zz_ring_count(zzuf_ring_t *ctx);
+extern int zz_ring_save(zzuf_ring_t *ctx, char const *path);
+extern void zzuf_destroy_ring(zzuf_ring_t *ctx);
@@ -59,17 +59,28 @@
 #if defined HAVE_SYS_RESOURCE_H
 #   include <sys/resource.h> /* for RLIMIT_AS */
 #endif
+#include <sys/stat.h> /* for mkdir() */
+#if defined _WIN32
+#   include <direct.h>
+#   define mkdir(path, mode) _mkdir(path)
+#endif
 
 #include "common.h"
 #include "opts.h"
 #include "random.h"
 #include "fd.h"
 #include "fuzz.h"
+#include "fixup.h"
+#include "resize.h"
 #include "myfork.h"
+#include "loop.h"
+#include "jobs.h"
+#include "affinity.h"
+#include "cgroup.h"
 #include "timer.h"
 #include "util/getopt.h"
-#include "util/md5.h"
 #include "util/hex.h"
+#include "util/ring.h"
 
 #if !defined SIGKILL
 #   define SIGKILL 9
@@ -92,17 +103,26 @@
 #endif
 
 static void loop_stdin(zzuf_opts_t *);
+static void output_stdin(zzuf_opts_t *, zzuf_digest_t *, zzuf_hexdump_t *,
+                         uint8_t *, int);
 
 static void spawn_children(zzuf_opts_t *);
+static int skip_duplicates(zzuf_opts_t *);
+static int spawn_child(zzuf_opts_t *, int, int64_t);
 static void clean_children(zzuf_opts_t *);
+#if defined HAVE_KILL || defined HAVE_WINDOWS_H
+static void kill_child(zzuf_opts_t *, int, int64_t, char const *);
+#endif
 static void read_children(zzuf_opts_t *);
 
 #if !defined HAVE_SETENV
 static void setenv(char const *, char const *, int);
 #endif
 #if defined HAVE_WAITPID
+static void report_crash(zzuf_opts_t *, int, char const *);
 static char const *sig2name(int);
 #endif
+static void check_novelty(zzuf_opts_t *, int, char const *, uint8_t const *);
 static void finfo(FILE *, zzuf_opts_t *, uint32_t);
 #if defined HAVE_REGEX_H
 static char *merge_regex(char *, char *);
@@ -111,19 +131,21 @@ static char *merge_file(char *, char *);
 static void version(void);
 static void usage(void);
 
-#define ZZUF_FD_SET(fd, p_fdset, maxfd) \
-    if (fd >= 0) \
-    { \
-        FD_SET((unsigned int)fd, p_fdset); \
-        if (fd > maxfd) \
-            maxfd = fd; \
-    }
-
-#define ZZUF_FD_ISSET(fd, p_fdset) \
-    ((fd >= 0) && (FD_ISSET(fd, p_fdset)))
-
 #if defined _WIN32
 static zzuf_mutex_t pipe_mutex = 0;
+#else
+static int64_t next_timeout(zzuf_opts_t *);
+static void read_debug(zzuf_opts_t *, int, uint8_t const *, int, int);
+static int get_crash(zzuf_child_t *, uint8_t *, int);
+static int get_flips(zzuf_child_t *, uint8_t *, int);
+static int get_reads(zzuf_profile_t *, uint8_t *, int);
+static void unwatch_child(zzuf_opts_t *, int);
+#endif
+
+#if defined HAVE_SIGACTION
+/* Signal that interrupted the main loop, see catch_signal() */
+static volatile sig_atomic_t interrupted = 0;
+static void catch_signal(int);
 #endif
 
 int main(int argc, char *argv[])
@@ -133,7 +155,8 @@ int main(int argc, char *argv[])
     char *include = NULL, *exclude = NULL;
     int b_cmdline = 0;
 #endif
-    int debug = 0, b_network = 0;
+    int debug = 0, b_network = 0, b_autojobs = 0;
+    int b_stdin = 0, b_autoinc = 0, b_dedup = 0, b_inflate = 0;
 
     zzuf_opts_t *opts = zzuf_create_opts();
 
@@ -155,8 +178,20 @@ int main(int argc, char *argv[])
 #   define OPTSTR_RLIMIT_CPU ""
 #endif
 #define OPTSTR "+" OPTSTR_REGEX OPTSTR_RLIMIT_MEM OPTSTR_RLIMIT_CPU \
-                "a:Ab:B:C:dD:e:f:F:ij:l:mnO:p:P:qr:R:s:St:U:vxXhV"
+                "a:Ab:B:C:dD:e:f:F:gij:kKL:l:mno:O:p:P:qr:R:s:St:U:vw:xXhV"
 #define MOREINFO "Try `%s --help' for more information.\n"
+/* Options that only have a long form */
+#define OPT_OUTPUT_SIZE 256
+#define OPT_HASH 257
+#define OPT_NOVELTY 258
+#define OPT_SKIP_DUPLICATES 259
+#define OPT_SKIP_UNFUZZED 260
+#define OPT_PROFILE_READS 261
+#define OPT_FIX_CHECKSUMS 262
+#define OPT_INFLATE 263
+#define OPT_INSERT_DELETE 264
+#define OPT_MUTATOR 265
+#define OPT_CGROUP_CPU 266
         int option_index = 0;
         static zzuf_option_t long_options[] =
         {
@@ -175,18 +210,32 @@ int main(int argc, char *argv[])
             { "exclude",      1, NULL, 'E' },
 #endif
             { "fuzzing",      1, NULL, 'f' },
+            { "fix-checksums", 1, NULL, OPT_FIX_CHECKSUMS },
+            { "mutator",      1, NULL, OPT_MUTATOR },
+            { "cgroup",       0, NULL, 'g' },
+            { "cgroup-cpu",   1, NULL, OPT_CGROUP_CPU },
             { "stdin",        0, NULL, 'i' },
 #if defined HAVE_REGEX_H
             { "include",      1, NULL, 'I' },
 #endif
+            { "inflate",      0, NULL, OPT_INFLATE },
+            { "insert-delete", 1, NULL, OPT_INSERT_DELETE },
             { "jobs",         1, NULL, 'j' },
+            { "pin",          0, NULL, 'k' },
+            { "crash-info",   0, NULL, 'K' },
+            { "cpu-list",     1, NULL, 'L' },
             { "list",         1, NULL, 'l' },
             { "md5",          0, NULL, 'm' },
+            { "hash",         1, NULL, OPT_HASH },
 #if defined HAVE_SETRLIMIT && defined ZZUF_RLIMIT_MEM
             { "max-memory",   1, NULL, 'M' },
 #endif
             { "network",      0, NULL, 'n' },
+            { "novelty",      1, NULL, OPT_NOVELTY },
+            { "output",       1, NULL, 'o' },
+            { "output-size",  1, NULL, OPT_OUTPUT_SIZE },
             { "opmode",       1, NULL, 'O' },
+            { "profile-reads", 1, NULL, OPT_PROFILE_READS },
             { "ports",        1, NULL, 'p' },
             { "protect",      1, NULL, 'P' },
             { "quiet",        0, NULL, 'q' },
@@ -194,12 +243,15 @@ int main(int argc, char *argv[])
             { "refuse",       1, NULL, 'R' },
             { "seed",         1, NULL, 's' },
             { "signal",       0, NULL, 'S' },
+            { "skip-duplicates", 0, NULL, OPT_SKIP_DUPLICATES },
+            { "skip-unfuzzed", 0, NULL, OPT_SKIP_UNFUZZED },
             { "max-time",     1, NULL, 't' },
 #if defined HAVE_SETRLIMIT && defined ZZUF_RLIMIT_CPU
             { "max-cputime",  1, NULL, 'T' },
 #endif
             { "max-usertime", 1, NULL, 'U' },
             { "verbose",      0, NULL, 'v' },
+            { "watch",        1, NULL, 'w' },
             { "check-exit",   0, NULL, 'x' },
             { "hex",          0, NULL, 'X' },
             { "help",         0, NULL, 'h' },
@@ -218,9 +270,26 @@ int main(int argc, char *argv[])
             break;
         case 'A': /* --autoinc */
             setenv("ZZUF_AUTOINC", "1", 1);
+            b_autoinc = 1;
             break;
         case 'b': /* --bytes */
-            opts->bytes = zz_optarg;
+            if (zz_optarg[0] == '=')
+                zz_optarg++;
+            if (!strncmp(zz_optarg, "auto:", 5))
+            {
+                free(opts->autobytes);
+                opts->autobytes = zz_profile_ranges(zz_optarg + 5);
+                if (!opts->autobytes)
+                {
+                    fprintf(stderr, "%s: no reads found in profile `%s'\n",
+                            argv[0], zz_optarg + 5);
+                    zzuf_destroy_opts(opts);
+                    return EXIT_FAILURE;
+                }
+                opts->bytes = opts->autobytes;
+            }
+            else
+                opts->bytes = zz_optarg;
             break;
         case 'B': /* --max-bytes */
             if (zz_optarg[0] == '=')
@@ -245,7 +314,11 @@ int main(int argc, char *argv[])
         case 'D': /* --delay */
             if (zz_optarg[0] == '=')
                 zz_optarg++;
+            tmp = strchr(zz_optarg, ':');
             opts->delay = (int64_t)(atof(zz_optarg) * 1000000.0);
+            opts->burst = tmp ? atoi(tmp + 1) : 1;
+            if (opts->burst <= 0)
+                opts->burst = 1;
             break;
 #if defined HAVE_REGEX_H
         case 'E': /* --exclude */
@@ -268,6 +341,24 @@ int main(int argc, char *argv[])
             return EXIT_FAILURE;
         case 'i': /* --stdin */
             setenv("ZZUF_STDIN", "1", 1);
+            b_stdin = 1;
+            break;
+        case OPT_INFLATE: /* --inflate */
+            setenv("ZZUF_INFLATE", "1", 1);
+            b_inflate = 1;
+            break;
+        case OPT_INSERT_DELETE: /* --insert-delete */
+            if (zz_optarg[0] == '=')
+                zz_optarg++;
+            if (atof(zz_optarg) <= 0.0 || atof(zz_optarg) > 1.0)
+            {
+                fprintf(stderr, "%s: invalid insert/delete ratio -- `%s'\n",
+                        argv[0], zz_optarg);
+                printf(MOREINFO, argv[0]);
+                zzuf_destroy_opts(opts);
+                return EXIT_FAILURE;
+            }
+            opts->insertdelete = zz_optarg;
             break;
 #if defined HAVE_REGEX_H
         case 'I': /* --include */
@@ -284,7 +375,70 @@ int main(int argc, char *argv[])
         case 'j': /* --jobs */
             if (zz_optarg[0] == '=')
                 zz_optarg++;
-            opts->maxchild = atoi(zz_optarg) > 1 ? atoi(zz_optarg) : 1;
+            if (!strncmp(zz_optarg, "auto", 4))
+            {
+                /* Let zzuf_create_jobs() pick a default maximum */
+                tmp = strchr(zz_optarg, ':');
+                opts->maxchild = tmp ? atoi(tmp + 1) > 1 ? atoi(tmp + 1) : 1
+                                     : 0;
+                b_autojobs = 1;
+            }
+            else
+            {
+                opts->maxchild = atoi(zz_optarg) > 1 ? atoi(zz_optarg) : 1;
+                b_autojobs = 0;
+            }
+            break;
+        case OPT_FIX_CHECKSUMS: /* --fix-checksums */
+            if (_zz_checksums(zz_optarg) < 0)
+            {
+                fprintf(stderr, "%s: invalid checksum list -- `%s'\n",
+                        argv[0], zz_optarg);
+                zzuf_destroy_opts(opts);
+                return EXIT_FAILURE;
+            }
+            opts->checksums = zz_optarg;
+            break;
+        case OPT_MUTATOR: /* --mutator */
+            if (zz_optarg[0] == '=')
+                zz_optarg++;
+            /* Also needed here for stdin mode and for copy opmode */
+            if (_zz_mutator(zz_optarg) < 0)
+            {
+                fprintf(stderr, "%s: cannot load mutator `%s'\n",
+                        argv[0], zz_optarg);
+                printf(MOREINFO, argv[0]);
+                zzuf_destroy_opts(opts);
+                return EXIT_FAILURE;
+            }
+            opts->mutator = zz_optarg;
+            break;
+        case 'g': /* --cgroup */
+            opts->b_cgroup = 1;
+            break;
+        case OPT_CGROUP_CPU: /* --cgroup-cpu */
+            if (zz_optarg[0] == '=')
+                zz_optarg++;
+            opts->cgroupcpu = atof(zz_optarg);
+            if (opts->cgroupcpu <= 0.0)
+            {
+                fprintf(stderr, "%s: invalid CPU count -- `%s'\n",
+                        argv[0], zz_optarg);
+                printf(MOREINFO, argv[0]);
+                zzuf_destroy_opts(opts);
+                return EXIT_FAILURE;
+            }
+            break;
+        case 'k': /* --pin */
+            opts->b_pin = 1;
+            break;
+        case 'K': /* --crash-info */
+            setenv("ZZUF_CRASHINFO", "1", 1);
+            opts->b_crashinfo = 1;
+            break;
+        case 'L': /* --cpu-list */
+            opts->cpulist = zz_optarg;
+            opts->b_pin = 1;
             break;
         case 'l': /* --list */
             opts->list = zz_optarg;
@@ -292,6 +446,23 @@ int main(int argc, char *argv[])
         case 'm': /* --md5 */
             opts->b_md5 = 1;
             break;
+        case OPT_HASH: /* --hash */
+            if (zz_optarg[0] == '=')
+                zz_optarg++;
+            if (!strcmp(zz_optarg, "md5"))
+                opts->hash = ZZUF_HASH_MD5;
+            else if (!strcmp(zz_optarg, "mmh3"))
+                opts->hash = ZZUF_HASH_MMH3;
+            else
+            {
+                fprintf(stderr, "%s: invalid hash -- `%s'\n",
+                        argv[0], zz_optarg);
+                printf(MOREINFO, argv[0]);
+                zzuf_destroy_opts(opts);
+                return EXIT_FAILURE;
+            }
+            opts->b_md5 = 1;
+            break;
 #if defined HAVE_SETRLIMIT && defined ZZUF_RLIMIT_MEM
         case 'M': /* --max-memory */
             if (zz_optarg[0] == '=')
@@ -303,6 +474,15 @@ int main(int argc, char *argv[])
             setenv("ZZUF_NETWORK", "1", 1);
             b_network = 1;
             break;
+        case OPT_NOVELTY: /* --novelty */
+            opts->noveltyfile = zz_optarg;
+            break;
+        case 'o': /* --output */
+            opts->outdir = zz_optarg;
+            break;
+        case OPT_OUTPUT_SIZE: /* --output-size */
+            opts->outsize = atoi(zz_optarg) > 1 ? atoi(zz_optarg) : 1;
+            break;
         case 'O': /* --opmode */
             if (zz_optarg[0] == '=')
                 zz_optarg++;
@@ -323,6 +503,10 @@ int main(int argc, char *argv[])
         case 'p': /* --ports */
             opts->ports = zz_optarg;
             break;
+        case OPT_PROFILE_READS: /* --profile-reads */
+            setenv("ZZUF_PROFILE", "1", 1);
+            opts->profilefile = zz_optarg;
+            break;
         case 'P': /* --protect */
             opts->protect = zz_optarg;
             break;
@@ -351,6 +535,13 @@ int main(int argc, char *argv[])
         case 'S': /* --signal */
             setenv("ZZUF_SIGNAL", "1", 1);
             break;
+        case OPT_SKIP_DUPLICATES: /* --skip-duplicates */
+            b_dedup = 1;
+            break;
+        case OPT_SKIP_UNFUZZED: /* --skip-unfuzzed */
+            setenv("ZZUF_FLIPS", "1", 1);
+            opts->b_skipunfuzzed = 1;
+            break;
         case 't': /* --max-time */
             if (zz_optarg[0] == '=')
                 zz_optarg++;
@@ -368,6 +559,11 @@ int main(int argc, char *argv[])
                 zz_optarg++;
             opts->maxusertime = (int64_t)(atof(zz_optarg) * 1000000.0);
             break;
+        case 'w': /* --watch */
+            opts->watch = realloc(opts->watch,
+                                  (opts->nwatch + 1) * sizeof(char *));
+            opts->watch[opts->nwatch++] = zz_optarg;
+            break;
         case 'x': /* --check-exit */
             opts->b_checkexit = 1;
             break;
@@ -411,6 +607,14 @@ int main(int argc, char *argv[])
         return EXIT_FAILURE;
     }
 
+    if (opts->cgroupcpu > 0.0 && !opts->b_cgroup)
+    {
+        fprintf(stderr, "%s: --cgroup-cpu requires cgroups (-g)\n", argv[0]);
+        printf(MOREINFO, argv[0]);
+        zzuf_destroy_opts(opts);
+        return EXIT_FAILURE;
+    }
+
     if (opts->allow && !b_network)
     {
         fprintf(stderr, "%s: allow option (-a) requires network fuzzing (-n)\n",
@@ -420,11 +624,28 @@ int main(int argc, char *argv[])
         return EXIT_FAILURE;
     }
 
+    /* Checksums are fixed at physical offsets, which no longer hold the
+     * same bytes once some were inserted or deleted */
+    if (opts->insertdelete && opts->checksums)
+    {
+        fprintf(stderr, "%s: --insert-delete is incompatible with "
+                        "--fix-checksums\n", argv[0]);
+        printf(MOREINFO, argv[0]);
+        zzuf_destroy_opts(opts);
+        return EXIT_FAILURE;
+    }
+
     zzuf_set_ratio(opts->minratio, opts->maxratio);
     zzuf_set_seed(opts->seed);
 
-    if (opts->fuzzing)
-        _zz_fuzzing(opts->fuzzing);
+    if (opts->fuzzing && _zz_fuzzing(opts->fuzzing) < 0)
+    {
+        fprintf(stderr, "%s: cannot load dictionary `%s'\n", argv[0],
+                opts->fuzzing + 5);
+        printf(MOREINFO, argv[0]);
+        zzuf_destroy_opts(opts);
+        return EXIT_FAILURE;
+    }
     if (opts->bytes)
         _zz_bytes(opts->bytes);
     if (opts->list)
@@ -433,6 +654,8 @@ int main(int argc, char *argv[])
         zzuf_protect_range(opts->protect);
     if (opts->refuse)
         zzuf_refuse_range(opts->refuse);
+    if (opts->insertdelete)
+        _zz_set_resize(atof(opts->insertdelete));
 
     /* Needed for stdin mode and for copy opmode. */
     _zz_fd_init();
@@ -464,6 +687,78 @@ int main(int argc, char *argv[])
      */
     else
     {
+        /* Only libzzuf can tell us what was read and fuzzed */
+        if (opts->opmode != OPMODE_PRELOAD
+             && (opts->b_skipunfuzzed || opts->profilefile || b_inflate))
+        {
+            fprintf(stderr, "%s: %s requires preload opmode\n", argv[0],
+                    opts->b_skipunfuzzed ? "--skip-unfuzzed"
+                    : opts->profilefile ? "--profile-reads" : "--inflate");
+            printf(MOREINFO, argv[0]);
+            zzuf_destroy_opts(opts);
+            return EXIT_FAILURE;
+        }
+
+        if (opts->profilefile)
+        {
+            opts->profile = zzuf_create_profile(opts->profilefile);
+            if (!opts->profile)
+            {
+                zzuf_destroy_opts(opts);
+                return EXIT_FAILURE;
+            }
+        }
+
+        /* To skip duplicate inputs, we need to know every fuzzed input */
+        if (b_dedup)
+        {
+            char const *reason = NULL;
+#if defined HAVE_REGEX_H
+            int b_known = opts->opmode == OPMODE_COPY
+                           || (b_cmdline && !include);
+#else
+            int b_known = opts->opmode == OPMODE_COPY;
+#endif
+
+            if (!b_known)
+                reason = "requires -c or copy opmode";
+            else if (b_network)
+                reason = "is incompatible with network fuzzing (-n)";
+            else if (b_stdin)
+                reason = "is incompatible with -i";
+            else if (b_autoinc)
+                reason = "is incompatible with -A";
+            else if (opts->list)
+                reason = "is incompatible with -l";
+            else if (opts->insertdelete)
+                reason = "is incompatible with --insert-delete";
+            else if (opts->mutator)
+                reason = "is incompatible with --mutator";
+            else if (!_zz_fuzzing_bytewise())
+                reason = "only works with bit and byte fuzzing modes";
+            else
+            {
+                int dashdash = opts->opmode == OPMODE_COPY;
+
+                opts->dedup = zzuf_create_dedup();
+                for (int i = zz_optind + 1; i < argc; ++i)
+                {
+                    if (!dashdash && !strcmp("--", argv[i]))
+                        dashdash = 1;
+                    else if (dashdash || argv[i][0] != '-')
+                        zz_dedup_add_file(opts->dedup, argv[i]);
+                }
+            }
+
+            if (reason)
+            {
+                fprintf(stderr, "%s: --skip-duplicates %s\n", argv[0], reason);
+                printf(MOREINFO, argv[0]);
+                zzuf_destroy_opts(opts);
+                return EXIT_FAILURE;
+            }
+        }
+
 #if defined HAVE_REGEX_H
         if (b_cmdline)
         {
@@ -504,6 +799,12 @@ int main(int argc, char *argv[])
             setenv("ZZUF_PROTECT", opts->protect, 1);
         if (opts->refuse)
             setenv("ZZUF_REFUSE", opts->refuse, 1);
+        if (opts->checksums)
+            setenv("ZZUF_CHECKSUMS", opts->checksums, 1);
+        if (opts->insertdelete)
+            setenv("ZZUF_INSERT_DELETE", opts->insertdelete, 1);
+        if (opts->mutator)
+            setenv("ZZUF_MUTATOR", opts->mutator, 1);
 #if defined HAVE_SETRLIMIT && defined ZZUF_RLIMIT_MEM
         if (opts->maxmem >= 0)
         {
@@ -513,14 +814,118 @@ int main(int argc, char *argv[])
         }
 #endif
 
+        /* Make sure we can save children output */
+        if (opts->outdir && mkdir(opts->outdir, 0755) < 0 && errno != EEXIST)
+        {
+            fprintf(stderr, "%s: cannot create directory `%s': %s\n",
+                    argv[0], opts->outdir, strerror(errno));
+            zzuf_destroy_opts(opts);
+            return EXIT_FAILURE;
+        }
+
+        /* Find out where children may run */
+        int *cpus = NULL, *nodes = NULL;
+        if (opts->b_pin)
+        {
+            opts->ncpus = zz_affinity_init(opts->cpulist, &cpus, &nodes);
+            if (opts->ncpus <= 0)
+            {
+                fprintf(stderr, "%s: no usable CPU in list -- `%s'\n",
+                        argv[0], opts->cpulist ? opts->cpulist : "all");
+                free(cpus);
+                free(nodes);
+                zzuf_destroy_opts(opts);
+                return EXIT_FAILURE;
+            }
+        }
+
+        /* Decide how many children we may run */
+        if (b_autojobs)
+            opts->autojobs = zzuf_create_jobs(opts);
+        else
+            opts->jobs = opts->maxchild;
+
         /* Allocate memory for children handling */
         opts->child = malloc(opts->maxchild * sizeof(zzuf_child_t));
         for (int i = 0; i < opts->maxchild; ++i)
         {
             opts->child[i].status = STATUS_FREE;
+            opts->child[i].pidfd = -1;
+            opts->child[i].cpu = opts->ncpus ? cpus[i % opts->ncpus] : -1;
+            opts->child[i].node = opts->ncpus ? nodes[i % opts->ncpus] : -1;
+            opts->child[i].newargv = NULL;
+            opts->child[i].crash = NULL;
+            opts->child[i].report = NULL;
+            opts->child[i].debug = NULL;
+            opts->child[i].debuglen = 0;
+            for (int j = 0; j < 2; ++j)
+                opts->child[i].ring[j] = opts->outdir
+                    ? zzuf_create_ring((size_t)opts->outsize * 1024) : NULL;
             memset(opts->child[i].fd, -1, sizeof(opts->child->fd));
         }
         opts->nchild = 0;
+        opts->buckets = zzuf_create_crashes();
+        opts->scan = zzuf_create_scan(opts->watch, opts->nwatch);
+        if (opts->b_md5 || opts->noveltyfile)
+            opts->digest = zzuf_create_digest(opts->hash, opts->maxchild);
+        if (opts->noveltyfile)
+        {
+            opts->novelty = zzuf_create_novelty(opts->noveltyfile);
+            if (!opts->novelty)
+            {
+                zzuf_destroy_opts(opts);
+                return EXIT_FAILURE;
+            }
+        }
+        free(cpus);
+        free(nodes);
+
+#if !defined _WIN32
+        opts->loop = zzuf_create_loop();
+        if (!opts->loop)
+        {
+            perror("zzuf");
+            zzuf_destroy_opts(opts);
+            return EXIT_FAILURE;
+        }
+#endif
+
+        /* Give each slot its own cgroup, if requested */
+        if (opts->b_cgroup)
+        {
+            opts->cgroup = zzuf_create_cgroup(opts->maxchild, opts->maxmem,
+                                              opts->cgroupcpu);
+            if (!opts->cgroup)
+            {
+                zzuf_destroy_opts(opts);
+                return EXIT_FAILURE;
+            }
+
+#if defined HAVE_SIGACTION
+            /* Our cgroups outlive us unless we remove them ourselves */
+            struct sigaction sa;
+            memset(&sa, 0, sizeof(sa));
+            sa.sa_handler = catch_signal;
+            sigemptyset(&sa.sa_mask);
+            sigaction(SIGINT, &sa, NULL);
+            sigaction(SIGTERM, &sa, NULL);
+#endif
+        }
+
+#if defined HAVE_SETRLIMIT && defined RLIMIT_NOFILE
+        /* Each child uses three pipes and a pidfd: make sure we are
+         * allowed to have that many file descriptors open at once. */
+        struct rlimit rlim;
+        rlim_t needed = (rlim_t)opts->maxchild * 4 + 64;
+        if (getrlimit(RLIMIT_NOFILE, &rlim) == 0
+             && rlim.rlim_cur != RLIM_INFINITY && rlim.rlim_cur < needed)
+        {
+            rlim.rlim_cur = (rlim.rlim_max != RLIM_INFINITY
+                              && rlim.rlim_max < needed) ? rlim.rlim_max
+                                                         : needed;
+            setrlimit(RLIMIT_NOFILE, &rlim);
+        }
+#endif
 
         /* Create new argv */
         opts->oldargc = argc;
@@ -537,12 +942,21 @@ int main(int argc, char *argv[])
         /* Main loop */
         while (opts->nchild || opts->seed < opts->endseed)
         {
-            /* Spawn new children, if necessary */
-            spawn_children(opts);
+#if defined HAVE_SIGACTION
+            if (interrupted)
+                break;
+#endif
 
             /* Cleanup dead or dying children */
             clean_children(opts);
 
+            /* Adjust the number of jobs if requested */
+            if (opts->autojobs)
+                zz_jobs_update(opts->autojobs, opts, zzuf_time());
+
+            /* Spawn new children in the slots that were just freed */
+            spawn_children(opts);
+
             /* Read data from children */
             read_children(opts);
 
@@ -566,31 +980,73 @@ int main(int argc, char *argv[])
         }
     }
 
+    if (opts->buckets && (opts->b_verbose || opts->crashes > 1))
+        zz_crashes_summary(opts->buckets, stderr);
+    if (opts->novelty)
+        zz_novelty_summary(opts->novelty, stderr);
+    if (opts->dedup)
+        zz_dedup_summary(opts->dedup, stderr);
+    if (opts->profile && zz_profile_save(opts->profile) == 0)
+        zz_profile_summary(opts->profile, stderr);
+    if (opts->b_skipunfuzzed && (opts->b_verbose || opts->unfuzzed))
+        fprintf(stderr, "zzuf: %lli child%s read nothing fuzzed\n",
+                (long long int)opts->unfuzzed,
+                opts->unfuzzed > 1 ? "ren" : "");
+
     int ret = opts->crashes ? EXIT_FAILURE : EXIT_SUCCESS;
 
     /* Clean up */
     _zz_fd_fini();
     zzuf_destroy_opts(opts);
 
+#if defined HAVE_SIGACTION
+    /* Die the way we were asked to, now that our children are gone */
+    if (interrupted)
+    {
+        signal(interrupted, SIG_DFL);
+        raise(interrupted);
+    }
+#endif
+
     return ret;
 }
 
+#if defined HAVE_SIGACTION
+static void catch_signal(int signum)
+{
+    interrupted = signum;
+}
+#endif
+
 static void loop_stdin(zzuf_opts_t *opts)
 {
-    zzuf_md5sum_t *md5 = NULL;
+    zzuf_digest_t *digest = NULL;
     zzuf_hexdump_t *hex = NULL;
 
     if (opts->b_md5)
-        md5 = zzuf_create_md5();
+    {
+        digest = zzuf_create_digest(opts->hash, 1);
+        zz_digest_start(digest, 0);
+    }
     else if (opts->b_hex)
         hex = zzuf_create_hex();
 
     _zz_register(0);
 
+    int bytewise = _zz_fuzzing_bytewise();
+
+    /* With --insert-delete, fuzzed data is edited one whole chunk at a
+     * time, like libzzuf does with files */
+    uint8_t chunk[CHUNKBYTES];
+    uint8_t edited[CHUNKBYTES + MAX_CHUNK_EDITS * MAX_EDIT_LEN];
+    uint32_t seed = _zz_getfuzz(0)->seed;
+    int64_t nchunks = 0;
+    int chunklen = 0;
+
     for (int total = 0; ; )
     {
         uint8_t buf[BUFSIZ];
-        int toread = BUFSIZ, off = 0;
+        int toread = BUFSIZ;
 
         if (opts->maxbytes >= 0)
         {
@@ -604,29 +1060,56 @@ static void loop_stdin(zzuf_opts_t *opts)
         if (ret <= 0)
             break;
 
+        /* Words and characters that span two reads cannot be fuzzed,
+         * so reads must not stop wherever a pipe happens to */
+        while (!bytewise && ret < toread)
+        {
+            int n = read(0, buf + ret, toread - ret);
+            if (n <= 0)
+                break;
+            ret += n;
+        }
+
         total += ret;
 
         _zz_fuzz(0, buf, ret);
         _zz_addpos(0, ret);
 
-        if (opts->b_md5)
-            zz_md5_add(md5, buf, ret);
-        else if (opts->b_hex)
-            zz_hex_add(hex, buf, ret);
-        else while (ret)
+        if (_zz_get_resize() <= 0.0)
         {
-            int nw = 0;
-            if ((nw = write(1, buf + off, (unsigned int)ret)) < 0)
-                break;
-            ret -= nw;
-            off += nw;
+            output_stdin(opts, digest, hex, buf, ret);
+            continue;
+        }
+
+        for (int off = 0; off < ret; )
+        {
+            int n = ret - off < CHUNKBYTES - chunklen
+                  ? ret - off : CHUNKBYTES - chunklen;
+
+            memcpy(chunk + chunklen, buf + off, n);
+            chunklen += n;
+            off += n;
+
+            if (chunklen == CHUNKBYTES)
+            {
+                n = _zz_resize_chunk(seed, nchunks++, chunk, chunklen, edited);
+                output_stdin(opts, digest, hex, edited, n);
+                chunklen = 0;
+            }
         }
     }
 
+    if (chunklen > 0)
+    {
+        int n = _zz_resize_chunk(seed, nchunks, chunk, chunklen, edited);
+        output_stdin(opts, digest, hex, edited, n);
+    }
+
     if (opts->b_md5)
     {
         uint8_t md5sum[16];
-        zzuf_destroy_md5(md5sum, md5);
+        zz_digest_end(digest, 0, md5sum);
+        zzuf_destroy_digest(digest);
         finfo(stdout, opts, opts->seed);
         fprintf(stdout, "%.02x%.02x%.02x%.02x%.02x%.02x%.02x%.02x%.02x%.02x"
                 "%.02x%.02x%.02x%.02x%.02x%.02x\n", md5sum[0], md5sum[1],
@@ -643,6 +1126,45 @@ static void loop_stdin(zzuf_opts_t *opts)
     _zz_unregister(0);
 }
 
+static void output_stdin(zzuf_opts_t *opts, zzuf_digest_t *digest,
+                         zzuf_hexdump_t *hex, uint8_t *buf, int len)
+{
+    if (opts->b_md5)
+        zz_digest_add(digest, 0, buf, len);
+    else if (opts->b_hex)
+        zz_hex_add(hex, buf, len);
+    else for (int off = 0; len; )
+    {
+        int nw = 0;
+        if ((nw = write(1, buf + off, (unsigned int)len)) < 0)
+            break;
+        len -= nw;
+        off += nw;
+    }
+}
+
+/*
+ * Report a child's behaviour if it was never seen before, in this run or
+ * in a previous one using the same --novelty file.
+ */
+static void check_novelty(zzuf_opts_t *opts, int slot, char const *ending,
+                          uint8_t const *digest)
+{
+    zzuf_child_t *child = &opts->child[slot];
+    int64_t runtime = (zzuf_time() - child->date) / 1000;
+
+    if (!zz_novelty_add(opts->novelty, digest, ending, runtime))
+        return;
+
+    finfo(stdout, opts, child->seed);
+    fprintf(stdout, "new behaviour: %s in %lli ms, output ", ending,
+            (long long int)runtime);
+    for (int i = 0; i < 16; ++i)
+        fprintf(stdout, "%.02x", digest[i]);
+    fprintf(stdout, "\n");
+    fflush(stdout);
+}
+
 static void finfo(FILE *fp, zzuf_opts_t *opts, uint32_t seed)
 {
     if (opts->minratio == opts->maxratio)
@@ -702,29 +1224,86 @@ static char *merge_regex(char *regex, char *string)
 }
 #endif
 
-static void spawn_children(zzuf_opts_t *opts)
+/*
+ * Return how many microseconds we need to wait before launching the next
+ * child, or -1 if no child may be launched at all. The -D delay acts as a
+ * token bucket: up to opts->burst children can be launched at once, then
+ * one new token becomes available every opts->delay microseconds.
+ */
+static int64_t launch_delay(zzuf_opts_t *opts, int64_t now)
 {
-    int64_t now = zzuf_time();
-
-    if (opts->nchild == opts->maxchild)
-        return; /* no slot */
+    if (opts->nchild >= opts->jobs)
+        return -1; /* no slot */
 
     if (opts->seed == opts->endseed)
-        return; /* job finished */
+        return -1; /* job finished */
 
     if (opts->maxcrashes && opts->crashes >= opts->maxcrashes)
-        return; /* all jobs crashed */
+        return -1; /* all jobs crashed */
 
     if (opts->maxtime && now - opts->starttime >= opts->maxtime)
-        return; /* run time exceeded */
+        return -1; /* run time exceeded */
+
+    if (opts->delay <= 0)
+        return 0;
+
+    int64_t wait = opts->nextlaunch - (opts->burst - 1) * opts->delay - now;
+    return wait > 0 ? wait : 0;
+}
+
+/*
+ * Move on to the first seed whose fuzzed inputs differ from the original
+ * inputs and from those of every seed launched so far. We give up after
+ * a while to let the main loop do its job, since with very low ratios,
+ * most seeds do not change anything.
+ */
+static int skip_duplicates(zzuf_opts_t *opts)
+{
+    for (int tries = 0; tries < 1000; ++tries)
+    {
+        if (opts->seed == opts->endseed)
+            return -1;
+
+        enum dedup ret = zz_dedup_check(opts->dedup);
+        if (ret == DEDUP_NEW)
+            return 0;
+
+        if (opts->b_verbose)
+        {
+            finfo(stderr, opts, opts->seed);
+            fprintf(stderr, "skipped, %s\n", ret == DEDUP_UNCHANGED
+                    ? "input unchanged" : "duplicate input");
+        }
+
+        opts->seed++;
+        zzuf_set_seed(opts->seed);
+    }
+
+    return -1;
+}
+
+static void spawn_children(zzuf_opts_t *opts)
+{
+    /* Fill as many free slots as the token bucket allows in one pass */
+    for (int slot = 0; slot < opts->maxchild; ++slot)
+    {
+        if (opts->child[slot].status != STATUS_FREE)
+            continue;
 
-    if (opts->delay > 0 && opts->lastlaunch + opts->delay > now)
-        return; /* too early */
+        int64_t now = zzuf_time();
+        if (launch_delay(opts, now) != 0)
+            return; /* too early, or nothing left to do */
 
-    /* Find the empty slot */
-    int slot = 0;
-    while (slot < opts->maxchild && opts->child[slot].status != STATUS_FREE)
-        ++slot;
+        if (spawn_child(opts, slot, now) < 0)
+            return;
+    }
+}
+
+static int spawn_child(zzuf_opts_t *opts, int slot, int64_t now)
+{
+    /* Do not bother launching seeds that test nothing new */
+    if (opts->dedup && skip_duplicates(opts) < 0)
+        return -1;
 
     /* Prepare required files, if necessary */
     if (opts->opmode == OPMODE_COPY)
@@ -770,16 +1349,26 @@ static void spawn_children(zzuf_opts_t *opts)
 
             opts->child[slot].newargv[j - zz_optind] = strdup(tmpname);
 
+            /* Read one chunk at a time, so that --insert-delete edits
+             * the copy the way libzzuf edits files */
             _zz_register(k);
-            while (!feof(fpin))
+            for (int64_t chunk = 0; !feof(fpin); ++chunk)
             {
-                uint8_t buf[BUFSIZ];
-                size_t n = fread(buf, 1, BUFSIZ, fpin);
+                uint8_t buf[CHUNKBYTES];
+                uint8_t edited[CHUNKBYTES + MAX_CHUNK_EDITS * MAX_EDIT_LEN];
+                int n = (int)fread(buf, 1, CHUNKBYTES, fpin);
                 if (n <= 0)
                     break;
                 _zz_fuzz(k, buf, n);
                 _zz_addpos(k, n);
-                write(fdout, buf, n);
+                if (_zz_get_resize() > 0.0)
+                {
+                    n = _zz_resize_chunk(_zz_getfuzz(k)->seed, chunk,
+                                         buf, n, edited);
+                    write(fdout, edited, n);
+                }
+                else
+                    write(fdout, buf, n);
             }
             _zz_unregister(k);
 
@@ -790,24 +1379,44 @@ static void spawn_children(zzuf_opts_t *opts)
         }
     }
 
+    /* Remember the OOM kill count, to tell whether this child gets one */
+    opts->child[slot].ooms = opts->cgroup ? zz_cgroup_ooms(opts->cgroup, slot)
+                                          : -1;
+
     /* Launch process */
     if (myfork(&opts->child[slot], opts) < 0)
     {
         fprintf(stderr, "error launching `%s'\n", opts->child[slot].newargv[0]);
         opts->seed++;
         /* FIXME: clean up OPMODE_COPY files here */
-        return;
+        return -1;
     }
 
+#if !defined _WIN32
+    /* Watch the child's pipes and, if possible, the child itself */
+    for (int j = 0; j < 3; ++j)
+        zz_loop_add(opts->loop, opts->child[slot].fd[j], slot, j);
+    opts->child[slot].pidfd = zz_loop_add_pid(opts->loop,
+                                              opts->child[slot].pid, slot);
+#endif
+
     /* We’re the parent, acknowledge spawn */
     opts->child[slot].date = now;
     opts->child[slot].bytes = 0;
+    opts->child[slot].flips = -1;
+    opts->child[slot].closed = 0;
     opts->child[slot].seed = opts->seed;
     opts->child[slot].ratio = zzuf_get_ratio();
     opts->child[slot].status = STATUS_RUNNING;
-    if (opts->b_md5)
-        opts->child[slot].md5 = zzuf_create_md5();
-    else if (opts->b_hex)
+    for (int j = 0; j < 2; ++j)
+    {
+        zz_scan_reset(&opts->child[slot].scan[j]);
+        if (opts->child[slot].ring[j])
+            zz_ring_reset(opts->child[slot].ring[j]);
+    }
+    if (opts->digest)
+        zz_digest_start(opts->digest, slot);
+    if (opts->b_hex)
         opts->child[slot].hex = zzuf_create_hex();
 
     if (opts->b_verbose)
@@ -816,11 +1425,15 @@ static void spawn_children(zzuf_opts_t *opts)
         fprintf(stderr, "launched `%s'\n", opts->child[slot].newargv[0]);
     }
 
-    opts->lastlaunch = now;
+    /* Consume one token */
+    if (opts->delay > 0)
+        opts->nextlaunch = (opts->nextlaunch > now ? opts->nextlaunch : now)
+                            + opts->delay;
     opts->nchild++;
     opts->seed++;
 
     zzuf_set_seed(opts->seed);
+    return 0;
 }
 
 static void clean_children(zzuf_opts_t *opts)
@@ -836,42 +1449,19 @@ static void clean_children(zzuf_opts_t *opts)
         if (opts->child[i].status == STATUS_RUNNING
             && opts->maxbytes >= 0
             && opts->child[i].bytes > opts->maxbytes)
-        {
-            if (opts->b_verbose)
-            {
-                finfo(stderr, opts, opts->child[i].seed);
-                fprintf(stderr, "data output exceeded, sending SIGTERM\n");
-            }
-#if defined HAVE_KILL
-            kill(opts->child[i].pid, SIGTERM);
-#else
-            /* We must invalidate fd */
-            memset(opts->child[i].fd, -1, sizeof(opts->child[i].fd));
-            TerminateProcess(opts->child[i].process_handle, 0x0);
-#endif
-            opts->child[i].date = now;
-            opts->child[i].status = STATUS_SIGTERM;
-        }
+            kill_child(opts, i, now, "data output exceeded");
 
         if (opts->child[i].status == STATUS_RUNNING
              && opts->maxusertime >= 0
              && now > opts->child[i].date + opts->maxusertime)
-        {
-            if (opts->b_verbose)
-            {
-                finfo(stderr, opts, opts->child[i].seed);
-                fprintf(stderr, "running time exceeded, sending SIGTERM\n");
-            }
-#if defined HAVE_KILL
-            kill(opts->child[i].pid, SIGTERM);
-#else
-            /* We must invalidate fd */
-            memset(opts->child[i].fd, -1, sizeof(opts->child[i].fd));
-            TerminateProcess(opts->child[i].process_handle, 0x0);
-#endif
-            opts->child[i].date = now;
-            opts->child[i].status = STATUS_SIGTERM;
-        }
+            kill_child(opts, i, now, "running time exceeded");
+
+        /* The child closed its input without reading any fuzzed byte;
+         * whatever it does next is what it would do without zzuf. */
+        if (opts->child[i].status == STATUS_RUNNING
+             && opts->b_skipunfuzzed && opts->child[i].closed
+             && opts->child[i].flips == 0)
+            kill_child(opts, i, now, "input read unfuzzed");
     }
 
     /* Kill children if necessary (still there after 2 seconds) */
@@ -887,6 +1477,8 @@ static void clean_children(zzuf_opts_t *opts)
             }
 #if defined HAVE_KILL
             kill(opts->child[i].pid, SIGKILL);
+            if (opts->cgroup)
+                zz_cgroup_kill(opts->cgroup, i);
 #else
             TerminateProcess(opts->child[i].process_handle, 0x0);
 #endif
@@ -899,6 +1491,8 @@ static void clean_children(zzuf_opts_t *opts)
     for (int i = 0; i < opts->maxchild; ++i)
     {
         uint8_t md5sum[16];
+        char ending[64] = "";
+        int noop = 0;
 #if defined HAVE_WAITPID
         int status;
         pid_t pid;
@@ -910,15 +1504,54 @@ static void clean_children(zzuf_opts_t *opts)
             continue;
 
 #if defined HAVE_WAITPID
+        /* If we have a pidfd, the event loop tells us when to reap */
+        if (opts->child[i].pidfd >= 0)
+            continue;
+
         pid = waitpid(opts->child[i].pid, &status, WNOHANG);
         if (pid <= 0)
             continue;
 
-        if (opts->b_checkexit && WIFEXITED(status) && WEXITSTATUS(status))
+        char kind[64];
+
+        if (WIFSIGNALED(status))
+            sprintf(ending, "signal %i", WTERMSIG(status));
+        else
+            sprintf(ending, "exit %i", WEXITSTATUS(status));
+
+        /* The last line of output may lack a newline */
+        for (int j = 0; j < 2; ++j)
+            zz_scan_flush(opts->scan, &opts->child[i].scan[j],
+                          &opts->child[i].report);
+
+        /* With cgroups, we know for sure whether the OOM killer fired,
+         * and we can get rid of any processes left behind. */
+        int oom = 0;
+        if (opts->cgroup)
+        {
+            int64_t ooms = zz_cgroup_ooms(opts->cgroup, i);
+            oom = opts->child[i].ooms >= 0 && ooms > opts->child[i].ooms;
+            zz_cgroup_kill(opts->cgroup, i);
+        }
+
+        /* Nothing fuzzed, so nothing to report */
+        noop = opts->b_skipunfuzzed && opts->child[i].flips == 0;
+
+        if (noop)
+        {
+            opts->unfuzzed++;
+            if (opts->b_verbose)
+            {
+                finfo(stderr, opts, opts->child[i].seed);
+                fprintf(stderr, "%s, nothing fuzzed\n", ending);
+            }
+        }
+        else if (opts->b_checkexit && WIFEXITED(status) && WEXITSTATUS(status))
         {
             finfo(stderr, opts, opts->child[i].seed);
             fprintf(stderr, "exit %i\n", WEXITSTATUS(status));
-            opts->crashes++;
+            sprintf(kind, "exit %i", WEXITSTATUS(status));
+            report_crash(opts, i, kind);
         }
         else if (WIFSIGNALED(status)
                  && !(WTERMSIG(status) == SIGTERM
@@ -926,7 +1559,10 @@ static void clean_children(zzuf_opts_t *opts)
         {
             char const *message = "";
 
-            if (WTERMSIG(status) == SIGKILL && opts->maxmem >= 0)
+            if (oom)
+                message = " (memory exceeded)";
+            else if (WTERMSIG(status) == SIGKILL && opts->maxmem >= 0
+                      && !zz_cgroup_has_memory(opts->cgroup))
                 message = " (memory exceeded?)";
 #   if defined SIGXCPU
             else if (WTERMSIG(status) == SIGXCPU && opts->maxcpu >= 0)
@@ -938,7 +1574,16 @@ static void clean_children(zzuf_opts_t *opts)
             finfo(stderr, opts, opts->child[i].seed);
             fprintf(stderr, "signal %i%s%s\n",
                     WTERMSIG(status), sig2name(WTERMSIG(status)), message);
-            opts->crashes++;
+            sprintf(kind, "signal %i%s", WTERMSIG(status), message);
+            report_crash(opts, i, kind);
+        }
+        else if (opts->child[i].report)
+        {
+            /* Sanitizers usually exit with a non-zero status, but some
+             * errors are reported without exiting at all */
+            finfo(stderr, opts, opts->child[i].seed);
+            fprintf(stderr, "%s\n", ending);
+            report_crash(opts, i, ending);
         }
         else if (opts->b_verbose)
         {
@@ -955,6 +1600,7 @@ static void clean_children(zzuf_opts_t *opts)
             if (GetExitCodeProcess(opts->child[i].process_handle, &exit_code))
             {
                 if (exit_code == STILL_ACTIVE) continue; /* The process is still active, we don't do anything */
+                sprintf(ending, "exit %#08lx", (unsigned long)exit_code);
 
                 /*
                  * The main problem with GetExitCodeProcess is it returns either returned parameter value of
@@ -979,7 +1625,19 @@ static void clean_children(zzuf_opts_t *opts)
 
         for (int j = 0; j < 3; ++j)
             if (opts->child[i].fd[j] >= 0)
+            {
+#if !defined _WIN32
+                zz_loop_del(opts->loop, opts->child[i].fd[j]);
+#endif
                 close(opts->child[i].fd[j]);
+            }
+
+        free(opts->child[i].crash);
+        free(opts->child[i].report);
+        free(opts->child[i].debug);
+        opts->child[i].crash = opts->child[i].report = NULL;
+        opts->child[i].debug = NULL;
+        opts->child[i].debuglen = 0;
 
         if (opts->opmode == OPMODE_COPY)
         {
@@ -994,9 +1652,15 @@ static void clean_children(zzuf_opts_t *opts)
             }
         }
 
-        if (opts->b_md5)
+        if (opts->digest)
+            zz_digest_end(opts->digest, i, md5sum);
+
+        if (noop)
+            ;
+        else if (opts->novelty)
+            check_novelty(opts, i, ending, md5sum);
+        else if (opts->b_md5)
         {
-            zzuf_destroy_md5(md5sum, opts->child[i].md5);
             finfo(stdout, opts, opts->child[i].seed);
             fprintf(stdout, "%.02x%.02x%.02x%.02x%.02x%.02x%.02x%.02x%.02x"
                     "%.02x%.02x%.02x%.02x%.02x%.02x%.02x\n", md5sum[0],
@@ -1005,14 +1669,42 @@ static void clean_children(zzuf_opts_t *opts)
                     md5sum[11], md5sum[12], md5sum[13], md5sum[14], md5sum[15]);
             fflush(stdout);
         }
-        else if (opts->b_hex)
+
+        if (opts->b_hex)
         {
             zzuf_destroy_hex(opts->child[i].hex);
         }
         opts->child[i].status = STATUS_FREE;
         opts->nchild--;
+        opts->nreaped++;
+    }
+}
+
+#if defined HAVE_KILL || defined HAVE_WINDOWS_H
+/*
+ * Ask a running child to terminate; clean_children() sends SIGKILL if it
+ * is still there after 2 seconds.
+ */
+static void kill_child(zzuf_opts_t *opts, int i, int64_t now,
+                       char const *why)
+{
+    if (opts->b_verbose)
+    {
+        finfo(stderr, opts, opts->child[i].seed);
+        fprintf(stderr, "%s, sending SIGTERM\n", why);
     }
+#if defined HAVE_KILL
+    kill(opts->child[i].pid, SIGTERM);
+    unwatch_child(opts, i);
+#else
+    /* We must invalidate fd */
+    memset(opts->child[i].fd, -1, sizeof(opts->child[i].fd));
+    TerminateProcess(opts->child[i].process_handle, 0x0);
+#endif
+    opts->child[i].date = now;
+    opts->child[i].status = STATUS_SIGTERM;
 }
+#endif
 
 #ifdef _WIN32
 
@@ -1050,11 +1742,19 @@ static void __stdcall read_child(DWORD err_code, DWORD nbr_of_bytes_transfered,
     zzuf_mutex_unlock(&pipe_mutex);
 
     if (co->fd_no != 0) /* either out or err fd */
-        co->opts->child[co->child_no].bytes += nbr_of_bytes_transfered;
+    {
+        zzuf_child_t *child = &co->opts->child[co->child_no];
+        child->bytes += nbr_of_bytes_transfered;
+        zz_scan_feed(co->opts->scan, &child->scan[co->fd_no - 1],
+                     co->buf, nbr_of_bytes_transfered, &child->report);
+        if (child->ring[co->fd_no - 1])
+            zz_ring_add(child->ring[co->fd_no - 1], co->buf,
+                        nbr_of_bytes_transfered);
+    }
 
-    if (co->opts->b_md5 && co->fd_no == 2)
-        zz_md5_add(co->opts->child[co->child_no].md5, co->buf, nbr_of_bytes_transfered);
-    else if (co->opts->b_hex && co->fd_no == 2)
+    if (co->opts->digest && co->fd_no == 2)
+        zz_digest_add(co->opts->digest, co->child_no, co->buf, nbr_of_bytes_transfered);
+    if (co->opts->b_hex && co->fd_no == 2)
         zz_hex_add(co->opts->child[co->child_no].hex, co->buf, nbr_of_bytes_transfered);
 
     free(co); /* clean up allocated data */
@@ -1116,58 +1816,66 @@ static void read_children(zzuf_opts_t *opts)
 #else
 static void read_children(zzuf_opts_t *opts)
 {
-    struct timeval tv;
-    fd_set fdset;
-    int maxfd = 0;
-
-    /* Read data from all sockets */
-    FD_ZERO(&fdset);
-    for (int i = 0; i < opts->maxchild; ++i)
-    {
-        if (opts->child[i].status != STATUS_RUNNING)
-            continue;
+    zzuf_event_t events[64];
 
-        for (int j = 0; j < 3; ++j)
-            ZZUF_FD_SET(opts->child[i].fd[j], &fdset, maxfd);
-    }
-    tv.tv_sec = 0;
-    tv.tv_usec = 1000;
-
-    errno = 0;
-    int ret = select(maxfd + 1, &fdset, NULL, NULL, &tv);
-    if (ret < 0 && errno)
-        perror("select");
-    if (ret <= 0)
-        return;
+    /* Sleep until a child has something for us or a deadline expires */
+    int n = zz_loop_wait(opts->loop, next_timeout(opts), events, 64);
 
-    for (int i = 0; i < opts->maxchild; ++i)
-    for (int j = 0; j < 3; ++j)
+    for (int k = 0; k < n; ++k)
     {
+        int i = events[k].slot, j = events[k].channel;
         uint8_t buf[BUFSIZ];
 
-        if (opts->child[i].status != STATUS_RUNNING)
+        if (j == LOOP_EXIT)
+        {
+            /* The child died; clean_children() may now reap it */
+            zz_loop_del(opts->loop, opts->child[i].pidfd);
+            close(opts->child[i].pidfd);
+            opts->child[i].pidfd = -1;
+
+            /* Do not let leftover processes keep the pipes open */
+            if (opts->cgroup)
+                zz_cgroup_kill(opts->cgroup, i);
             continue;
+        }
 
-        if (!ZZUF_FD_ISSET(opts->child[i].fd[j], &fdset))
+        if (opts->child[i].status != STATUS_RUNNING
+             || opts->child[i].fd[j] < 0)
             continue;
 
-        ret = read(opts->child[i].fd[j], buf, BUFSIZ - 1);
+        int ret = read(opts->child[i].fd[j], buf, BUFSIZ);
         if (ret > 0)
         {
             /* We got data */
-            if (j != 0)
-                opts->child[i].bytes += ret;
+            if (j == 0)
+            {
+                read_debug(opts, i, buf, ret, 0);
+                continue;
+            }
+
+            opts->child[i].bytes += ret;
+            zz_scan_feed(opts->scan, &opts->child[i].scan[j - 1], buf,
+                         ret, &opts->child[i].report);
+            if (opts->child[i].ring[j - 1])
+                zz_ring_add(opts->child[i].ring[j - 1], buf, ret);
+
+            if (opts->digest && j == 2)
+                zz_digest_add(opts->digest, i, buf, ret);
 
-            if (opts->b_md5 && j == 2)
-                zz_md5_add(opts->child[i].md5, buf, ret);
+            /* With -m and --novelty, stdout is only hashed */
+            if (ret == 0 || ((opts->b_md5 || opts->novelty) && j == 2))
+                continue;
             else if (opts->b_hex && j == 2)
                 zz_hex_add(opts->child[i].hex, buf, ret);
-            else if (!opts->b_quiet || j == 0)
+            else if (!opts->b_quiet && !opts->outdir)
                 write((j < 2) ? STDERR_FILENO : STDOUT_FILENO, buf, ret);
         }
         else if (ret == 0)
         {
             /* End of file reached */
+            if (j == 0)
+                read_debug(opts, i, NULL, 0, 1);
+            zz_loop_del(opts->loop, opts->child[i].fd[j]);
             close(opts->child[i].fd[j]);
             opts->child[i].fd[j] = -1;
 
@@ -1178,6 +1886,205 @@ static void read_children(zzuf_opts_t *opts)
         }
     }
 }
+
+/*
+ * Add data from a child's debug channel to what is left of the previous
+ * reads, and handle the complete lines, or everything at end of file.
+ * libzzuf writes each record with a single write() call, but a read may
+ * still stop in the middle of one, so records are only looked for in
+ * whole lines. What remains once they are removed goes to stderr.
+ */
+static void read_debug(zzuf_opts_t *opts, int i, uint8_t const *buf,
+                       int len, int eof)
+{
+    zzuf_child_t *child = &opts->child[i];
+
+    /* One more byte for the terminator that get_*() add */
+    child->debug = realloc(child->debug, child->debuglen + len + 1);
+    if (len > 0)
+        memcpy(child->debug + child->debuglen, buf, len);
+    child->debuglen += len;
+
+    int done = child->debuglen;
+    if (!eof)
+        while (done > 0 && child->debug[done - 1] != '\n')
+            --done;
+    if (done == 0)
+        return;
+
+    uint8_t tmp = child->debug[done];
+    int ret = done;
+
+    /* Keep crash, flip and read records for ourselves */
+    if (opts->b_crashinfo)
+        ret = get_crash(child, child->debug, ret);
+    if (opts->b_skipunfuzzed)
+        ret = get_flips(child, child->debug, ret);
+    if (opts->profile)
+        ret = get_reads(opts->profile, child->debug, ret);
+
+    if (ret > 0)
+        write(STDERR_FILENO, child->debug, ret);
+
+    child->debug[done] = tmp;
+    child->debuglen -= done;
+    memmove(child->debug, child->debug + done, child->debuglen);
+}
+
+/*
+ * Look for a crash record sent by libzzuf's crash handler in the given
+ * debug channel lines. We keep the first record and remove it from the
+ * data. Returns the remaining length.
+ */
+static int get_crash(zzuf_child_t *child, uint8_t *buf, int len)
+{
+    static char const marker[] = "** zzuf crash ** ";
+
+    buf[len] = '\0';
+    char *start = strstr((char *)buf, marker);
+    if (!start)
+        return len;
+
+    char *end = strchr(start, '\n');
+    end = end ? end + 1 : (char *)buf + len;
+
+    if (!child->crash)
+    {
+        child->crash = strdup(start + strlen(marker));
+        child->crash[strcspn(child->crash, "\n")] = '\0';
+    }
+
+    memmove(start, end, (char *)buf + len - end);
+    return len - (int)(end - start);
+}
+
+/*
+ * Look for flip records sent by libzzuf when the child closes its last
+ * watched file or exits, and remove them from the debug channel data.
+ * Each process of the child sends its own records, so the child counts
+ * as fuzzed as soon as one of them flipped something. Returns the
+ * remaining length.
+ */
+static int get_flips(zzuf_child_t *child, uint8_t *buf, int len)
+{
+    static char const marker[] = "** zzuf flips ** ";
+    char *start;
+
+    buf[len] = '\0';
+    while ((start = strstr((char *)buf, marker)))
+    {
+        char *end = strchr(start, '\n');
+        end = end ? end + 1 : (char *)buf + len;
+
+        char *event;
+        long long int flips = strtoll(start + strlen(marker), &event, 10);
+        if (flips > child->flips)
+            child->flips = flips;
+        if (!strncmp(event, " closed", 7))
+            child->closed = 1;
+
+        memmove(start, end, (char *)buf + len - end + 1);
+        len -= (int)(end - start);
+    }
+
+    return len;
+}
+
+/*
+ * Look for read records sent by libzzuf along with flip records, merge
+ * them into the profile and remove them from the debug channel data.
+ * Returns the remaining length.
+ */
+static int get_reads(zzuf_profile_t *profile, uint8_t *buf, int len)
+{
+    static char const marker[] = "** zzuf reads **";
+    char *start;
+
+    buf[len] = '\0';
+    while ((start = strstr((char *)buf, marker)))
+    {
+        char *end = strchr(start, '\n');
+        end = end ? end + 1 : (char *)buf + len;
+
+        /* Do not let the parser go past the end of the record */
+        char tmp = *end;
+        *end = '\0';
+        zz_profile_add(profile, start + strlen(marker));
+        *end = tmp;
+
+        memmove(start, end, (char *)buf + len - end + 1);
+        len -= (int)(end - start);
+    }
+
+    return len;
+}
+
+/*
+ * Compute how long the event loop may sleep before one of our deadlines
+ * expires: next launch, -U timeout or SIGKILL escalation. Returns -1 if
+ * there is nothing to wait for but children activity.
+ */
+static int64_t next_timeout(zzuf_opts_t *opts)
+{
+    int64_t now = zzuf_time(), timeout = -1;
+
+#define ZZUF_DEADLINE(t) \
+    do { \
+        int64_t tmp = (t); \
+        if (tmp < 0) \
+            tmp = 0; \
+        if (timeout < 0 || tmp < timeout) \
+            timeout = tmp; \
+    } while (0)
+
+    int64_t delay = launch_delay(opts, now);
+    if (delay >= 0)
+        ZZUF_DEADLINE(delay);
+
+    if (opts->autojobs && opts->seed < opts->endseed)
+        ZZUF_DEADLINE(zz_jobs_deadline(opts->autojobs) - now);
+
+    for (int i = 0; i < opts->maxchild; ++i)
+    {
+        switch (opts->child[i].status)
+        {
+        case STATUS_RUNNING:
+            if (opts->maxusertime >= 0)
+                ZZUF_DEADLINE(opts->child[i].date + opts->maxusertime
+                               - now + 1);
+            break;
+        case STATUS_SIGTERM:
+            ZZUF_DEADLINE(opts->child[i].date + 2000000 - now + 1);
+            /* Fall through */
+        case STATUS_SIGKILL:
+        case STATUS_EOF:
+            /* Without a pidfd, we need to poll waitpid() */
+            if (opts->child[i].pidfd < 0)
+                ZZUF_DEADLINE(1000);
+            break;
+        default:
+            break;
+        }
+    }
+
+#undef ZZUF_DEADLINE
+
+    /* Nothing will ever wake us up: let the main loop decide what to do */
+    if (timeout < 0 && opts->nchild == 0)
+        timeout = 0;
+
+    return timeout;
+}
+
+/*
+ * Stop listening to a child that we are about to kill. The pipes are
+ * kept open until the child is reaped.
+ */
+static void unwatch_child(zzuf_opts_t *opts, int i)
+{
+    for (int j = 0; j < 3; ++j)
+        zz_loop_del(opts->loop, opts->child[i].fd[j]);
+}
 #endif
 
 #if !defined HAVE_SETENV
@@ -1193,6 +2100,65 @@ static void setenv(char const *name, char const *value, int overwrite)
 #endif
 
 #if defined HAVE_WAITPID
+/*
+ * Put a crash in its bucket. Error reports found in the output describe
+ * the crash better than the way the child exited. Reports and crash
+ * records are only printed for the first crash of a bucket, since the
+ * others are most probably the same bug.
+ */
+static void report_crash(zzuf_opts_t *opts, int slot, char const *kind)
+{
+    zzuf_child_t *child = &opts->child[slot];
+    int count;
+
+    uint32_t hash = zz_crashes_add(opts->buckets,
+                                   child->report ? child->report : kind,
+                                   child->crash, child->seed, child->ratio,
+                                   &count);
+    if (count > 1)
+    {
+        finfo(stderr, opts, child->seed);
+        fprintf(stderr, "crash %08x: duplicate (%i times)\n", hash, count);
+    }
+    else
+    {
+        if (child->report)
+        {
+            finfo(stderr, opts, child->seed);
+            fprintf(stderr, "crash %08x: %s\n", hash, child->report);
+        }
+        if (child->crash)
+        {
+            finfo(stderr, opts, child->seed);
+            fprintf(stderr, "crash %08x: %s\n", hash, child->crash);
+        }
+    }
+
+    /* Keep what the child said last */
+    for (int j = 0; j < 2 && opts->outdir; ++j)
+    {
+        char *path;
+
+        if (!zz_ring_count(child->ring[j]))
+            continue;
+
+        path = malloc(strlen(opts->outdir) + 32);
+        sprintf(path, "%s/%i.%s", opts->outdir, child->seed,
+                j ? "stdout" : "stderr");
+        if (zz_ring_save(child->ring[j], path) < 0)
+            fprintf(stderr, "zzuf: cannot write %s: %s\n", path,
+                    strerror(errno));
+        else if (opts->b_verbose)
+        {
+            finfo(stderr, opts, child->seed);
+            fprintf(stderr, "saved %s\n", path);
+        }
+        free(path);
+    }
+
+    opts->crashes++;
+}
+
 static char const *sig2name(int signum)
 {
     switch (signum)
@@ -1244,11 +2210,11 @@ static void version(void)
 static void usage(void)
 {
 #if defined HAVE_REGEX_H
-    printf("Usage: zzuf [-aAcdimnqSvx] [-s seed|-s start:stop] [-r ratio|-r min:max]\n");
+    printf("Usage: zzuf [-aAcdgikKmnqSvx] [-s seed|-s start:stop] [-r ratio|-r min:max]\n");
 #else
-    printf("Usage: zzuf [-aAdimnqSvx] [-s seed|-s start:stop] [-r ratio|-r min:max]\n");
+    printf("Usage: zzuf [-aAdgikKmnqSvx] [-s seed|-s start:stop] [-r ratio|-r min:max]\n");
 #endif
-    printf("            [-f mode] [-D delay] [-j jobs] [-C crashes] [-B bytes] [-a list]\n");
+    printf("            [-f mode] [-D delay[:burst]] [-j jobs] [-C crashes] [-B bytes] [-a list]\n");
     printf("            [-t seconds]");
 #if defined HAVE_SETRLIMIT && defined ZZUF_RLIMIT_CPU
     printf(                          " [-T seconds]");
@@ -1262,7 +2228,7 @@ static void usage(void)
     printf(                                                " [-I include] [-E exclude]");
 #endif
     printf("\n");
-    printf("            [-O mode] [PROGRAM [--] [ARGS]...]\n");
+    printf("            [-L cpus] [-w string] [-o dir] [-O mode] [PROGRAM [--] [ARGS]...]\n");
     printf("       zzuf -h | --help\n");
     printf("       zzuf -V | --version\n");
     printf("Run PROGRAM with optional arguments ARGS and fuzz its input.\n");
@@ -1272,30 +2238,49 @@ static void usage(void)
     printf("          ... !<list>       do not fuzz network input for IPs in <list>\n");
     printf("  -A, --autoinc             increment seed each time a new file is opened\n");
     printf("  -b, --bytes <ranges>      only fuzz bytes at offsets within <ranges>\n");
+    printf("  -b, --bytes auto:<file>   only fuzz bytes read in profile <file>\n");
     printf("  -B, --max-bytes <n>       kill children that output more than <n> bytes\n");
 #if defined HAVE_REGEX_H
     printf("  -c, --cmdline             only fuzz files specified in the command line\n");
 #endif
     printf("  -C, --max-crashes <n>     stop after <n> children have crashed (default 1)\n");
     printf("  -d, --debug               print debug messages (twice for more verbosity)\n");
-    printf("  -D, --delay               delay between forks\n");
+    printf("  -D, --delay <delay>       delay between forks\n");
+    printf("          ... <delay:burst> allow bursts of up to <burst> forks\n");
 #if defined HAVE_REGEX_H
     printf("  -E, --exclude <regex>     do not fuzz files matching <regex>\n");
 #endif
-    printf("  -f, --fuzzing <mode>      use fuzzing mode <mode> ([xor] set unset)\n");
+    printf("  -f, --fuzzing <mode>      use fuzzing mode <mode> ([xor] set unset\n");
+    printf("                            byte arith8 arith16le arith16be arith32le\n");
+    printf("                            arith32be swap16 swap32 text dict:<file>)\n");
+    printf("      --fix-checksums <l>   recompute checksums in <l> after fuzzing\n");
+    printf("      --mutator <file>      fuzz with the plugin in <file> instead of -f\n");
+    printf("  -g, --cgroup              run each job slot in its own cgroup\n");
+    printf("      --cgroup-cpu <n>      limit each cgroup to <n> CPUs worth of time\n");
     printf("  -i, --stdin               fuzz standard input\n");
 #if defined HAVE_REGEX_H
     printf("  -I, --include <regex>     only fuzz files matching <regex>\n");
 #endif
+    printf("      --inflate             fuzz data decompressed by zlib instead of files\n");
+    printf("      --insert-delete <r>   insert and delete byte runs at ratio <r>\n");
     printf("  -j, --jobs <n>            number of simultaneous jobs (default 1)\n");
+    printf("         ... auto[:<max>]   adapt the number of jobs to the system load\n");
+    printf("  -k, --pin                 pin each job to its own CPU\n");
+    printf("  -K, --crash-info          report crash location instead of dumping core\n");
+    printf("  -L, --cpu-list <list>     pin each job to a CPU within <list>\n");
     printf("  -l, --list <list>         only fuzz Nth descriptor with N in <list>\n");
     printf("  -m, --md5                 compute the output's MD5 hash\n");
+    printf("      --hash <hash>         use <hash> for -m ([md5] mmh3)\n");
 #if defined HAVE_SETRLIMIT && defined ZZUF_RLIMIT_MEM
     printf("  -M, --max-memory <n>      maximum child virtual memory in MiB (default %u)\n", DEFAULT_MEM);
 #endif
     printf("  -n, --network             fuzz network input\n");
+    printf("      --novelty <file>      only report new behaviours, saved in <file>\n");
+    printf("  -o, --output <dir>        save the output of crashing children in <dir>\n");
+    printf("      --output-size <n>     keep at most <n> KiB of each output (default %i)\n", DEFAULT_OUTSIZE);
     printf("  -O, --opmode <mode>       use operating mode <mode> ([preload] copy null)\n");
     printf("  -p, --ports <list>        only fuzz network destination ports in <list>\n");
+    printf("      --profile-reads <f>   save the input ranges read by children in <f>\n");
     printf("  -P, --protect <list>      protect bytes and characters in <list>\n");
     printf("  -q, --quiet               do not print children's messages\n");
     printf("  -r, --ratio <ratio>       bit fuzzing ratio (default %g)\n", DEFAULT_RATIO);
@@ -1304,10 +2289,13 @@ static void usage(void)
     printf("  -s, --seed <seed>         random seed (default %i)\n", DEFAULT_SEED);
     printf("         ... <start:stop>   specify a seed range\n");
     printf("  -S, --signal              prevent children from diverting crashing signals\n");
+    printf("      --skip-duplicates     do not run seeds that fuzz inputs like another seed\n");
+    printf("      --skip-unfuzzed       stop children that read nothing fuzzed\n");
     printf("  -t, --max-time <n>        stop spawning children after <n> seconds\n");
     printf("  -T, --max-cputime <n>     kill children that use more than <n> CPU seconds\n");
     printf("  -U, --max-usertime <n>    kill children that run for more than <n> seconds\n");
     printf("  -v, --verbose             print information during the run\n");
+    printf("  -w, --watch <string>      consider outputs containing <string> as crashes\n");
     printf("  -x, --check-exit          report processes that exit with a non-zero status\n");
     printf("  -X, --hex                 convert program output to hexadecimal\n");
     printf("  -h, --help                display this help and exit\n");
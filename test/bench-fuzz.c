@@ -0,0 +1,87 @@
+/*
+ *  bench-fuzz - measure the throughput of each fuzzing mode
+ *
+ *  Copyright © 2002—2015 Sam Hocevar <sam@hocevar.net>
+ *
+ *  This program is free software. It comes without any warranty, to
+ *  the extent permitted by applicable law. You can redistribute it
+ *  and/or modify it under the terms of the Do What the Fuck You Want
+ *  to Public License, Version 2, as published by the WTFPL Task Force.
+ *  See http://www.wtfpl.net/ for more details.
+ */
+
+/*
+ *  Usage: bench-fuzz [ratio [mode...]]
+ *
+ *  Fuzzes 64 MiB of random data in 4 KiB reads, the size of a stdio
+ *  buffer, with each mode in turn, and prints the throughput in MiB/s.
+ *  This is not run by "make check"; build it with "make bench-fuzz".
+ */
+
+#include "config.h"
+
+#if defined HAVE_STDINT_H
+#   include <stdint.h>
+#elif defined HAVE_INTTYPES_H
+#   include <inttypes.h>
+#endif
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include "common.h"
+#include "fuzz.h"
+#include "fd.h"
+
+#define TOTAL (64 << 20)
+#define READ 4096
+
+int main(int argc, char *argv[])
+{
+    static char *default_modes[] =
+    {
+        "xor", "set", "unset", "byte", "arith8", "arith16le", "arith16be",
+        "arith32le", "arith32be", "swap16", "swap32", "text",
+    };
+
+    double ratio = argc > 1 ? atof(argv[1]) : DEFAULT_RATIO;
+    char **modes = argc > 2 ? argv + 2 : default_modes;
+    int nmodes = argc > 2 ? argc - 2
+               : (int)(sizeof(default_modes) / sizeof(*default_modes));
+
+    uint8_t *buf = malloc(TOTAL);
+    uint32_t x = 1;
+    for (int i = 0; i < TOTAL; ++i)
+    {
+        x = x * 1103515245 + 12345;
+        buf[i] = (uint8_t)(x >> 24);
+    }
+
+    zzuf_set_ratio(ratio, ratio);
+    printf("ratio %g, %i MiB in %i-byte reads\n", ratio, TOTAL >> 20, READ);
+
+    for (int m = 0; m < nmodes; ++m)
+    {
+        fuzz_context_t fuzz;
+
+        if (_zz_fuzzing(modes[m]) < 0)
+        {
+            fprintf(stderr, "bench-fuzz: invalid mode `%s'\n", modes[m]);
+            return EXIT_FAILURE;
+        }
+
+        _zz_initfuzz(&fuzz);
+
+        clock_t t = clock();
+        for (int64_t pos = 0; pos < TOTAL; pos += READ)
+            _zz_fuzz_data(&fuzz, pos, buf + pos, READ);
+        t = clock() - t;
+
+        double secs = (double)t / CLOCKS_PER_SEC;
+        printf("%-10s %8.1f MiB/s\n", modes[m],
+               secs > 0. ? (TOTAL >> 20) / secs : 0.);
+    }
+
+    free(buf);
+    return EXIT_SUCCESS;
+}
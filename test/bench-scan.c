@@ -0,0 +1,103 @@
+/*
+ *  bench-scan - measure how fast child output is scanned for reports
+ *
+ *  Copyright © 2002—2015 Sam Hocevar <sam@hocevar.net>
+ *
+ *  This program is free software. It comes without any warranty, to
+ *  the extent permitted by applicable law. You can redistribute it
+ *  and/or modify it under the terms of the Do What the Fuck You Want
+ *  to Public License, Version 2, as published by the WTFPL Task Force.
+ *  See http://www.wtfpl.net/ for more details.
+ */
+
+/*
+ *  Usage: bench-scan [file]
+ *
+ *  Scans 256 MiB made of copies of <file> (file-text by default) in
+ *  64 KiB reads, the size of a pipe buffer, and prints the throughput in
+ *  MB/s with the built-in patterns only, with enough -w patterns to need
+ *  the prefix bitmap instead of SSE2, and with a one-byte pattern, which
+ *  disables the prefix search altogether. This is not run by "make
+ *  check"; build it with "make bench-scan".
+ */
+
+#include "config.h"
+
+#if defined HAVE_STDINT_H
+#   include <stdint.h>
+#elif defined HAVE_INTTYPES_H
+#   include <inttypes.h>
+#endif
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "scan.h"
+
+#define TOTAL (256 << 20)
+#define READ 65536
+
+static char *bitmap_patterns[] =
+{
+    "panic:", "fatal error", "Traceback", "Segmentation", "Exception",
+    "SIGSEGV", "core dumped", "Unhandled", "stack overflow", "Bus error",
+    "invalid read", "out of memory", "heap corruption", "CHECK failed",
+    "DCHECK", "FATAL", "Abort", "unreachable",
+};
+
+static char *dfa_patterns[] = { "\001" };
+
+static void run(char const *name, uint8_t const *buf,
+                char **patterns, int npatterns)
+{
+    zzuf_scan_t *sc = zzuf_create_scan(patterns, npatterns);
+    zzuf_scan_state_t st;
+    char *report = NULL;
+
+    zz_scan_reset(&st);
+
+    clock_t t = clock();
+    for (size_t pos = 0; pos < TOTAL; pos += READ)
+        zz_scan_feed(sc, &st, buf + pos, READ, &report);
+    t = clock() - t;
+
+    double secs = (double)t / CLOCKS_PER_SEC;
+    printf("%-8s %8.1f MB/s%s\n", name, secs > 0. ? TOTAL / secs / 1e6 : 0.,
+           report ? " (found a report!)" : "");
+
+    free(report);
+    zzuf_destroy_scan(sc);
+}
+
+int main(int argc, char *argv[])
+{
+    char const *path = argc > 1 ? argv[1] : "file-text";
+    FILE *fp = fopen(path, "rb");
+    if (!fp)
+    {
+        fprintf(stderr, "bench-scan: cannot open `%s'\n", path);
+        return EXIT_FAILURE;
+    }
+
+    uint8_t *buf = malloc(TOTAL);
+    size_t len = fread(buf, 1, TOTAL, fp);
+    fclose(fp);
+    if (len == 0)
+    {
+        fprintf(stderr, "bench-scan: `%s' is empty\n", path);
+        return EXIT_FAILURE;
+    }
+    for (size_t i = len; i < TOTAL; ++i)
+        buf[i] = buf[i % len];
+
+    printf("%i MiB of `%s' in %i-byte reads\n", TOTAL >> 20, path, READ);
+
+    run("builtin", buf, NULL, 0);
+    run("bitmap", buf, bitmap_patterns,
+        (int)(sizeof(bitmap_patterns) / sizeof(*bitmap_patterns)));
+    run("dfa", buf, dfa_patterns, 1);
+
+    free(buf);
+    return EXIT_SUCCESS;
+}
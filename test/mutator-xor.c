@@ -0,0 +1,50 @@
+/*
+ *  mutator-xor - a zzuf mutator plugin that flips random bits
+ *
+ *  Copyright © 2002—2015 Sam Hocevar <sam@hocevar.net>
+ *
+ *  This program is free software. It comes without any warranty, to
+ *  the extent permitted by applicable law. You can redistribute it
+ *  and/or modify it under the terms of the Do What the Fuck You Want
+ *  to Public License, Version 2, as published by the WTFPL Task Force.
+ *  See http://www.wtfpl.net/ for more details.
+ */
+
+/*
+ *  Each byte is changed according to a hash of the seed and its offset,
+ *  so that it gets the same value whatever the reads it comes in.
+ */
+
+#include "config.h"
+
+#if defined HAVE_STDINT_H
+#   include <stdint.h>
+#elif defined HAVE_INTTYPES_H
+#   include <inttypes.h>
+#endif
+#include <stddef.h>
+
+#include "zzuf-mutator.h"
+
+int const zzuf_mutator_version = ZZUF_MUTATOR_VERSION;
+
+void zzuf_mutate(uint32_t seed, int64_t chunk, double ratio,
+                 uint8_t *buf, size_t len, int64_t pos)
+{
+    /* About ratio * 8 bits changed per byte, as in xor mode */
+    uint32_t threshold = ratio >= 0.125 ? 0xffffffff
+                       : (uint32_t)(ratio * 8.0 * 4294967295.0);
+
+    (void)chunk;
+
+    for (size_t i = 0; i < len; ++i)
+    {
+        uint32_t h = seed ^ (uint32_t)(pos + i) * 0x9e3779b9;
+        h = (h ^ (h >> 16)) * 0x85ebca6b;
+        h = (h ^ (h >> 13)) * 0xc2b2ae35;
+        h ^= h >> 16;
+
+        if (h < threshold)
+            buf[i] ^= (uint8_t)(1 << (h & 7));
+    }
+}
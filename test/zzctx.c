@@ -0,0 +1,119 @@
+/*
+ *  zzctx - fuzz standard input from several threads with the ctx API
+ *
+ *  Copyright © 2002—2015 Sam Hocevar <sam@hocevar.net>
+ *
+ *  This program is free software. It comes without any warranty, to
+ *  the extent permitted by applicable law. You can redistribute it
+ *  and/or modify it under the terms of the Do What the Fuck You Want
+ *  to Public License, Version 2, as published by the WTFPL Task Force.
+ *  See http://www.wtfpl.net/ for more details.
+ */
+
+/*
+ *  Usage: zzctx <seed> <ratio> <mode> [<ranges>]
+ *
+ *  Each thread fuzzes its own copy of the data with its own context,
+ *  using reads of a different size. Reads are multiples of 1024 bytes,
+ *  because words and UTF-8 sequences that span two reads are left alone.
+ *  All copies must be the same; the first one is written to standard
+ *  output.
+ */
+
+#include "config.h"
+
+#if defined HAVE_STDINT_H
+#   include <stdint.h>
+#elif defined HAVE_INTTYPES_H
+#   include <inttypes.h>
+#endif
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#if defined HAVE_PTHREAD_H
+#   include <pthread.h>
+#endif
+
+#include "zzufctx.h"
+
+#define THREADS 8
+
+static struct job
+{
+    char **argv;
+    uint8_t *data;
+    size_t len, step;
+}
+jobs[THREADS];
+
+static void *fuzz(void *arg)
+{
+    struct job *job = arg;
+    zzuf_ctx_t *ctx = zzuf_ctx_new();
+
+    zzuf_ctx_set_seed(ctx, (uint32_t)atol(job->argv[1]));
+    zzuf_ctx_set_ratio(ctx, atof(job->argv[2]));
+    zzuf_ctx_set_fuzzing(ctx, job->argv[3]);
+    /* Twice, so that the first ranges get freed */
+    for (int i = 0; i < 2 && job->argv[4]; ++i)
+        zzuf_ctx_set_bytes(ctx, job->argv[4]);
+
+    for (size_t pos = 0; pos < job->len; pos += job->step)
+    {
+        size_t n = job->len - pos < job->step ? job->len - pos : job->step;
+        zzuf_fuzz_buffer(ctx, job->data + pos, n, (int64_t)pos);
+    }
+
+    zzuf_ctx_free(ctx);
+    return NULL;
+}
+
+int main(int argc, char *argv[])
+{
+    uint8_t *data = NULL;
+    size_t len = 0, n;
+
+    if (argc < 4)
+    {
+        fprintf(stderr, "usage: zzctx <seed> <ratio> <mode> [<ranges>]\n");
+        return EXIT_FAILURE;
+    }
+
+    do
+    {
+        data = realloc(data, len + BUFSIZ);
+        n = fread(data + len, 1, BUFSIZ, stdin);
+        len += n;
+    }
+    while (n > 0);
+
+    for (int i = 0; i < THREADS; ++i)
+    {
+        jobs[i].argv = argv;
+        jobs[i].data = malloc(len + 1);
+        memcpy(jobs[i].data, data, len);
+        jobs[i].len = len;
+        jobs[i].step = 1024 * (1 + i);
+    }
+
+#if defined HAVE_PTHREAD_H
+    pthread_t threads[THREADS];
+    for (int i = 0; i < THREADS; ++i)
+        pthread_create(&threads[i], NULL, fuzz, &jobs[i]);
+    for (int i = 0; i < THREADS; ++i)
+        pthread_join(threads[i], NULL);
+#else
+    for (int i = 0; i < THREADS; ++i)
+        fuzz(&jobs[i]);
+#endif
+
+    for (int i = 1; i < THREADS; ++i)
+        if (memcmp(jobs[0].data, jobs[i].data, len))
+        {
+            fprintf(stderr, "zzctx: thread %i differs\n", i);
+            return EXIT_FAILURE;
+        }
+
+    fwrite(jobs[0].data, 1, len, stdout);
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,101 @@
+/*
+ *  zzfuzzer - smoke test for the libFuzzer adapter
+ *
+ *  Copyright © 2002—2015 Sam Hocevar <sam@hocevar.net>
+ *
+ *  This program is free software. It comes without any warranty, to
+ *  the extent permitted by applicable law. You can redistribute it
+ *  and/or modify it under the terms of the Do What the Fuck You Want
+ *  to Public License, Version 2, as published by the WTFPL Task Force.
+ *  See http://www.wtfpl.net/ for more details.
+ */
+
+/*
+ *  Usage: zzfuzzer <seed> [<file>]
+ *
+ *  Calls the custom mutator on standard input the way libFuzzer would,
+ *  or the custom crossover on standard input and <file>, and writes the
+ *  result to standard output. When built with -fsanitize=fuzzer, this is
+ *  a libFuzzer target instead, which does nothing with its inputs.
+ */
+
+#include "config.h"
+
+#if defined HAVE_STDINT_H
+#   include <stdint.h>
+#elif defined HAVE_INTTYPES_H
+#   include <inttypes.h>
+#endif
+#include <stdio.h>
+#include <stdlib.h>
+
+extern int LLVMFuzzerTestOneInput(uint8_t const *data, size_t size);
+extern size_t LLVMFuzzerCustomMutator(uint8_t *data, size_t size,
+                                      size_t maxsize, unsigned int seed);
+extern size_t LLVMFuzzerCustomCrossOver(uint8_t const *data1, size_t size1,
+                                        uint8_t const *data2, size_t size2,
+                                        uint8_t *out, size_t maxoutsize,
+                                        unsigned int seed);
+
+int LLVMFuzzerTestOneInput(uint8_t const *data, size_t size)
+{
+    (void)data;
+    (void)size;
+    return 0;
+}
+
+#if !defined ZZUF_LIBFUZZER
+static uint8_t *load(FILE *fp, size_t *len)
+{
+    uint8_t *data = NULL;
+    size_t n;
+
+    *len = 0;
+    do
+    {
+        data = realloc(data, *len + BUFSIZ);
+        n = fread(data + *len, 1, BUFSIZ, fp);
+        *len += n;
+    }
+    while (n > 0);
+
+    return data;
+}
+
+int main(int argc, char *argv[])
+{
+    uint8_t *data, *other, *out;
+    size_t len, len2;
+    FILE *fp;
+
+    if (argc < 2)
+    {
+        fprintf(stderr, "usage: zzfuzzer <seed> [<file>]\n");
+        return EXIT_FAILURE;
+    }
+
+    unsigned int seed = (unsigned int)atol(argv[1]);
+    data = load(stdin, &len);
+
+    if (argc < 3)
+    {
+        len = LLVMFuzzerCustomMutator(data, len, len, seed);
+        fwrite(data, 1, len, stdout);
+        return EXIT_SUCCESS;
+    }
+
+    fp = fopen(argv[2], "rb");
+    if (!fp)
+    {
+        fprintf(stderr, "zzfuzzer: cannot open `%s'\n", argv[2]);
+        return EXIT_FAILURE;
+    }
+    other = load(fp, &len2);
+    fclose(fp);
+
+    out = malloc(len2 + 1);
+    len = LLVMFuzzerCustomCrossOver(data, len, other, len2, out, len2, seed);
+    fwrite(out, 1, len, stdout);
+    return EXIT_SUCCESS;
+}
+#endif